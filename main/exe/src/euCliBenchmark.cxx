@@ -0,0 +1,295 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/BufferSerializer.hh"
+#include "eudaq/StandardEvent.hh"
+#include "eudaq/RawEvent.hh"
+#include "eudaq/EventPool.hh"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <deque>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+//counts the heap allocations of the whole process; all the forms of the
+//global new and delete are replaced together, so they always pair up
+namespace{
+  std::atomic<uint64_t> g_new_n(0);
+
+  void *CountedAlloc(size_t bytes) noexcept{
+    g_new_n++;
+    return std::malloc(bytes ? bytes : 1);
+  }
+
+#ifdef __cpp_aligned_new
+  void *CountedAlloc(size_t bytes, std::align_val_t al) noexcept{
+    g_new_n++;
+    size_t align = std::max(size_t(al), sizeof(void*));
+    void *p = nullptr;
+    if(posix_memalign(&p, align, bytes ? bytes : 1))
+      return nullptr;
+    return p;
+  }
+#endif
+}
+
+//GCC can not tell that these free() the memory of the malloc() above
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t bytes){
+  void *p = CountedAlloc(bytes);
+  if(!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](size_t bytes){
+  void *p = CountedAlloc(bytes);
+  if(!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new(size_t bytes, const std::nothrow_t&) noexcept{
+  return CountedAlloc(bytes);
+}
+
+void *operator new[](size_t bytes, const std::nothrow_t&) noexcept{
+  return CountedAlloc(bytes);
+}
+
+void operator delete(void *p) noexcept{
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept{
+  std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept{
+  std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept{
+  std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept{
+  std::free(p);
+}
+
+#ifdef __cpp_aligned_new
+void *operator new(size_t bytes, std::align_val_t al){
+  void *p = CountedAlloc(bytes, al);
+  if(!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](size_t bytes, std::align_val_t al){
+  void *p = CountedAlloc(bytes, al);
+  if(!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new(size_t bytes, std::align_val_t al, const std::nothrow_t&) noexcept{
+  return CountedAlloc(bytes, al);
+}
+
+void *operator new[](size_t bytes, std::align_val_t al, const std::nothrow_t&) noexcept{
+  return CountedAlloc(bytes, al);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept{
+  std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept{
+  std::free(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept{
+  std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t&) noexcept{
+  std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t&) noexcept{
+  std::free(p);
+}
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace{
+  eudaq::EventSPC MakeStandardEvent(uint32_t n_planes, uint32_t n_pixels){
+    auto ev = std::make_shared<eudaq::StandardEvent>();
+    for(uint32_t p = 0; p < n_planes; p++){
+      eudaq::StandardPlane plane(p, "Bench", "Bench");
+      plane.SetSizeZS(1152, 576, 0);
+      for(uint32_t i = 0; i < n_pixels; i++)
+	plane.PushPixel((i * 7) % 1152, (i * 13) % 576, 1, uint64_t(i) * 25);
+      ev->AddPlane(plane);
+    }
+    return ev;
+  }
+
+  eudaq::EventSPC MakeRawEvent(uint32_t n_blocks, uint32_t n_bytes){
+    auto ev = std::make_shared<eudaq::RawEvent>();
+    for(uint32_t b = 0; b < n_blocks; b++){
+      std::vector<uint32_t> data(n_bytes / sizeof(uint32_t));
+      for(size_t i = 0; i < data.size(); i++)
+	data[i] = uint32_t(i * 2654435761u);
+      ev->AddBlock(b, data);
+    }
+    return ev;
+  }
+
+  void RoundTrip(const std::string &name, eudaq::EventSPC ev, uint32_t n_loops){
+    uint64_t bytes = 0;
+    uint64_t hash = 14695981039346656037ull;
+    double t_ser = 0;
+    double t_des = 0;
+    for(uint32_t i = 0; i < n_loops; i++){
+      auto tp0 = std::chrono::steady_clock::now();
+      eudaq::BufferSerializer buf;
+      ev->Serialize(buf);
+      auto tp1 = std::chrono::steady_clock::now();
+      uint32_t id;
+      buf.PreRead(id);
+      auto ev_out = eudaq::Factory<eudaq::Event>::Create<eudaq::Deserializer&>(id, buf);
+      auto tp2 = std::chrono::steady_clock::now();
+      if(!ev_out)
+	EUDAQ_THROW("Unable to deserialize "+name);
+      t_ser += std::chrono::duration<double>(tp1 - tp0).count();
+      t_des += std::chrono::duration<double>(tp2 - tp1).count();
+      bytes += buf.size();
+      if(i == 0){
+	//a digest of the serialized bytes, to compare the format between builds
+	for(size_t j = 0; j < buf.size(); j++)
+	  hash = (hash ^ buf[j]) * 1099511628211ull;
+      }
+    }
+    double mb = bytes / 1e6;
+    std::cout<< std::setw(14) << std::left << name
+	     << std::right << std::fixed << std::setprecision(1)
+	     << " size "<< std::setw(9) << bytes / n_loops << " B"
+	     << "  serialize "<< std::setw(8) << mb / t_ser << " MB/s"
+	     << "  deserialize "<< std::setw(8) << mb / t_des << " MB/s"
+	     << "  digest "<< std::hex << hash << std::dec << std::endl;
+  }
+
+  //decodes all the blocks of an event, as a converter does, from copies or in place
+  void BlockAccess(eudaq::EventSPC ev, uint32_t n_loops){
+    uint32_t sum = 0;
+    double t_copy = 0;
+    double t_view = 0;
+    auto block_n_list = ev->GetBlockNumList();
+    for(uint32_t i = 0; i < n_loops; i++){
+      auto tp0 = std::chrono::steady_clock::now();
+      for(auto block_n: block_n_list){
+	std::vector<uint8_t> block = ev->GetBlock(block_n);
+	for(size_t j = 0; j + 4 <= block.size(); j += 4)
+	  sum += eudaq::getlittleendian<uint32_t>(&block[j]);
+      }
+      auto tp1 = std::chrono::steady_clock::now();
+      for(auto block_n: block_n_list){
+	eudaq::BlockView block = ev->GetBlockView(block_n);
+	for(size_t j = 0; j + 4 <= block.size(); j += 4)
+	  sum -= eudaq::getlittleendian<uint32_t>(&block[j]);
+      }
+      auto tp2 = std::chrono::steady_clock::now();
+      t_copy += std::chrono::duration<double>(tp1 - tp0).count();
+      t_view += std::chrono::duration<double>(tp2 - tp1).count();
+    }
+    if(sum)
+      EUDAQ_THROW("The block views differ from the copies");
+    std::cout<< std::setw(14) << std::left << "BlockAccess"
+	     << std::right << std::fixed << std::setprecision(1)
+	     << " GetBlock "<< std::setw(8) << t_copy / n_loops * 1e6 << " us/event"
+	     << "  GetBlockView "<< std::setw(8) << t_view / n_loops * 1e6 << " us/event"
+	     << std::endl;
+  }
+
+  //rebuilds a packet of sub-events and keeps the latest ones alive for a while,
+  //as the queues of a DataCollector do
+  void Allocation(bool pool, uint32_t n_subevs, uint32_t n_blocks, uint32_t n_bytes, uint32_t n_loops){
+    eudaq::EventPool::SetEnabled(pool);
+    auto ev = eudaq::Event::MakeShared("Packet");
+    ev->SetFlagPacket();
+    for(uint32_t i = 0; i < n_subevs; i++){
+      auto subev = eudaq::Event::MakeShared("Bench");
+      auto raw = MakeRawEvent(n_blocks, n_bytes);
+      for(uint32_t b = 0; b < n_blocks; b++){
+	auto block = raw->GetBlockView(b);
+	subev->AddBlock(b, block.data(), block.size());
+      }
+      ev->AddSubEvent(subev);
+    }
+    eudaq::BufferSerializer buf;
+    ev->Serialize(buf);
+    std::vector<uint8_t> bytes(buf.size());
+    for(size_t i = 0; i < buf.size(); i++)
+      bytes[i] = buf[i];
+    std::deque<eudaq::EventSPC> alive;
+    uint64_t new_n = 0;
+    double t = 0;
+    for(uint32_t i = 0; i < n_loops; i++){
+      eudaq::BufferSerializer ser(bytes.begin(), bytes.end());
+      uint64_t new_n0 = g_new_n;
+      auto tp0 = std::chrono::steady_clock::now();
+      uint32_t id;
+      ser.PreRead(id);
+      alive.push_back(eudaq::MakePoolShared(eudaq::Factory<eudaq::Event>::Create<eudaq::Deserializer&>(id, ser)));
+      if(alive.size() > 64)
+	alive.pop_front();
+      t += std::chrono::duration<double>(std::chrono::steady_clock::now() - tp0).count();
+      new_n += g_new_n - new_n0;
+    }
+    alive.clear();
+    eudaq::EventPool::Trim();
+    std::cout<< std::setw(14) << std::left << (pool ? "EventPool" : "Heap")
+	     << std::right << std::fixed << std::setprecision(1)
+	     << " events "<< std::setw(9) << n_loops / t / 1e3 << " kHz"
+	     << "  heap allocations per event "<< std::setw(6) << double(new_n) / n_loops
+	     << std::endl;
+  }
+}
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Command Line Serialization Benchmark", "2.1",
+			 "Time in-memory round-trips of StandardEvent and RawEvent, the access to the blocks and the allocation of events");
+  eudaq::Option<uint32_t> n_loops(op, "n", "loops", 1000, "uint32_t", "number of round-trips");
+  eudaq::Option<uint32_t> n_planes(op, "p", "planes", 6, "uint32_t", "planes per StandardEvent");
+  eudaq::Option<uint32_t> n_pixels(op, "x", "pixels", 1000, "uint32_t", "pixels per plane");
+  eudaq::Option<uint32_t> n_blocks(op, "b", "blocks", 4, "uint32_t", "blocks per RawEvent");
+  eudaq::Option<uint32_t> n_bytes(op, "s", "block-size", 65536, "uint32_t", "bytes per block");
+  eudaq::Option<uint32_t> n_subevs(op, "e", "subevents", 8, "uint32_t", "sub-events per packet in the allocation benchmark");
+  eudaq::Option<uint32_t> n_sub_bytes(op, "a", "subevent-block-size", 256, "uint32_t", "bytes per block of the sub-events");
+  op.Parse(argv);
+  uint32_t loops = n_loops.Value() ? n_loops.Value() : 1;
+  RoundTrip("StandardEvent", MakeStandardEvent(n_planes.Value(), n_pixels.Value()), loops);
+  RoundTrip("RawEvent", MakeRawEvent(n_blocks.Value(), n_bytes.Value()), loops);
+  BlockAccess(MakeRawEvent(n_blocks.Value(), n_bytes.Value()), loops);
+  uint32_t alloc_loops = loops * 100;
+  Allocation(false, n_subevs.Value(), n_blocks.Value(), n_sub_bytes.Value(), alloc_loops);
+  Allocation(true, n_subevs.Value(), n_blocks.Value(), n_sub_bytes.Value(), alloc_loops);
+  return 0;
+}
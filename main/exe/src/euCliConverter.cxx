@@ -3,6 +3,187 @@
 #include "eudaq/FileWriter.hh"
 #include "eudaq/FileReader.hh"
 #include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <exception>
+
+namespace{
+  class ConvertProgress{
+  public:
+    ConvertProgress()
+      :m_n(0), m_tp_start(std::chrono::steady_clock::now()), m_tp_last(m_tp_start){}
+    void Count(){
+      m_n++;
+      auto tp = std::chrono::steady_clock::now();
+      if(tp - m_tp_last >= std::chrono::seconds(1)){
+	m_tp_last = tp;
+	Print("converted");
+      }
+    }
+    void Print(const std::string &what){
+      double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_tp_start).count();
+      std::cout<< what << " "<< m_n << " events in "<< std::fixed << std::setprecision(1)
+	       << dt <<" s ("<< (dt > 0 ? m_n / dt : 0) <<" events/s)"<< std::endl;
+    }
+  private:
+    uint64_t m_n;
+    std::chrono::steady_clock::time_point m_tp_start;
+    std::chrono::steady_clock::time_point m_tp_last;
+  };
+
+  // reading thread -> converting threads -> reorder buffer -> writing in the calling thread
+  // events are passed between the stages in batches
+  class ConvertPipeline{
+  public:
+    ConvertPipeline(eudaq::FileReader &reader, eudaq::FileWriter *writer,
+		    uint32_t n_threads, bool print_ev_in);
+    void Run();
+  private:
+    struct Batch{
+      std::vector<eudaq::EventSPC> evs;
+      std::vector<eudaq::ConvertedEventUP> cvts;
+    };
+    void Reading();
+    void Converting();
+    void SetError();
+    eudaq::FileReader &m_reader;
+    eudaq::FileWriter *m_writer;
+    uint32_t m_n_threads;
+    bool m_print_ev_in;
+    size_t m_batch_size;
+    size_t m_depth;
+    std::mutex m_mtx;
+    std::condition_variable m_cv_in;
+    std::condition_variable m_cv_out;
+    std::condition_variable m_cv_space;
+    std::deque<std::pair<uint64_t, Batch>> m_in;
+    std::map<uint64_t, Batch> m_out;
+    uint64_t m_read_n;
+    uint64_t m_write_n;
+    bool m_read_done;
+    std::exception_ptr m_err;
+  };
+
+  ConvertPipeline::ConvertPipeline(eudaq::FileReader &reader, eudaq::FileWriter *writer,
+				   uint32_t n_threads, bool print_ev_in)
+    :m_reader(reader), m_writer(writer), m_n_threads(n_threads), m_print_ev_in(print_ev_in),
+     m_batch_size(64), m_depth(4 * n_threads), m_read_n(0), m_write_n(0), m_read_done(false){
+  }
+
+  void ConvertPipeline::SetError(){
+    std::unique_lock<std::mutex> lk(m_mtx);
+    if(!m_err)
+      m_err = std::current_exception();
+    m_cv_in.notify_all();
+    m_cv_out.notify_all();
+    m_cv_space.notify_all();
+  }
+
+  void ConvertPipeline::Reading(){
+    try{
+      bool eof = false;
+      while(!eof){
+	Batch batch;
+	batch.evs.reserve(m_batch_size);
+	while(batch.evs.size() < m_batch_size){
+	  auto ev = m_reader.GetNextEvent();
+	  if(!ev){
+	    eof = true;
+	    break;
+	  }
+	  batch.evs.push_back(ev);
+	}
+	std::unique_lock<std::mutex> lk(m_mtx);
+	m_cv_space.wait(lk, [this]{return m_read_n - m_write_n < m_depth || m_err;});
+	if(m_err)
+	  break;
+	if(!batch.evs.empty()){
+	  m_in.emplace_back(m_read_n++, std::move(batch));
+	  m_cv_in.notify_one();
+	}
+      }
+    }
+    catch(...){
+      SetError();
+    }
+    std::unique_lock<std::mutex> lk(m_mtx);
+    m_read_done = true;
+    m_cv_in.notify_all();
+    m_cv_out.notify_all();
+  }
+
+  void ConvertPipeline::Converting(){
+    try{
+      while(1){
+	std::unique_lock<std::mutex> lk(m_mtx);
+	m_cv_in.wait(lk, [this]{return !m_in.empty() || m_read_done || m_err;});
+	if(m_in.empty() || m_err)
+	  break;
+	auto item = std::move(m_in.front());
+	m_in.pop_front();
+	lk.unlock();
+	auto &batch = item.second;
+	batch.cvts.resize(batch.evs.size());
+	if(m_writer)
+	  for(size_t i = 0; i < batch.evs.size(); i++)
+	    batch.cvts[i] = m_writer->ConvertEvent(batch.evs[i]);
+	lk.lock();
+	m_out.emplace(item.first, std::move(batch));
+	if(item.first == m_write_n)
+	  m_cv_out.notify_one();
+      }
+    }
+    catch(...){
+      SetError();
+    }
+  }
+
+  void ConvertPipeline::Run(){
+    ConvertProgress progress;
+    std::vector<std::future<void>> fut_cvt;
+    auto fut_read = std::async(std::launch::async, &ConvertPipeline::Reading, this);
+    for(uint32_t i = 0; i < m_n_threads; i++)
+      fut_cvt.push_back(std::async(std::launch::async, &ConvertPipeline::Converting, this));
+    try{
+      while(1){
+	std::unique_lock<std::mutex> lk(m_mtx);
+	m_cv_out.wait(lk, [this]{return m_out.count(m_write_n) ||
+	      (m_read_done && m_write_n == m_read_n) || m_err;});
+	if(m_err)
+	  std::rethrow_exception(m_err);
+	auto it = m_out.find(m_write_n);
+	if(it == m_out.end())
+	  break;
+	auto batch = std::move(it->second);
+	m_out.erase(it);
+	m_write_n++;
+	m_cv_space.notify_one();
+	lk.unlock();
+	for(size_t i = 0; i < batch.evs.size(); i++){
+	  if(m_print_ev_in)
+	    batch.evs[i]->Print(std::cout);
+	  if(m_writer)
+	    m_writer->WriteConverted(batch.evs[i], std::move(batch.cvts[i]));
+	  progress.Count();
+	}
+      }
+    }
+    catch(...){
+      SetError();
+    }
+    fut_read.get();
+    for(auto &fut: fut_cvt)
+      fut.get();
+    if(m_err)
+      std::rethrow_exception(m_err);
+    progress.Print("done,");
+  }
+}
 
 int main(int /*argc*/, const char **argv) {
   eudaq::OptionParser op("EUDAQ Command Line DataConverter", "2.0", "The Data Converter launcher of EUDAQ");
@@ -10,6 +191,8 @@ int main(int /*argc*/, const char **argv) {
 					"input file");
   eudaq::Option<std::string> file_output(op, "o", "output", "", "string",
 					 "output file");
+  eudaq::Option<uint32_t> n_threads(op, "j", "threads", 1, "uint32_t",
+				    "number of converting threads, with a separate reading thread if more than 1");
   eudaq::OptionFlag iprint(op, "ip", "iprint", "enable print of input Event");
 
   try{
@@ -18,28 +201,34 @@ int main(int /*argc*/, const char **argv) {
   catch (...) {
     return op.HandleMainException();
   }
-  
+
   std::string infile_path = file_input.Value();
   if(infile_path.empty()){
     std::cout<<"option --help to get help"<<std::endl;
     return 1;
   }
-  
+
   std::string outfile_path = file_output.Value();
   std::string type_in = infile_path.substr(infile_path.find_last_of(".")+1);
   std::string type_out = outfile_path.substr(outfile_path.find_last_of(".")+1);
   bool print_ev_in = iprint.Value();
-  
+
   if(type_in=="raw")
     type_in = "native";
   if(type_out=="raw")
     type_out = "native";
-  
+
   eudaq::FileReaderUP reader;
   eudaq::FileWriterUP writer;
   reader = eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type_in), infile_path);
   if(!type_out.empty())
     writer = eudaq::Factory<eudaq::FileWriter>::MakeUnique(eudaq::str2hash(type_out), outfile_path);
+  if(n_threads.Value() > 1){
+    ConvertPipeline pipeline(*reader, writer.get(), n_threads.Value(), print_ev_in);
+    pipeline.Run();
+    return 0;
+  }
+  ConvertProgress progress;
   while(1){
     auto ev = reader->GetNextEvent();
     if(!ev)
@@ -48,6 +237,8 @@ int main(int /*argc*/, const char **argv) {
       ev->Print(std::cout);
     if(writer)
       writer->WriteEvent(ev);
+    progress.Count();
   }
+  progress.Print("done,");
   return 0;
 }
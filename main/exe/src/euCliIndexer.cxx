@@ -0,0 +1,24 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/FileIndex.hh"
+#include <iostream>
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Command Line File Indexer", "2.1",
+			 "Build the event index of a native data file");
+  eudaq::Option<std::string> file_input(op, "i", "input", "", "string", "input file");
+  eudaq::Option<std::string> file_output(op, "o", "output", "", "string",
+					 "index file (default: input file + .idx)");
+  op.Parse(argv);
+  std::string infile_path = file_input.Value();
+  if(infile_path.empty()){
+    std::cout<<"An input file is required (-i)"<<std::endl;
+    return 1;
+  }
+  std::string outfile_path = file_output.Value();
+  if(outfile_path.empty())
+    outfile_path = eudaq::FileIndex::IndexPath(infile_path);
+  auto idx = eudaq::FileIndex::Build(infile_path);
+  idx.Save(outfile_path);
+  std::cout<< "There are "<< idx.Size() << " Events indexed in "<<outfile_path<<std::endl;
+  return 0;
+}
@@ -8,6 +8,7 @@ int main(int /*argc*/, const char **argv) {
   eudaq::OptionParser op("EUDAQ Command Line FileReader modified for TLU", "2.1", "EUDAQ FileReader (TLU)");
   eudaq::Option<std::string> file_input(op, "i", "input", "", "string", "input file");
   eudaq::Option<std::string> file_conf(op, "c", "config", "", "string", "configuration file");
+  eudaq::Option<std::string> reader_type(op, "t", "type", "", "string", "reader type, e.g. mmap (default: from the file extension)");
   eudaq::Option<uint32_t> eventl(op, "e", "event", 0, "uint32_t", "event number low");
   eudaq::Option<uint32_t> eventh(op, "E", "eventhigh", 0, "uint32_t", "event number high");
   eudaq::Option<uint32_t> triggerl(op, "tg", "trigger", 0, "uint32_t", "trigger number low");
@@ -16,12 +17,15 @@ int main(int /*argc*/, const char **argv) {
   eudaq::Option<uint32_t> timestamph(op, "TS", "timestamphigh", 0, "uint32_t", "timestamp high");
   eudaq::OptionFlag stat(op, "s", "statistics", "enable print of statistics");
   eudaq::OptionFlag stdev(op, "std", "stdevent", "enable converter of StdEvent");
+  eudaq::OptionFlag index(op, "x", "index", "jump to the selected events using the index file (.idx)");
 
   op.Parse(argv);
   std::string infile_path = file_input.Value();
   std::string type_in = infile_path.substr(infile_path.find_last_of(".")+1);
   if(type_in=="raw")
     type_in = "native";
+  if(!reader_type.Value().empty())
+    type_in = reader_type.Value();
 
   bool stdev_v = stdev.Value();
 
@@ -56,6 +60,21 @@ int main(int /*argc*/, const char **argv) {
   eudaq::FileReaderUP reader;
   reader = eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type_in), infile_path);
   uint32_t event_count = 0;
+  uint64_t index_count = 0;
+  if(index.Value() && not_all_zero){
+    eudaq::FileIndexSelection sel;
+    sel.event_begin = eventl_v;
+    sel.event_end = eventh_v;
+    sel.trigger_begin = triggerl_v;
+    sel.trigger_end = triggerh_v;
+    sel.ts_begin = timestampl_v;
+    sel.ts_end = timestamph_v;
+    index_count = reader->BuildIndex();
+    if(!reader->SelectEvents(sel)){
+      std::cout<<"WARNING, no index available, reading the whole file"<<std::endl;
+      index_count = 0;
+    }
+  }
 
   while(1){
     auto ev = reader->GetNextEvent();
@@ -104,6 +123,9 @@ int main(int /*argc*/, const char **argv) {
 
     event_count ++;
   }
-  std::cout<< "There are "<< event_count << "Events"<<std::endl;
+  if(index_count)
+    std::cout<< "There are "<< index_count << "Events, "<< event_count << " selected"<<std::endl;
+  else
+    std::cout<< "There are "<< event_count << "Events"<<std::endl;
   return 0;
 }
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include "eudaq/Serializer.hh"
 #include "eudaq/Deserializer.hh"
 #include "eudaq/Exception.hh"
@@ -23,6 +24,7 @@ namespace eudaq {
       m_offset = 0;
     }
     const unsigned char &operator[](size_t i) const { return m_data[i]; }
+    const unsigned char *data() const { return m_data.data(); }
     size_t size() const { return m_data.size(); }
     virtual bool HasData() { return m_data.size() != 0; }
     virtual void Serialize(Serializer &) const;
@@ -34,6 +36,29 @@ namespace eudaq {
     std::vector<unsigned char> m_data;
     size_t m_offset;
   };
+
+  //an event serialized once, shared by the file writer and the senders
+  using BufferSerializerSPC = std::shared_ptr<const BufferSerializer>;
+
+  /** Reads from a buffer without copying it. The buffer is owned by the
+   * caller and has to outlive the deserializer.
+   */
+  class DLLEXPORT BufferDeserializer : public Deserializer {
+  public:
+    BufferDeserializer(const unsigned char *data, size_t size)
+        : m_data(data), m_size(size), m_offset(0) {}
+    virtual bool HasData() { return m_offset < m_size; }
+    size_t GetOffset() const { return m_offset; }
+    //the next n bytes, which are skipped
+    const unsigned char *Take(size_t n);
+
+  private:
+    virtual void Deserialize(unsigned char *data, size_t len);
+    virtual void PreDeserialize(unsigned char *data, size_t len);
+    const unsigned char *m_data;
+    size_t m_size;
+    size_t m_offset;
+  };
 }
 
 #endif // EUDAQ_INCLUDED_BufferSerializer
@@ -0,0 +1,36 @@
+#ifndef EUDAQ_INCLUDED_Compression
+#define EUDAQ_INCLUDED_Compression
+
+#include "eudaq/Platform.hh"
+
+#include <string>
+#include <vector>
+
+namespace eudaq {
+
+  // Codecs of the compressed native file format. The values are stored in the
+  // files, do not change them.
+  enum CompressionCodec : uint32_t {
+    CODEC_NONE = 0,
+    CODEC_LZ4 = 1,
+    CODEC_ZSTD = 2,
+    CODEC_ZLIB = 3
+  };
+
+  //the codec of a name (none, lz4, zstd, zlib), throws if unknown or not compiled in
+  DLLEXPORT CompressionCodec GetCompressionCodec(const std::string &name);
+  DLLEXPORT std::string GetCompressionName(uint32_t codec);
+  DLLEXPORT bool IsCompressionAvailable(uint32_t codec);
+  //the best codec compiled in
+  DLLEXPORT CompressionCodec GetDefaultCompressionCodec();
+
+  //level 0 selects the default level of the codec, lz4 ignores the level
+  DLLEXPORT void CompressBuffer(uint32_t codec, int level,
+                                const std::vector<uint8_t> &in,
+                                std::vector<uint8_t> &out);
+  //out has to be resized to the uncompressed size before
+  DLLEXPORT void DecompressBuffer(uint32_t codec, const uint8_t *in, size_t len,
+                                  std::vector<uint8_t> &out);
+}
+
+#endif // EUDAQ_INCLUDED_Compression
@@ -4,6 +4,7 @@
 #include "eudaq/FileWriter.hh"
 #include "eudaq/DataSender.hh"
 #include "eudaq/DataReceiver.hh"
+#include "eudaq/MonitorSampler.hh"
 #include "eudaq/Event.hh"
 #include "eudaq/Configuration.hh"
 #include "eudaq/Utils.hh"
@@ -15,6 +16,10 @@
 #include <list>
 #include <memory>
 #include <atomic>
+#include <deque>
+#include <mutex>
+#include <future>
+#include <condition_variable>
 
 namespace eudaq {
   class DataCollector;
@@ -28,6 +33,16 @@ namespace eudaq {
 
   using DataCollectorSP = Factory<DataCollector>::SP_BASE;
   
+  /**
+   * With a shard key set by the derived collector and
+   * EUDAQ_DATACOL_BUILD_THREADS > 0, the events are distributed over the
+   * building threads by slices of EUDAQ_DATACOL_BUILD_SLICE consecutive keys.
+   * Each building thread calls DoConnect, DoReceive and DoDisconnect for its
+   * own shard, in the order of arrival, so the collector keeps its building
+   * state per shard, selected by GetShard(). The written events are put
+   * back into the order of the received events which completed them by a
+   * single writing thread.
+   */
   //----------DOC-MARK-----BEG*DEC-----DOC-MARK----------
   class DLLEXPORT DataCollector : public CommandReceiver, public DataReceiver {
   public:
@@ -45,6 +60,19 @@ namespace eudaq {
     virtual void DoReceive(ConnectionSPC id, EventSP ev);
     void WriteEvent(EventSP ev);
     void SetServerAddress(const std::string &addr);
+
+    enum ShardKey{
+      SHARD_NONE,
+      SHARD_TRIGGER,
+      SHARD_EVENT,
+      SHARD_TIMESTAMP
+    };
+    //to be set in the constructor of a collector keeping its state per shard
+    void SetShardKey(ShardKey key);
+    //number of shards, fixed from the configuration until the next one
+    uint32_t GetShardN() const;
+    //shard of the calling building thread, 0 otherwise
+    static uint32_t GetShard();
     static DataCollectorSP Make(const std::string &code_name,
 				const std::string &run_name,
 				const std::string &runcontrol);
@@ -59,17 +87,65 @@ namespace eudaq {
     void OnConnect(ConnectionSPC id) override final;
     void OnDisconnect(ConnectionSPC id) override final;
     void OnReceive(ConnectionSPC id, EventSP ev) override final;
+    struct ShardItem{
+      uint64_t seq;
+      ConnectionSPC con;
+      EventSP ev;
+      bool connect;
+    };
+    struct Shard{
+      std::mutex mx;
+      std::condition_variable cv_not_empty;
+      std::condition_variable cv_not_full;
+      std::deque<ShardItem> in;
+      bool waiting;
+      //seq of the oldest received event not yet done
+      std::atomic<uint64_t> cur;
+      std::deque<std::pair<uint64_t, EventSP>> out;
+      std::future<bool> fut;
+    };
+    //a Monitor the events are forwarded to, with its own sampling
+    struct MonitorLink{
+      std::string name;
+      std::shared_ptr<DataSender> sender;
+      MonitorSampler sampler;
+    };
+    void StoreEvent(EventSP ev);
+    void StartShards();
+    void ConnectShards(ConnectionSPC id, bool connect);
+    void StopShards();
+    void PushShard(uint32_t i, ShardItem &&item);
+    bool AsyncBuilding(uint32_t i);
+    bool AsyncWriting();
+    void WakeWriting();
   private:
     std::string m_data_addr;
     FileWriterSP m_writer;
     std::mutex m_mtx_sender;
-    std::map<std::string, std::shared_ptr<DataSender>> m_senders;
+    std::map<std::string, std::shared_ptr<MonitorLink>> m_monitors;
     std::string m_fwpatt;
     std::string m_fwtype;
     uint32_t m_dct_n;
     uint32_t m_evt_c;
     uint32_t m_fraction;
+    std::string m_mn_sampling;
+    double m_mn_rate;
+    uint32_t m_mn_window_ms;
+    uint32_t m_mn_flags;
+    std::atomic<uint64_t> m_mn_evt_c;
     ConfigurationSPC m_conf;
+    ShardKey m_shard_key;
+    uint32_t m_shard_n;
+    uint64_t m_shard_slice;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::mutex m_mx_shards;
+    std::atomic<uint64_t> m_shard_seq;
+    std::atomic<bool> m_shard_stop;
+    std::mutex m_mx_write;
+    std::condition_variable m_cv_write;
+    std::atomic<bool> m_write_waiting;
+    std::deque<std::pair<uint64_t, EventSP>> m_write_ext;
+    std::future<bool> m_fut_write;
   };
   //----------DOC-MARK-----END*DEC-----DOC-MARK----------
 }
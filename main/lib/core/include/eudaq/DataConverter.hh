@@ -23,6 +23,9 @@ namespace eudaq{
     DataConverter& operator = (const DataConverter &) = delete;
     virtual ~DataConverter(){};
     virtual bool Converting(T1SPC d1, T2SP d2, ConfigurationSPC conf) const = 0;
+    //true if the event may be converted in any thread and in any order,
+    //i.e. the converter keeps no state, also no static one, between events
+    virtual bool IsThreadSafe(T1SPC /*d1*/) const {return false;};
   };
 }
 #endif
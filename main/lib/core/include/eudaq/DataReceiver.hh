@@ -10,15 +10,18 @@
 #include "eudaq/Utils.hh"
 #include "eudaq/Platform.hh"
 #include "eudaq/Factory.hh"
+#include "eudaq/LockFreeQueue.hh"
 
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
+#include <deque>
+#include <cstdio>
 #include <memory>
 #include <atomic>
 #include <future>
 #include <thread>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <type_traits>
@@ -28,8 +31,27 @@ namespace eudaq {
   
   using DataReceiverSP = Factory<DataReceiver>::SP_BASE;
 
+  /**
+   * Receives events from DataSenders and forwards them to OnReceive.
+   * The receiving thread hands events over to the forwarding thread through
+   * a bounded lock-free queue, whose size is applied at the next Listen.
+   * When the queue is full, the overflow policy decides whether the
+   * receiving thread blocks (back pressure to the senders), drops the
+   * incoming event (BORE and EORE are never dropped), or spills the events
+   * to a temporary file until the forwarding thread has caught up.
+   * With deserializing threads enabled, the receiving thread only queues
+   * the raw packets; the events are rebuilt by a pool of workers and put
+   * back into the order of arrival of each connection before forwarding.
+   * A DataSender which asked for packing in the handshake sends several
+   * events per packet; they are unpacked together and queued one by one.
+   */
   class DLLEXPORT DataReceiver{
   public:
+    enum OverflowPolicy {
+      POLICY_BLOCK,
+      POLICY_LOSSY,
+      POLICY_SPILL
+    };
     DataReceiver();
     virtual ~DataReceiver();
     virtual void OnConnect(ConnectionSPC id);
@@ -37,26 +59,107 @@ namespace eudaq {
     virtual void OnReceive(ConnectionSPC id, EventSP ev);
     std::string Listen(const std::string &addr);
     void StopListen();//TODO: remove this method later
+    void SetQueueSize(size_t n);
+    void SetOverflowPolicy(OverflowPolicy policy);
+    void SetOverflowPolicy(const std::string &policy);
+    void SetDeserializeThreads(size_t n);
+    //events per second advertised to the senders, 0 for all of them
+    void SetTargetRate(double hz);
+    //applied at the next Listen
+    void SetSocketOptions(const SocketOptions &opt);
+    //name of connection -> (queued events, high-water mark)
+    std::map<std::string, std::pair<uint64_t, uint64_t>> GetQueueOccupancy();
+    uint64_t GetQueueDroppedN() const;
+    uint64_t GetQueueSpilledN() const;
+    //name of connection -> (received bytes, sent bytes)
+    std::map<std::string, std::pair<uint64_t, uint64_t>> GetConnectionBytes();
   private:
+    struct QueueStat;
+    struct QueueItem{
+      EventSP ev;
+      ConnectionSPC con;
+      std::shared_ptr<QueueStat> stat;
+    };
+    struct RawItem{
+      std::string packet;
+      ConnectionSPC con;
+      std::shared_ptr<QueueStat> stat;
+      uint64_t seq;
+    };
+    struct QueueStat{
+      std::string name;
+      ConnectionSPC con;
+      bool packed;
+      std::atomic<uint64_t> n;
+      std::atomic<uint64_t> hw;
+      uint64_t seq_in;
+      std::atomic<uint64_t> seq_out;
+      std::mutex mx;
+      std::map<uint64_t, std::vector<QueueItem>> pending;
+    };
+    struct SpillItem{
+      ConnectionSPC con;
+      std::shared_ptr<QueueStat> stat;
+      uint64_t offset;
+      uint32_t size;
+    };
     void DataHandler(TransportEvent &ev);
     bool Deamon();
     bool AsyncReceiving();
     bool AsyncForwarding();
+    bool AsyncDeserializing();
+    static EventSP DeserializeEvent(const unsigned char *data, size_t size);
+    static size_t GetPacketEventN(const std::string &packet, bool packed);
+    static void DeserializePacket(const std::string &packet, bool packed,
+				  std::vector<EventSP> &evs);
+    void QueuePacket(ConnectionSPC con, std::string &&packet);
+    bool PopPacket(RawItem &raw);
+    void CommitEvents(uint64_t seq, std::vector<QueueItem> &items);
+    void PushEvent(QueueItem &item);
+    bool PopEvent(QueueItem &item);
+    void SpillEvent(QueueItem &item);
+    bool UnspillEvent(QueueItem &item);
+    size_t ClearQueue();
     
   private:
     std::unique_ptr<TransportServer> m_dataserver;
+    SocketOptions m_sockopt;
     std::string m_last_addr;
     std::vector<ConnectionSP> m_vt_con;
     bool m_is_destructing;
     bool m_is_listening;
-    bool m_is_async_rcv_return;
+    std::atomic<bool> m_is_async_rcv_return;
     std::future<bool> m_fut_async_rcv;
     std::future<bool> m_fut_async_fwd;
+    std::vector<std::future<bool>> m_fut_async_dsr;
     std::future<bool> m_fut_deamon;
     std::mutex m_mx_qu_ev;
     std::mutex m_mx_deamon;
-    std::queue<std::pair<EventSP, ConnectionSPC>> m_qu_ev;
+    std::unique_ptr<LockFreeQueue<QueueItem>> m_qu_ev;
+    size_t m_qu_size;
+    OverflowPolicy m_policy;
+    std::atomic<bool> m_fwd_waiting;
+    std::atomic<int> m_rcv_waiting;
     std::condition_variable m_cv_not_empty;
+    std::condition_variable m_cv_not_full;
+    std::mutex m_mx_qu_stat;
+    std::map<const ConnectionInfo*, std::shared_ptr<QueueStat>> m_qu_stat;
+    std::atomic<uint64_t> m_dropped_n;
+    std::atomic<uint64_t> m_spilled_n;
+    std::mutex m_mx_spill;
+    std::FILE *m_spill_file;
+    std::deque<SpillItem> m_spill;
+    std::atomic<size_t> m_spill_n;
+    uint64_t m_spill_offset;
+    size_t m_dsr_n;
+    std::atomic<double> m_target_rate;
+    std::atomic<size_t> m_dsr_running;
+    std::atomic<int> m_dsr_waiting;
+    std::atomic<bool> m_raw_waiting;
+    std::mutex m_mx_qu_raw;
+    std::unique_ptr<LockFreeQueue<RawItem>> m_qu_raw;
+    std::condition_variable m_cv_raw_not_empty;
+    std::condition_variable m_cv_raw_not_full;
   };
   //----------DOC-MARK-----END*DEC-----DOC-MARK----------
 }
@@ -4,33 +4,99 @@
 
 #include "eudaq/Platform.hh"
 #include "eudaq/Event.hh"
+#include "eudaq/TransportBase.hh"
+#include "eudaq/BufferSerializer.hh"
 #include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
 #include <future>
 #include <thread>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <exception>
 
 namespace eudaq {
 
 class TransportClient;
 
+  /**
+   * Sends events to a DataReceiver (DataCollector or Monitor).
+   * In asynchronous mode (the default), SendEvent only puts the event into a
+   * bounded ring buffer; serialisation and socket writes are done by a
+   * dedicated thread, which sends all queued events (up to the batch size)
+   * in one go. The event must not be modified after it has been sent.
+   * When the ring buffer is full, the overflow policy decides whether the
+   * caller blocks, or the oldest/newest event is dropped. BORE and EORE
+   * events are never dropped.
+   * With packing, and if the DataReceiver supports it, up to n queued events
+   * are sent in a single packet; the sending thread may wait up to the
+   * given time for the packet to fill.
+   * An event may come with its serialization, made once by the caller and
+   * shared with other consumers; it is then sent as it is.
+   * A DataReceiver may advertise the event rate it wants to receive when
+   * connecting, see GetTargetRate.
+   */
   class DLLEXPORT DataSender {
   public:
+      enum OverflowPolicy {
+	POLICY_BLOCK,
+	POLICY_DROP_OLDEST,
+	POLICY_DROP_NEWEST
+      };
       DataSender(const std::string & type, const std::string & name);
       ~DataSender();
+      void SetAsync(bool async);
+      void SetQueueSize(size_t n);
+      void SetBatchSize(size_t n);
+      void SetPacking(size_t n, std::chrono::microseconds linger);
+      void SetSocketOptions(const SocketOptions &opt);
+      void SetOverflowPolicy(OverflowPolicy policy);
+      void SetOverflowPolicy(const std::string & policy);
       void Connect(const std::string & server);
-      void SendEvent(EventSPC ev);
+      void SendEvent(EventSPC ev, BufferSerializerSPC ser = nullptr);
+      //waits until all the queued events have been sent
+      void Flush();
+
+      size_t GetQueueDepth();
+      size_t GetQueueSize() const;
+      //events per second asked by the DataReceiver, 0 if it did not ask
+      double GetTargetRate() const;
+      uint64_t GetDroppedN() const;
+      uint64_t GetBytesSent() const;
+      double GetByteRate();
   private:
+      struct QueuedEvent{
+	EventSPC ev;
+	BufferSerializerSPC ser;
+      };
       bool AsyncSending();
+      void CheckAsyncSending();
       std::string m_type, m_name;
       std::unique_ptr<TransportClient> m_dataclient;
       uint64_t m_packetCounter;
       std::future<bool> m_fut_async;
-      bool m_is_connected;
-      std::mutex m_mx_qu_ev; 
-      std::queue<EventSPC> m_qu_ev;
+      std::exception_ptr m_failure;
+      std::atomic<bool> m_is_connected;
+      bool m_async;
+      size_t m_batch;
+      size_t m_pack_n;
+      std::chrono::microseconds m_pack_linger;
+      bool m_packed;
+      double m_target_rate;
+      SocketOptions m_sockopt;
+      OverflowPolicy m_policy;
+      std::mutex m_mx_qu_ev;
+      std::vector<QueuedEvent> m_ring;
+      size_t m_ring_head;
+      size_t m_ring_n;
+      bool m_busy;
       std::condition_variable m_cv_not_empty;
+      std::condition_variable m_cv_not_full;
+      std::atomic<uint64_t> m_dropped_n;
+      std::atomic<uint64_t> m_bytes_sent;
+      uint64_t m_bytes_last;
+      std::chrono::steady_clock::time_point m_tp_last;
   };
 
 }
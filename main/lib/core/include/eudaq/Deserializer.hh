@@ -9,6 +9,9 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <cstring>
+#include <type_traits>
 
 namespace eudaq{
   class DLLEXPORT Deserializer {
@@ -35,11 +38,27 @@ namespace eudaq{
     void read(unsigned char *dst, size_t size);
     void PreRead(uint32_t &t);
     void PreRead(uint8_t *dst, size_t size);
+    //number of bytes which can be looked at in place from the current
+    //position, data points to them; 0 if they are not held in memory
+    virtual size_t PeekSpan(const uint8_t *&data);
+    //keeps the bytes of PeekSpan alive after the read, so they may be
+    //referenced in place; nullptr if they are valid during the read only
+    virtual std::shared_ptr<const void> GetSpanOwner();
+    //moves past bytes which are not needed
+    virtual void Skip(size_t size);
   protected:
     bool m_interrupting;
 
   private:
     template <typename T> friend struct ReadHelper;
+    template <typename T>
+    void read_elements(std::vector<T> &t, size_t len, std::true_type);
+    template <typename T>
+    void read_elements(std::vector<T> &t, size_t len, std::false_type);
+    template <typename T, typename U>
+    void read_elements(std::map<T, U> &t, size_t len, std::true_type);
+    template <typename T, typename U>
+    void read_elements(std::map<T, U> &t, size_t len, std::false_type);
     virtual void Deserialize(unsigned char *, size_t) = 0;
     virtual void PreDeserialize(unsigned char *, size_t) = 0;
   };
@@ -71,6 +90,10 @@ namespace eudaq{
       // behaviour in bit shift below
       static_assert(sizeof(T) > 1, "Called read_int() in Serializer.hh which "
                                    "only supports integers of size > 1 byte!");
+#if EUDAQ_LITTLE_ENDIAN
+      T t;
+      ds.Deserialize(reinterpret_cast<unsigned char *>(&t), sizeof t);
+#else
       unsigned char buf[sizeof(T)];
       ds.Deserialize(buf, sizeof(T));
       T t = 0;
@@ -78,9 +101,15 @@ namespace eudaq{
         t <<= 8;
         t += buf[sizeof t - 1 - i];
       }
+#endif
       return t;
     }
     static float read_float(Deserializer &ds) {
+#if EUDAQ_LITTLE_ENDIAN
+      float f;
+      ds.Deserialize(reinterpret_cast<unsigned char *>(&f), sizeof f);
+      return f;
+#else
       unsigned char buf[sizeof(float)];
       ds.Deserialize(buf, sizeof buf);
       unsigned t = 0;
@@ -89,6 +118,7 @@ namespace eudaq{
         t += buf[sizeof t - 1 - i];
       }
       return *(float *)&t;
+#endif
     }
     static double read_double(Deserializer &ds) {
       union {
@@ -98,12 +128,14 @@ namespace eudaq{
       } u;
       // unsigned char buf[sizeof (double)];
       ds.Deserialize(u.b, sizeof u.b);
+#if !EUDAQ_LITTLE_ENDIAN
       uint64_t t = 0;
       for (size_t i = 0; i < sizeof t; ++i) {
         t <<= 8;
         t += u.b[sizeof t - 1 - i];
       }
       u.i = t;
+#endif
       return u.d;
     }
   };
@@ -130,7 +162,22 @@ namespace eudaq{
   template <typename T> inline void Deserializer::read(std::vector<T> &t) {
     unsigned len = 0;
     read(len);
-    t.reserve(len);
+    read_elements(t, len, IsBulkCopyable<T>());
+  }
+
+  template <typename T>
+  inline void Deserializer::read_elements(std::vector<T> &t, size_t len,
+                                          std::true_type) {
+    size_t n = t.size();
+    t.resize(n + len);
+    if (len)
+      Deserialize(reinterpret_cast<unsigned char *>(&t[n]), len * sizeof(T));
+  }
+
+  template <typename T>
+  inline void Deserializer::read_elements(std::vector<T> &t, size_t len,
+                                          std::false_type) {
+    t.reserve(t.size() + len);
     for (size_t i = 0; i < len; ++i) {
       t.push_back(read<T>());
     }
@@ -151,10 +198,45 @@ namespace eudaq{
     Deserialize(reinterpret_cast<unsigned char *>(&t[0]), len);
   }
 
+  template <> inline void Deserializer::read<bool>(std::vector<bool> &t) {
+    unsigned len = 0;
+    read(len);
+    std::vector<unsigned char> buf(len);
+    if (len)
+      Deserialize(buf.data(), len);
+    t.insert(t.end(), buf.begin(), buf.end());
+  }
+
   template <typename T, typename U>
   inline void Deserializer::read(std::map<T, U> &t) {
     unsigned len = 0;
     read(len);
+    read_elements(t, len, std::integral_constant<bool, IsBulkCopyable<T>::value &&
+                                                           IsBulkCopyable<U>::value>());
+  }
+
+  template <typename T, typename U>
+  inline void Deserializer::read_elements(std::map<T, U> &t, size_t len,
+                                          std::true_type) {
+    // fetch all key/value pairs in one go; they come sorted by key
+    std::vector<unsigned char> buf(len * (sizeof(T) + sizeof(U)));
+    if (len)
+      Deserialize(buf.data(), buf.size());
+    const unsigned char *p = buf.data();
+    for (size_t i = 0; i < len; ++i) {
+      T key;
+      U val;
+      std::memcpy(&key, p, sizeof(T));
+      p += sizeof(T);
+      std::memcpy(&val, p, sizeof(U));
+      p += sizeof(U);
+      t.emplace_hint(t.end(), key, val)->second = val;
+    }
+  }
+
+  template <typename T, typename U>
+  inline void Deserializer::read_elements(std::map<T, U> &t, size_t len,
+                                          std::false_type) {
     for (size_t i = 0; i < len; ++i) {
       auto&& key = read<T>();
       t[key] = read<U>();
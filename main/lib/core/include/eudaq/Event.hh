@@ -13,6 +13,7 @@
 #include "eudaq/Utils.hh"
 #include "eudaq/Platform.hh"
 #include "eudaq/Factory.hh"
+#include "eudaq/EventPool.hh"
 
 namespace eudaq {
   class Event;
@@ -32,6 +33,25 @@ namespace eudaq {
   using EventSP = Factory<Event>::SP_BASE;
   using EventSPC = Factory<Event>::SPC_BASE;
 
+  /** Non-owning view of a data block. It is valid as long as the event is
+   * alive and its blocks are not changed.
+   */
+  class BlockView {
+  public:
+    BlockView() : m_data(nullptr), m_size(0) {}
+    BlockView(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+    const uint8_t *data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const uint8_t *begin() const { return m_data; }
+    const uint8_t *end() const { return m_data + m_size; }
+    const uint8_t &operator[](size_t i) const { return m_data[i]; }
+    std::vector<uint8_t> ToVector() const { return std::vector<uint8_t>(begin(), end()); }
+  private:
+    const uint8_t *m_data;
+    size_t m_size;
+  };
+
   class DLLEXPORT Event : public Serializable{
   public:
     enum Flags {
@@ -48,6 +68,9 @@ namespace eudaq {
     
     Event(Deserializer & ds);
     virtual void Serialize(Serializer &) const;
+    //the events and their derived classes are allocated from the EventPool
+    static void *operator new(size_t bytes);
+    static void operator delete(void *p, size_t bytes) noexcept;
     virtual void Print(std::ostream & os, size_t offset = 0) const;
     
     bool HasTag(const std::string &name) const;
@@ -115,7 +138,10 @@ namespace eudaq {
     uint32_t GetRunNumber()const;
 
     //from RawdataEvent
+    /// Copy of a data block, prefer GetBlockView
     std::vector<uint8_t> GetBlock(uint32_t i) const;
+    /// Data block without copy, empty if the block does not exist
+    BlockView GetBlockView(uint32_t i) const;
     size_t GetNumBlock() const;
     size_t NumBlocks() const;
     std::vector<uint32_t> GetBlockNumList() const;
@@ -123,22 +149,20 @@ namespace eudaq {
     /// Add a data block as std::vector
     template <typename T>
     size_t AddBlock(uint32_t id, const std::vector<T> &data){
-      m_blocks[id]=make_vector(data);
-      return m_blocks.size();
+      SetBlockBytes(id, reinterpret_cast<const uint8_t *>(data.data()), data.size() * sizeof(T));
+      return m_block_table.size();
     }
 
     /// Add a data block as array with given size
     template <typename T>
     size_t AddBlock(uint32_t id, const T *data, size_t bytes){
-      m_blocks[id]=make_vector(data, bytes);
-      return m_blocks.size();
+      SetBlockBytes(id, reinterpret_cast<const uint8_t *>(data), bytes);
+      return m_block_table.size();
     }
 
     template <typename T>
     void AppendBlock(size_t index, const std::vector<T> &data) {
-      auto &&src = make_vector(data);
-      auto &&dst = m_blocks[index];
-      dst.insert(dst.end(), src.begin(), src.end());
+      AppendBlockBytes(index, reinterpret_cast<const uint8_t *>(data.data()), data.size() * sizeof(T));
     }
 
     //TODO: remove, clearn up
@@ -151,17 +175,26 @@ namespace eudaq {
     }
     
   private:
-    template <typename T>
-      static std::vector<uint8_t> make_vector(const T *data, size_t bytes) {
-      const uint8_t *ptr = reinterpret_cast<const uint8_t *>(data);
-      return std::vector<uint8_t>(ptr, ptr + bytes);
-    }
-
-    template <typename T>
-    static std::vector<uint8_t> make_vector(const std::vector<T> &data) {
-      const uint8_t *ptr = reinterpret_cast<const uint8_t *>(&data[0]);
-      return std::vector<uint8_t>(ptr, ptr + data.size() * sizeof(T));
-    }
+    //the blocks are stored one after the other in a single buffer, with a
+    //table of their positions ordered by id. An event read from memory
+    //which outlives it (a mapped file) references its blocks there instead,
+    //they are copied into the buffer when they are changed
+    struct BlockEntry{
+      uint32_t id;
+      uint32_t size;
+      size_t offset;
+    };
+    using BlockData = std::vector<uint8_t, PoolAllocator<uint8_t>>;
+    using BlockTable = std::vector<BlockEntry, PoolAllocator<BlockEntry>>;
+
+    BlockTable::iterator FindBlock(uint32_t id);
+    BlockTable::const_iterator FindBlock(uint32_t id) const;
+    uint8_t *ReserveBlock(uint32_t id, size_t bytes);
+    void SetBlockBytes(uint32_t id, const uint8_t *data, size_t bytes);
+    void AppendBlockBytes(uint32_t id, const uint8_t *data, size_t bytes);
+    void CompactBlocks();
+    void DetachBlocks();
+    const uint8_t *BlockBase() const {return m_block_ext ? m_block_ext : m_block_data.data();}
     
   private:
     uint32_t m_type;
@@ -176,8 +209,12 @@ namespace eudaq {
     uint64_t m_ts_end;
     std::string m_dspt;
     std::map<std::string, std::string> m_tags;
-    std::map<uint32_t, std::vector<uint8_t>> m_blocks;
-    std::vector<EventSPC> m_sub_events;
+    BlockData m_block_data;
+    BlockTable m_block_table;
+    size_t m_block_unused; //bytes of the replaced blocks left in the buffer
+    const uint8_t *m_block_ext; //base of the offsets if the blocks are not in the buffer
+    std::shared_ptr<const void> m_block_owner; //keeps the memory of m_block_ext
+    std::vector<EventSPC, PoolAllocator<EventSPC>> m_sub_events;
   };
 }
 
@@ -0,0 +1,73 @@
+#ifndef EUDAQ_INCLUDED_EventPool
+#define EUDAQ_INCLUDED_EventPool
+
+#include "eudaq/Platform.hh"
+
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace eudaq {
+
+  /** Recycles the memory of the events, their data blocks and the control
+   * blocks of their shared pointers.
+   * The requests are rounded up to size classes of powers of two. Each thread
+   * keeps the released memory of each class in a small cache, which is
+   * exchanged in batches with a shared list under a lock, so the events built
+   * in one thread and released in another are recycled as well. Large
+   * requests go straight to the heap. The shared lists are freed by Trim(),
+   * at the end of each run.
+   */
+  class DLLEXPORT EventPool {
+  public:
+    struct Stat{
+      uint64_t alloc_n; // requests
+      uint64_t heap_n;  // requests not served from the pool
+      uint64_t cached_bytes;
+    };
+    static void *Allocate(size_t bytes);
+    static void Release(void *p, size_t bytes) noexcept;
+    //disabled, the memory is taken from and returned to the heap every time
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+    static void Trim();
+    static Stat GetStat();
+  };
+
+  template <typename T> class PoolAllocator {
+  public:
+    using value_type = T;
+    PoolAllocator() noexcept {}
+    template <typename U> PoolAllocator(const PoolAllocator<U> &) noexcept {}
+    T *allocate(size_t n) {
+      return static_cast<T *>(EventPool::Allocate(n * sizeof(T)));
+    }
+    void deallocate(T *p, size_t n) noexcept {
+      EventPool::Release(p, n * sizeof(T));
+    }
+    //default-initialised, resized data blocks are not zeroed before being filled
+    template <typename U> void construct(U *p) {
+      ::new (static_cast<void *>(p)) U;
+    }
+    template <typename U, typename... ARGS> void construct(U *p, ARGS &&... args) {
+      ::new (static_cast<void *>(p)) U(std::forward<ARGS>(args)...);
+    }
+  };
+
+  template <typename T, typename U>
+  bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &) {return true;}
+  template <typename T, typename U>
+  bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &) {return false;}
+
+  //shares an object of a factory, with the control block from the pool
+  template <typename T, typename D>
+  std::shared_ptr<T> MakePoolShared(std::unique_ptr<T, D> &&up) {
+    if (!up)
+      return nullptr;
+    D d = up.get_deleter();
+    return std::shared_ptr<T>(up.release(), std::move(d), PoolAllocator<T>());
+  }
+}
+
+#endif // EUDAQ_INCLUDED_EventPool
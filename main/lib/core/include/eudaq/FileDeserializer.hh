@@ -17,6 +17,9 @@ namespace eudaq{
     ~FileDeserializer();
     virtual bool HasData();
     bool ReadEvent(int ver, EventSP &ev, size_t skip = 0);
+    //byte offset in the file of the next read
+    uint64_t Tell();
+    void Seek(uint64_t offset);
     
   private:
     virtual void Deserialize(uint8_t *data, size_t len);
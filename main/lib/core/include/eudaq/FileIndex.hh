@@ -0,0 +1,66 @@
+#ifndef EUDAQ_INCLUDED_FileIndex
+#define EUDAQ_INCLUDED_FileIndex
+
+#include "eudaq/Platform.hh"
+#include "eudaq/Event.hh"
+#include "eudaq/Serializer.hh"
+
+#include <string>
+#include <vector>
+
+namespace eudaq {
+
+  struct FileIndexEntry{
+    uint64_t offset;
+    uint32_t event_n;
+    uint32_t trigger_n;
+    uint32_t stream_n;
+    uint64_t ts_begin;
+    uint64_t ts_end;
+  };
+
+  /** Ranges of events to be read, as in euCliReader.
+   * Event and trigger numbers are selected in [begin, end), timestamps by
+   * TimestampBegin >= ts_begin and TimestampEnd <= ts_end. A pair of zeros
+   * means no limit.
+   */
+  struct DLLEXPORT FileIndexSelection{
+    FileIndexSelection();
+    bool Contains(const FileIndexEntry &e) const;
+    uint32_t event_begin;
+    uint32_t event_end;
+    uint32_t trigger_begin;
+    uint32_t trigger_end;
+    uint64_t ts_begin;
+    uint64_t ts_end;
+  };
+
+  /** Byte offset and identifiers of each event in a native data file.
+   * It is stored next to the data file (IndexPath) as a small header
+   * followed by one fixed-size little-endian record per event, so that it
+   * can be appended while the data file is written.
+   */
+  class DLLEXPORT FileIndex{
+  public:
+    static std::string IndexPath(const std::string &datafile);
+    static FileIndex Build(const std::string &datafile);
+    static void WriteHeader(Serializer &ser);
+    static void WriteEntry(Serializer &ser, const FileIndexEntry &e);
+    static FileIndexEntry MakeEntry(uint64_t offset, const Event &ev);
+
+    bool Load(const std::string &path);
+    void Save(const std::string &path) const;
+    void Add(const FileIndexEntry &e);
+    size_t Size() const;
+    const FileIndexEntry &At(size_t i) const;
+    //positions of the selected events, in file order
+    std::vector<size_t> Select(const FileIndexSelection &sel) const;
+  private:
+    std::vector<FileIndexEntry> m_entries;
+    mutable std::vector<size_t> m_by_event;
+    mutable std::vector<size_t> m_by_trigger;
+    mutable std::vector<size_t> m_by_ts;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_FileIndex
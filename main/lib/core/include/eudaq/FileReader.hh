@@ -6,6 +6,7 @@
 #include "eudaq/Configuration.hh"
 #include "eudaq/Factory.hh"
 #include "eudaq/Event.hh"
+#include "eudaq/FileIndex.hh"
 
 
 namespace eudaq{
@@ -30,6 +31,13 @@ namespace eudaq{
     void SetConfiguration(ConfigurationSPC c) {m_conf = c;};
     ConfigurationSPC GetConfiguration() const {return m_conf;};
     virtual EventSPC GetNextEvent() {return nullptr;};
+    //number of events found, 0 if the reader can not be indexed
+    virtual uint64_t BuildIndex() {return 0;};
+    //position the reader on the index-th event, once the index is built
+    virtual bool SeekEvent(uint64_t /*index*/) {return false;};
+    //only the selected events are returned by GetNextEvent from now on,
+    //false if the reader has no index to jump to them
+    virtual bool SelectEvents(const FileIndexSelection &/*sel*/) {return false;};
     static FileReaderSP Make(std::string type, std::string path);
   private:
     ConfigurationSPC m_conf;
@@ -4,6 +4,7 @@
 #include "eudaq/Factory.hh"
 #include "eudaq/Event.hh"
 #include "eudaq/Configuration.hh"
+#include "eudaq/BufferSerializer.hh"
 
 #include <vector>
 #include <string>
@@ -26,6 +27,13 @@ namespace eudaq {
   using FileWriterUP = Factory<FileWriter>::UP_BASE;
   using FileWriterSP = Factory<FileWriter>::SP_BASE;
 
+  //an event converted to the output format of a FileWriter
+  class DLLEXPORT ConvertedEvent {
+  public:
+    virtual ~ConvertedEvent() {}
+  };
+  using ConvertedEventUP = std::unique_ptr<ConvertedEvent>;
+
   //----------DOC-MARK-----BEG*DEC-----DOC-MARK----------
   class DLLEXPORT FileWriter {
   public:
@@ -34,7 +42,23 @@ namespace eudaq {
     void SetConfiguration(ConfigurationSPC c) {m_conf = c;};
     ConfigurationSPC GetConfiguration() const {return m_conf;};
     virtual void WriteEvent(EventSPC ) {};
+    //conversion stage of WriteEvent, may be called from several threads at once
+    //nullptr if the writer has no separate conversion stage, or if the
+    //converters of this event are not thread safe
+    virtual ConvertedEventUP ConvertEvent(EventSPC ) const {return nullptr;};
+    //writes an event with the result of ConvertEvent, in the original order
+    virtual void WriteConverted(EventSPC ev, ConvertedEventUP ) {WriteEvent(ev);};
+    //writes an event with its native serialization, which others may share
+    virtual void WriteSerialized(EventSPC ev, BufferSerializerSPC ) {WriteEvent(ev);};
+    //true if WriteSerialized takes the bytes as they are, without serializing again
+    virtual bool TakesSerialized() const {return false;};
     virtual uint64_t FileBytes() const {return 0;};
+    //duration of the last write to disk in microseconds
+    virtual uint64_t WriteLatency() const {return 0;};
+    //bytes of the current file before compression
+    virtual uint64_t RawBytes() const {return FileBytes();};
+    //time spent compressing the current file in microseconds
+    virtual uint64_t CompressTime() const {return 0;};
     static FileWriterSP Make(std::string type, std::string path);
   private:
     ConfigurationSPC m_conf;
@@ -0,0 +1,96 @@
+#ifndef EUDAQ_INCLUDED_LockFreeQueue
+#define EUDAQ_INCLUDED_LockFreeQueue
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <cstddef>
+
+namespace eudaq {
+
+  /** Bounded lock-free queue for multiple producers and consumers.
+   * Each cell carries a sequence number which tells whether it is ready to
+   * be written or read (D. Vyukov's bounded MPMC queue), so neither side
+   * ever takes a lock. The capacity is rounded up to a power of two.
+   */
+  template <typename T> class LockFreeQueue {
+  public:
+    explicit LockFreeQueue(size_t capacity)
+      : m_enq(0), m_deq(0) {
+      size_t n = 2;
+      while (n < capacity)
+        n <<= 1;
+      m_mask = n - 1;
+      m_cells.reset(new Cell[n]);
+      for (size_t i = 0; i < n; ++i)
+        m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+    LockFreeQueue(const LockFreeQueue &) = delete;
+    LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+    bool TryPush(T &&v) {
+      Cell *cell;
+      size_t pos = m_enq.load(std::memory_order_relaxed);
+      for (;;) {
+        cell = &m_cells[pos & m_mask];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+          if (m_enq.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed))
+            break;
+        } else if (dif < 0) {
+          return false; // full
+        } else {
+          pos = m_enq.load(std::memory_order_relaxed);
+        }
+      }
+      cell->data = std::move(v);
+      cell->seq.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool TryPop(T &v) {
+      Cell *cell;
+      size_t pos = m_deq.load(std::memory_order_relaxed);
+      for (;;) {
+        cell = &m_cells[pos & m_mask];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (dif == 0) {
+          if (m_deq.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed))
+            break;
+        } else if (dif < 0) {
+          return false; // empty
+        } else {
+          pos = m_deq.load(std::memory_order_relaxed);
+        }
+      }
+      v = std::move(cell->data);
+      cell->data = T();
+      cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+      return true;
+    }
+
+    /// Number of queued elements, only approximate while in use
+    size_t Size() const {
+      size_t enq = m_enq.load(std::memory_order_relaxed);
+      size_t deq = m_deq.load(std::memory_order_relaxed);
+      return enq > deq ? enq - deq : 0;
+    }
+    size_t Capacity() const { return m_mask + 1; }
+
+  private:
+    struct Cell {
+      std::atomic<size_t> seq;
+      T data;
+    };
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    alignas(64) std::atomic<size_t> m_enq;
+    alignas(64) std::atomic<size_t> m_deq;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_LockFreeQueue
@@ -0,0 +1,74 @@
+#ifndef EUDAQ_INCLUDED_MonitorSampler
+#define EUDAQ_INCLUDED_MonitorSampler
+
+#include "eudaq/Platform.hh"
+#include "eudaq/Event.hh"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdint>
+
+namespace eudaq {
+
+  /** Picks the events a DataCollector forwards to one Monitor.
+   * The fraction policy forwards every n-th event, rate forwards up to the
+   * target rate of the monitor, and reservoir picks that many events at
+   * random in each time window and forwards them at its end (with no rate,
+   * one in n of the events of the previous window). With any policy the
+   * sampling is slowed down while the sending queue to the monitor fills
+   * up, and sped up again once it has drained. BORE, EORE and the events
+   * carrying any of the forwarded flags are always forwarded.
+   */
+  class DLLEXPORT MonitorSampler {
+  public:
+    enum Policy {
+      POLICY_FRACTION,
+      POLICY_RATE,
+      POLICY_RESERVOIR
+    };
+    MonitorSampler();
+    void SetPolicy(Policy policy);
+    void SetPolicy(const std::string &policy);
+    void SetFraction(uint32_t n);
+    //target in events per second, 0 for no limit
+    void SetRate(double hz);
+    void SetWindow(std::chrono::milliseconds window);
+    void SetForwardFlags(uint32_t flags);
+    //true if ev is to be forwarded, load is the occupancy (0 to 1) of the
+    //sending queue; the events picked in an earlier window are put into
+    //picked, to be forwarded before ev
+    bool Sample(EventSPC ev, double load, std::vector<EventSPC> &picked);
+    uint64_t GetSeenN() const;
+    uint64_t GetSentN() const;
+    //forwarded over offered events
+    double GetRatio() const;
+    //factor applied to the sampling because of the load of the monitor
+    double GetScale() const;
+  private:
+    void Adapt(double load, std::chrono::steady_clock::time_point now);
+    void TakeReservoir(std::vector<EventSPC> &picked);
+    Policy m_policy;
+    uint32_t m_fraction;
+    double m_rate;
+    std::chrono::milliseconds m_window;
+    uint32_t m_flags;
+    bool m_started;
+    uint64_t m_count;
+    double m_credit;
+    std::chrono::steady_clock::time_point m_tp_last;
+    std::chrono::steady_clock::time_point m_tp_adapt;
+    std::chrono::steady_clock::time_point m_tp_window;
+    uint64_t m_win_n;
+    uint64_t m_prev_win_n;
+    std::vector<std::pair<uint64_t, EventSPC>> m_reservoir;
+    std::minstd_rand m_rng;
+    std::atomic<double> m_scale;
+    std::atomic<uint64_t> m_seen_n;
+    std::atomic<uint64_t> m_sent_n;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_MonitorSampler
@@ -39,6 +39,16 @@ using std::size_t;
 #endif
 
 
+// The serialized format is little-endian; on such hosts arithmetic data can
+// be copied as a whole.
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || \
+  (defined(__BYTE_ORDER) && __BYTE_ORDER == __LITTLE_ENDIAN) ||               \
+  defined(_WIN32)
+#define EUDAQ_LITTLE_ENDIAN 1
+#else
+#define EUDAQ_LITTLE_ENDIAN 0
+#endif
+
 #include <memory>
 
 #endif // EUDAQ_INCLUDED_Platform
@@ -1,8 +1,18 @@
 #ifndef EUDAQ_INCLUDED_Serializable
 #define EUDAQ_INCLUDED_Serializable
 #include "eudaq/Platform.hh"
+#include <type_traits>
 namespace eudaq {
 
+  // Types stored in memory exactly as they are serialized, so that arrays of
+  // them can be (de)serialized with a single copy.
+  template <typename T> struct IsBulkCopyable
+    : std::integral_constant<bool, EUDAQ_LITTLE_ENDIAN &&
+			     ((std::is_integral<T>::value &&
+			       !std::is_same<T, bool>::value) ||
+			      std::is_same<T, float>::value ||
+			      std::is_same<T, double>::value)> {};
+
   class Serializer;
 
   class DLLEXPORT Serializable {
@@ -10,6 +10,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstring>
+#include <type_traits>
 
 namespace eudaq {
 
@@ -31,6 +33,14 @@ namespace eudaq {
     virtual uint64_t GetCheckSum();
   private:
     template <typename T> friend struct WriteHelper;
+    template <typename T>
+    void write_elements(const std::vector<T> &t, std::true_type);
+    template <typename T>
+    void write_elements(const std::vector<T> &t, std::false_type);
+    template <typename T, typename U>
+    void write_elements(const std::map<T, U> &t, std::true_type);
+    template <typename T, typename U>
+    void write_elements(const std::map<T, U> &t, std::false_type);
     virtual void Serialize(const uint8_t *, size_t) = 0;
   };
 
@@ -62,6 +72,9 @@ namespace eudaq {
     static void write_int(Serializer &sr, const T &v) {
       static_assert(sizeof(v) > 1, "Called write_int() in Serializer.hh which "
                                    "only supports integers of size > 1 byte!");
+#if EUDAQ_LITTLE_ENDIAN
+      sr.Serialize(reinterpret_cast<const uint8_t *>(&v), sizeof v);
+#else
       T t = v;
       uint8_t buf[sizeof v];
       for (size_t i = 0; i < sizeof v; ++i) {
@@ -69,8 +82,12 @@ namespace eudaq {
         t >>= 8;
       }
       sr.Serialize(buf, sizeof v);
+#endif
     }
     static void write_float(Serializer &sr, const float &v) {
+#if EUDAQ_LITTLE_ENDIAN
+      sr.Serialize(reinterpret_cast<const uint8_t *>(&v), sizeof v);
+#else
       unsigned t = *(unsigned *)&v;
       uint8_t buf[sizeof t];
       for (size_t i = 0; i < sizeof t; ++i) {
@@ -78,8 +95,12 @@ namespace eudaq {
         t >>= 8;
       }
       sr.Serialize(buf, sizeof t);
+#endif
     }
     static void write_double(Serializer &sr, const double &v) {
+#if EUDAQ_LITTLE_ENDIAN
+      sr.Serialize(reinterpret_cast<const uint8_t *>(&v), sizeof v);
+#else
       uint64_t t = *(uint64_t *)&v;
       uint8_t buf[sizeof t];
       for (size_t i = 0; i < sizeof t; ++i) {
@@ -87,6 +108,7 @@ namespace eudaq {
         t >>= 8;
       }
       sr.Serialize(buf, sizeof t);
+#endif
     }
   };
 
@@ -107,15 +129,30 @@ namespace eudaq {
   template <> inline void Serializer::write(const std::vector<bool> &t) {
     unsigned len = t.size();
     write(len);
-    for (size_t i = 0; i < len; ++i) {
-      write((uint8_t)t[i]);
-    }
+    // one byte per element
+    std::vector<uint8_t> buf(t.begin(), t.end());
+    if (len)
+      Serialize(buf.data(), len);
   }
 
   template <typename T> inline void Serializer::write(const std::vector<T> &t) {
     unsigned len = t.size();
     write(len);
-    for (size_t i = 0; i < len; ++i) {
+    write_elements(t, IsBulkCopyable<T>());
+  }
+
+  template <typename T>
+  inline void Serializer::write_elements(const std::vector<T> &t,
+                                         std::true_type) {
+    if (!t.empty())
+      Serialize(reinterpret_cast<const uint8_t *>(t.data()),
+                t.size() * sizeof(T));
+  }
+
+  template <typename T>
+  inline void Serializer::write_elements(const std::vector<T> &t,
+                                         std::false_type) {
+    for (size_t i = 0; i < t.size(); ++i) {
       write(t[i]);
     }
   }
@@ -136,6 +173,29 @@ namespace eudaq {
   inline void Serializer::write(const std::map<T, U> &t) {
     unsigned len = (unsigned)t.size();
     write(len);
+    write_elements(t, std::integral_constant<bool, IsBulkCopyable<T>::value &&
+                                                       IsBulkCopyable<U>::value>());
+  }
+
+  template <typename T, typename U>
+  inline void Serializer::write_elements(const std::map<T, U> &t,
+                                         std::true_type) {
+    // pack the key/value pairs, then hand them over in one go
+    std::vector<uint8_t> buf(t.size() * (sizeof(T) + sizeof(U)));
+    uint8_t *p = buf.data();
+    for (auto &e : t) {
+      std::memcpy(p, &e.first, sizeof(T));
+      p += sizeof(T);
+      std::memcpy(p, &e.second, sizeof(U));
+      p += sizeof(U);
+    }
+    if (!buf.empty())
+      Serialize(buf.data(), buf.size());
+  }
+
+  template <typename T, typename U>
+  inline void Serializer::write_elements(const std::map<T, U> &t,
+                                         std::false_type) {
     for (typename std::map<T, U>::const_iterator i = t.begin(); i != t.end();
          ++i) {
       write(i->first);
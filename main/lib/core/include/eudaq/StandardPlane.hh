@@ -9,6 +9,8 @@
 
 #include <vector>
 #include <string>
+#include <map>
+#include <utility>
 
 namespace eudaq {
 
@@ -128,9 +130,26 @@ namespace eudaq {
     void Print(std::ostream &) const;
     void Print(std::ostream &os ,size_t offset) const;
   private:
+    struct Waveform {
+      std::vector<double> data;
+      double x0;
+      double dx;
+    };
     const std::vector<pixel_t> &
       GetFrame(const std::vector<std::vector<pixel_t>> &v, uint32_t f) const;
+    const std::vector<coord_t> &
+      GetView(const std::vector<std::vector<uint32_t>> &v,
+              std::vector<std::vector<coord_t>> &view,
+              std::vector<bool> &valid, uint32_t f) const;
+    // drops the cached views and results once a pixel of the frame changes
+    void InvalidateCache(uint32_t frame);
+    const Waveform *GetWaveformEntry(uint32_t index, uint32_t frame) const;
     void SetupResult() const;
+    void SetupResultXY() const;
+    // frame and index of a pixel of the result
+    std::pair<uint32_t, uint32_t> ResultPixel(uint32_t index) const;
+    void DeserializeLegacy(Deserializer &ds);
+    void DeserializeCompact(Deserializer &ds);
 
     std::string m_type;
     std::string m_sensor;
@@ -143,27 +162,25 @@ namespace eudaq {
     // Timestamp of this plane in picoseconds
     uint64_t m_timestamp{};
     std::vector<std::vector<pixel_t>> m_pix;
-    std::vector<std::vector<std::vector<double>>> m_waveform;
-    std::vector<std::vector<double>> m_waveform_x0;
-    std::vector<std::vector<double>> m_waveform_dx;
-    std::vector<std::vector<coord_t>> m_x, m_y;
+    std::vector<std::vector<uint32_t>> m_x, m_y;
+    // a frame without any pixel timestamp keeps an empty vector
     std::vector<std::vector<uint64_t>> m_time;
     std::vector<std::vector<bool>> m_pivot;
     std::vector<uint32_t> m_mat;
+    // sparse, keyed by frame << 32 | index
+    std::map<uint64_t, Waveform> m_waveform;
 
     mutable const std::vector<pixel_t> *m_result_pix;
-    mutable const std::vector<coord_t> *m_result_x, *m_result_y;
-    mutable const std::vector<uint64_t> *m_result_time;
-    mutable const std::vector<std::vector<double>> *m_result_waveform;
-    mutable const std::vector<double> *m_result_waveform_x0;
-    mutable const std::vector<double> *m_result_waveform_dx;
+    // frame and index of each result pixel, unless they are those of frame 0
+    mutable bool m_result_mapped;
+    mutable std::vector<std::pair<uint32_t, uint32_t>> m_result_ref;
+    mutable bool m_result_xy;
+    mutable std::vector<coord_t> m_result_x, m_result_y;
+    // copies of the coordinates of each frame, made on the first request
+    mutable std::vector<std::vector<coord_t>> m_view_x, m_view_y;
+    mutable std::vector<bool> m_view_x_valid, m_view_y_valid;
 
     mutable std::vector<pixel_t> m_temp_pix;
-    mutable std::vector<coord_t> m_temp_x, m_temp_y;
-    mutable std::vector<uint64_t> m_temp_time;
-    mutable std::vector<std::vector<double>> m_temp_waveform;
-    mutable std::vector<double> m_temp_waveform_x0;
-    mutable std::vector<double> m_temp_waveform_dx;
   };
 
 } // namespace eudaq
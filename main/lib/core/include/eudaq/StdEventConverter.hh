@@ -39,7 +39,17 @@ namespace eudaq{
     StdEventConverter(const StdEventConverter&) = delete;
     StdEventConverter& operator = (const StdEventConverter&) = delete;
     bool Converting(EventSPC d1, StdEventSP d2, ConfigurationSPC conf) const override = 0;
+    //called once after the converter is created for a configuration,
+    //before its first event, e.g. to load calibration files
+    virtual void Initialise(ConfigurationSPC /*conf*/) {};
+    //called once before the converter is destroyed
+    virtual void Terminate() {};
     static bool Convert(EventSPC d1, StdEventSP d2, ConfigurationSPC conf);
+    //the initialised converter of an event type and a configuration,
+    //created once per thread, nullptr if there is none for this type
+    static StdEventConverter *GetConverter(uint32_t id, ConfigurationSPC conf);
+    //terminates the converters of this thread, e.g. when a run is finished
+    static void ClearConverters();
   };
 
 }
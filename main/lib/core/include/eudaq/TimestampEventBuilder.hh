@@ -0,0 +1,120 @@
+#ifndef EUDAQ_INCLUDED_TimestampEventBuilder
+#define EUDAQ_INCLUDED_TimestampEventBuilder
+
+#include "eudaq/Platform.hh"
+#include "eudaq/Event.hh"
+#include "eudaq/Configuration.hh"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <chrono>
+
+namespace eudaq {
+
+  /** Merges the timestamped events of several streams into time slices.
+   * Each stream has to deliver its events ordered by TimestampBegin. The
+   * heads of the stream queues are kept in a min-heap, so the merge costs
+   * O(log N) per event for N streams. A slice is built as soon as every
+   * open stream has an event waiting, or when the streams without one have
+   * been silent longer than the timeout. Events of a stream arriving after
+   * their slice was built are dropped and counted as late.
+   * It is not thread-safe, the caller holds a lock.
+   */
+  class DLLEXPORT TimestampEventBuilder{
+  public:
+    enum WindowPolicy{
+      WINDOW_INTERSECT, // from the earliest begin to the earliest end, one event per stream
+      WINDOW_OVERLAP, // starts at the earliest event, extended by the overlapping ones
+      WINDOW_FIXED,   // fixed slices of the window width
+      WINDOW_TRIGGER  // starts at an event of the trigger stream, its duration or the window width
+    };
+    struct Slice{
+      uint64_t ts_beg;
+      uint64_t ts_end;
+      std::vector<EventSPC> evs;
+    };
+    struct StreamStatus{
+      std::string name;
+      uint64_t received_n;
+      uint64_t built_n;
+      uint64_t late_n;
+      uint64_t queued_n;
+      double rate; // received events per second since the previous call
+    };
+
+    TimestampEventBuilder();
+    static WindowPolicy Str2Policy(const std::string &policy);
+    //adds the status of the streams of one builder to the status merged by name
+    static void MergeStatus(std::map<std::string, StreamStatus> &status,
+                            const std::vector<StreamStatus> &add);
+    //sets the policy, window width, trigger stream and timeout from the EUDAQ_TS_* keys
+    void Configure(const Configuration &conf);
+    void SetPolicy(WindowPolicy policy);
+    void SetWindowWidth(uint64_t width);
+    void SetTriggerStream(const std::string &name);
+    //0 waits for the silent streams forever
+    void SetTimeout(std::chrono::milliseconds timeout);
+
+    //a closed stream of the same name is reopened with its id
+    uint32_t AddStream(const std::string &name);
+    //the queued events of the stream are still built
+    void CloseStream(uint32_t id);
+    void Push(uint32_t id, EventSPC ev);
+    //false if no slice is complete yet
+    bool Pop(Slice &slice);
+    //builds the remaining events without waiting, at the end of a run
+    void Flush();
+    //drops the queued events and the counters, the streams are kept
+    void Reset();
+
+    uint64_t GetDroppedN() const {return m_dropped_n;}
+    std::vector<StreamStatus> GetStreamStatus();
+
+  private:
+    struct Stream{
+      std::string name;
+      std::deque<EventSPC> que;
+      bool closed;
+      std::chrono::steady_clock::time_point tp_last;
+      uint64_t ts_last;
+      uint64_t received_n;
+      uint64_t built_n;
+      uint64_t late_n;
+      uint64_t rate_n;
+      bool sliced;
+      EventSPC carry; // extends beyond the last intersect slice
+    };
+    struct Head{
+      uint64_t ts_beg;
+      uint32_t id;
+      bool operator<(const Head &r) const {return ts_beg > r.ts_beg;}
+    };
+    bool CanMerge();
+    EventSPC PopHead();
+    void AddToSlice(uint32_t id, EventSPC ev);
+    void CloseIntersect();
+
+    WindowPolicy m_policy;
+    uint64_t m_width;
+    std::string m_trigger_name;
+    uint32_t m_trigger_id;
+    std::chrono::milliseconds m_timeout;
+    std::vector<Stream> m_streams;
+    std::vector<Head> m_heap;
+    uint32_t m_starved_n;
+    bool m_late;
+    bool m_flush;
+    bool m_open;
+    Slice m_slice;
+    std::vector<uint32_t> m_slice_ids;
+    std::vector<uint32_t> m_carry_ids;
+    uint64_t m_ts_done;
+    uint64_t m_dropped_n;
+    std::chrono::steady_clock::time_point m_tp_check;
+    std::chrono::steady_clock::time_point m_tp_status;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_TimestampEventBuilder
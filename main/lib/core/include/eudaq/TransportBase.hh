@@ -9,10 +9,14 @@
 #include "eudaq/BufferSerializer.hh"
 #include <string>
 #include <queue>
+#include <vector>
 #include <iosfwd>
 #include <cstring>
 #include <iostream>
 #include <mutex>
+#include <utility>
+#include <atomic>
+#include <cstdint>
 
 namespace eudaq {
 
@@ -26,7 +30,7 @@ namespace eudaq {
     ConnectionInfo& operator = (const ConnectionInfo&) = delete;   
 
     explicit ConnectionInfo(const std::string &name = "")
-        : m_state(0), m_name(name) {}
+        : m_state(0), m_name(name), m_bytes_sent(0), m_bytes_recv(0) {}
     virtual ~ConnectionInfo() {}
     virtual void Print(std::ostream &, size_t offset = 0) const;
     virtual bool Matches(const ConnectionInfo &other) const;
@@ -38,6 +42,11 @@ namespace eudaq {
     std::string GetName() const { return m_name; }
     void SetName(const std::string &name) { m_name = name; }
     virtual std::string GetRemote() const { return ""; }
+    /// Bytes on the wire, framing included, counted by the Transport
+    uint64_t GetBytesSent() const { return m_bytes_sent; }
+    uint64_t GetBytesReceived() const { return m_bytes_recv; }
+    void CountSent(uint64_t n) { m_bytes_sent += n; }
+    void CountReceived(uint64_t n) { m_bytes_recv += n; }
  
     static const ConnectionInfo ALL;
 
@@ -45,6 +54,8 @@ namespace eudaq {
     int m_state;
     std::string m_type;
     std::string m_name;
+    std::atomic<uint64_t> m_bytes_sent;
+    std::atomic<uint64_t> m_bytes_recv;
   };
 
   using Connection = ConnectionInfo;
@@ -57,15 +68,36 @@ namespace eudaq {
     return os;
   }
 
+  /** A packet given to SendPackets, the bytes stay owned by the caller.
+   */
+  struct PacketRef {
+    const unsigned char *data;
+    size_t size;
+  };
+
+  /** Tuning of the sockets of a Transport.
+   * A size of 0 keeps the system default. With cork set, each batch given
+   * to SendPackets leaves in full segments and is flushed at its end.
+   */
+  struct SocketOptions {
+    int sndbuf = 0;
+    int rcvbuf = 0;
+    bool nodelay = false;
+    bool cork = false;
+  };
+
   /** Represents an event such as a connection, or receipt of data on a
    * Transport.
    */
   class DLLEXPORT TransportEvent {
   public:
     enum EventType { CONNECT, DISCONNECT, RECEIVE };
-    TransportEvent(EventType et, ConnectionSP i, const std::string &p = "")
-        : etype(et), id(i), packet(p) {}
-    TransportEvent & operator = (const TransportEvent& rh){etype = rh.etype; id=rh.id;  packet = rh.packet; return *this;};
+    TransportEvent(EventType et, ConnectionSP i, std::string p = "")
+        : etype(et), id(i), packet(std::move(p)) {}
+    TransportEvent(const TransportEvent &) = default;
+    TransportEvent(TransportEvent &&) = default;
+    TransportEvent & operator = (const TransportEvent &) = default;
+    TransportEvent & operator = (TransportEvent &&) = default;
     EventType etype; ///< The type of event
     ConnectionSP id; ///< The id of the connection
     std::string packet; ///< The packet of data in case of a RECEIVE event
@@ -186,6 +218,16 @@ namespace eudaq {
       SendPacket(&t[0], t.size(), inf, duringconnect);
     }
 
+    /** Send several packets in one go.
+     * Each packet is still framed individually, so the remote side sees
+     * exactly the same packets as with repeated calls to SendPacket.
+     * The default implementation just loops over SendPacket, concrete
+     * Transport classes may override it to coalesce the packets into
+     * fewer system calls.
+     */
+    virtual void SendPackets(const std::vector<PacketRef> &packets,
+                             const ConnectionInfo &inf = ConnectionInfo::ALL);
+
     /** Pure virtual function to close a connection.
      * This function should be implemented by the concrete Transport class to
      * close
@@ -206,11 +248,16 @@ namespace eudaq {
                        const ConnectionInfo & = ConnectionInfo::ALL);
     void SetCallback(const TransportCallback &);
     virtual bool IsNull() const { return false; }
+    /** Applied to the open sockets and to those opened later on.
+     * Transports without sockets ignore the options.
+     */
+    virtual void SetSocketOptions(const SocketOptions &opt) { m_sockopt = opt; }
 
   protected:
     std::queue<TransportEvent> m_events; ///< A buffer to queue up events until they are handled
     TransportCallback m_callback; ///< The callback function to invoke on a transport event
     std::recursive_mutex m_mutex;
+    SocketOptions m_sockopt;
   };
 }
 
@@ -0,0 +1,128 @@
+#ifndef EUDAQ_INCLUDED_TransportSHM
+#define EUDAQ_INCLUDED_TransportSHM
+
+#include "eudaq/TransportServer.hh"
+#include "eudaq/TransportClient.hh"
+#include "eudaq/Platform.hh"
+
+#if EUDAQ_PLATFORM_IS(LINUX)
+
+#include <vector>
+#include <string>
+#include <map>
+#include <chrono>
+#include <cstdint>
+
+namespace eudaq {
+  struct ShmRingHeader;
+
+  /** Single producer, single consumer byte ring in the shared segment of a
+   * connection. The packets are framed as on TCP, with a 4 byte length.
+   */
+  struct ShmRing {
+    ShmRingHeader *hdr;
+    unsigned char *data;
+    uint64_t size;
+    int data_efd;  // signalled by the writer when the reader is waiting
+    int space_efd; // signalled by the reader when the writer is waiting
+  };
+
+  /** Connection of the shared-memory transport.
+   * The client creates a memfd segment holding one ring per direction and
+   * four eventfds, and hands them to the server over a unix socket, which
+   * is kept open afterwards only to detect the end of the peer. The
+   * eventfds are only signalled when the other side announced that it is
+   * waiting, so a busy stream does not make any system call.
+   */
+  class ConnectionInfoSHM : public ConnectionInfo {
+  public:
+    ConnectionInfoSHM() = delete;
+    ConnectionInfoSHM(const ConnectionInfoSHM&) = delete;
+    ConnectionInfoSHM& operator = (const ConnectionInfoSHM&) = delete;
+    //takes the ownership of the descriptors, a client sets up the segment
+    ConnectionInfoSHM(int sock, int memfd, const int *efd, bool server,
+		      const std::string &remote);
+    ~ConnectionInfoSHM() override;
+    void Send(const unsigned char *data, size_t len);
+    void Send(const std::vector<PacketRef> &packets);
+    //throws if the peer has corrupted the ring
+    bool NextPacket(std::string &packet);
+    //announces the wait for data, false if some is already there
+    bool Arm();
+    void Disarm();
+    int GetFd() const { return m_sock; }
+    int GetEventFd() const { return m_in.data_efd; }
+    bool Matches(const ConnectionInfo &other) const override;
+    void Print(std::ostream &, size_t) const override;
+    std::string GetRemote() const override { return m_remote; }
+
+  private:
+    void Release();
+    void Put(uint64_t &head, const unsigned char *data, size_t len);
+    void Publish(uint64_t head);
+    void WaitSpace(uint64_t head);
+    int m_sock;
+    int m_efd[4];
+    std::string m_remote;
+    void *m_base;
+    size_t m_base_len;
+    ShmRing m_in;
+    ShmRing m_out;
+    bool m_have_len;
+    size_t m_got;
+    std::string m_packet;
+  };
+
+  /** Transport over shared memory for producers running on the same host
+   * as the data collector (Linux only). The address is shm://name, with
+   * the name of an abstract unix socket used for the rendezvous.
+   */
+  class SHMServer : public TransportServer {
+  public:
+    SHMServer(const std::string &param);
+    ~SHMServer() override;
+    void Close(const ConnectionInfo &id) override;
+    void SendPacket(const unsigned char *data, size_t len,
+		    const ConnectionInfo &id = ConnectionInfo::ALL,
+		    bool duringconnect = false) override;
+    void SendPackets(const std::vector<PacketRef> &packets,
+		     const ConnectionInfo &id = ConnectionInfo::ALL) override;
+    void ProcessEvents(int timeout) override;
+    std::string ConnectionString() const override;
+    std::vector<ConnectionSPC> GetConnections() const  override;
+    static const std::string name;
+  private:
+    void AcceptConnections();
+    //takes over the segment handed by a newly accepted peer
+    void Handshake(int peersock);
+    void ExpireHandshakes();
+    void Drop(int fd);
+    bool ReadConnections();
+    std::map<int, std::shared_ptr<ConnectionInfoSHM>> m_conn;
+    //accepted sockets which have not handed over their segment yet
+    std::map<int, std::chrono::steady_clock::time_point> m_pending;
+    std::vector<int> m_closing;
+    std::string m_name;
+    int m_srvsock;
+    int m_epfd;
+  };
+
+  class SHMClient : public TransportClient {
+  public:
+    SHMClient(const std::string &param);
+    ~SHMClient() override;
+    void SendPacket(const unsigned char *data, size_t len,
+		    const ConnectionInfo &id = ConnectionInfo::ALL,
+		    bool = false) override;
+    void SendPackets(const std::vector<PacketRef> &packets,
+		     const ConnectionInfo &id = ConnectionInfo::ALL) override;
+    void ProcessEvents(int timeout = -1) override;
+    static const std::string name;
+  private:
+    std::shared_ptr<ConnectionInfoSHM> m_buf;
+  };
+}
+
+#endif
+
+#endif // EUDAQ_INCLUDED_TransportSHM
@@ -51,9 +51,12 @@ namespace eudaq {
     void SendPacket(const unsigned char *data, size_t len,
 		    const ConnectionInfo &id = ConnectionInfo::ALL,
 		    bool duringconnect = false) override;
+    void SendPackets(const std::vector<PacketRef> &packets,
+		     const ConnectionInfo &id = ConnectionInfo::ALL) override;
     void ProcessEvents(int timeout) override;
     std::string ConnectionString() const override;
     std::vector<ConnectionSPC> GetConnections() const  override;
+    void SetSocketOptions(const SocketOptions &opt) override;
     static const std::string name;
   private:
     std::vector<std::shared_ptr<ConnectionInfoTCP>> m_conn;
@@ -67,6 +70,83 @@ namespace eudaq {
     std::shared_ptr<ConnectionInfoTCP> GetInfo(SOCKET fd) const;
   };
 
+#if EUDAQ_PLATFORM_IS(LINUX)
+  /** Connection of the EpollServer.
+   * Received bytes are collected in a growable buffer, large packets are
+   * received directly into the string which is handed to the callback.
+   */
+  class ConnectionInfoEpoll : public ConnectionInfo {
+  public:
+    ConnectionInfoEpoll() = delete;
+    ConnectionInfoEpoll(const ConnectionInfoEpoll&) = delete;
+    ConnectionInfoEpoll& operator = (const ConnectionInfoEpoll&) = delete;
+    ConnectionInfoEpoll(SOCKET fd, const std::string &host = "")
+      : ConnectionInfo(""), m_fd(fd), m_host(host), m_rd(0), m_wr(0),
+	m_large(false), m_large_n(0) {}
+    char *RecvBuffer(size_t &len);
+    void Commit(size_t len);
+    bool NextPacket(std::string &packet);
+    SOCKET GetFd() const { return m_fd; }
+    bool Matches(const ConnectionInfo &other) const override;
+    void Print(std::ostream &, size_t) const override;
+    std::string GetRemote() const override { return m_host; }
+
+  private:
+    SOCKET m_fd;
+    std::string m_host;
+    std::vector<char> m_buf;
+    size_t m_rd;
+    size_t m_wr;
+    bool m_large;
+    size_t m_large_n;
+    std::string m_large_packet;
+  };
+
+  /** TCP server using edge-triggered epoll (Linux only).
+   * It is wire compatible with TCPServer and TCPClient, but does not
+   * suffer from the FD_SETSIZE limit and only touches the sockets
+   * which are ready.
+   */
+  class EpollServer : public TransportServer {
+  public:
+    EpollServer(const std::string &param);
+    ~EpollServer() override;
+    void Close(const ConnectionInfo &id) override;
+    void SendPacket(const unsigned char *data, size_t len,
+		    const ConnectionInfo &id = ConnectionInfo::ALL,
+		    bool duringconnect = false) override;
+    void SendPackets(const std::vector<PacketRef> &packets,
+		     const ConnectionInfo &id = ConnectionInfo::ALL) override;
+    void ProcessEvents(int timeout) override;
+    std::string ConnectionString() const override;
+    std::vector<ConnectionSPC> GetConnections() const  override;
+    void SetSocketOptions(const SocketOptions &opt) override;
+    static const std::string name;
+  protected:
+    //listens on a unix domain socket at the path given by param with AF_UNIX
+    EpollServer(const std::string &param, int family);
+    std::string m_path;
+  private:
+    void AcceptConnections();
+    void ReadConnection(std::shared_ptr<ConnectionInfoEpoll> conn);
+    std::map<SOCKET, std::shared_ptr<ConnectionInfoEpoll>> m_conn;
+    int m_port;
+    SOCKET m_srvsock;
+    int m_epfd;
+  };
+
+  /** Unix domain socket server (Linux only), the address is ipc://path.
+   * It keeps the framing of TCP, for the links between the processes of a
+   * single host which do not need the network stack.
+   */
+  class IPCServer : public EpollServer {
+  public:
+    IPCServer(const std::string &param);
+    std::string ConnectionString() const override;
+    static const std::string name;
+  };
+#endif
+
   class TCPClient : public TransportClient {
   public:
     TCPClient(const std::string &param);
@@ -75,15 +155,29 @@ namespace eudaq {
     virtual void SendPacket(const unsigned char *data, size_t len,
                             const ConnectionInfo &id = ConnectionInfo::ALL,
                             bool = false);
+    void SendPackets(const std::vector<PacketRef> &packets,
+		     const ConnectionInfo &id = ConnectionInfo::ALL) override;
     virtual void ProcessEvents(int timeout = -1);
+    void SetSocketOptions(const SocketOptions &opt) override;
     static const std::string name;
+  protected:
+    TCPClient(const std::string &param, int family);
   private:
     void OpenConnection();
     std::string m_server;
     int m_port;
+    int m_family;
     SOCKET m_sock;
     std::shared_ptr<ConnectionInfoTCP> m_buf;
   };
+
+#if EUDAQ_PLATFORM_IS(LINUX)
+  class IPCClient : public TCPClient {
+  public:
+    IPCClient(const std::string &param);
+    static const std::string name;
+  };
+#endif
 }
 
 #endif // EUDAQ_INCLUDED_TransportTCP
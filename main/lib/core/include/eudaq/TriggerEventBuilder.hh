@@ -0,0 +1,132 @@
+#ifndef EUDAQ_INCLUDED_TriggerEventBuilder
+#define EUDAQ_INCLUDED_TriggerEventBuilder
+
+#include "eudaq/Platform.hh"
+#include "eudaq/Event.hh"
+#include "eudaq/Configuration.hh"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <chrono>
+
+namespace eudaq {
+
+  /** Merges the events of several streams by trigger number.
+   * The pending triggers are kept in a ring of the window size, indexed by
+   * the trigger number modulo the window, so an event is inserted and its
+   * trigger checked for completion in O(1). The events are built in trigger
+   * order: the oldest trigger is built as soon as every open stream has
+   * reported it, or given up on when
+   *  - every open stream has reported a trigger more than the reorder depth
+   *    later (with a depth of 0 the streams are assumed to be in order),
+   *  - it waited longer than the timeout, or
+   *  - a trigger beyond the window arrives.
+   * Events of a trigger which was already built are dropped as late.
+   * It is not thread-safe, the caller holds a lock.
+   */
+  class DLLEXPORT TriggerEventBuilder{
+  public:
+    enum IncompletePolicy{
+      INCOMPLETE_PARTIAL, // built from the events available
+      INCOMPLETE_DROP,    // dropped
+      INCOMPLETE_TAG      // built from the events available, to be tagged by the caller
+    };
+    struct Built{
+      uint32_t trigger_n;
+      bool complete;
+      std::vector<EventSPC> evs;
+      //names of the open streams which did not report the trigger
+      std::vector<std::string> missing;
+    };
+    //lag of an event behind the newest trigger, in bins of 0, 1, 2-3, 4-7, ...
+    static const size_t LAG_BINS = 16;
+    struct StreamStatus{
+      std::string name;
+      uint64_t received_n;
+      uint64_t late_n;
+      std::vector<uint64_t> lag;
+    };
+
+    TriggerEventBuilder();
+    static IncompletePolicy Str2Policy(const std::string &policy);
+    static std::string LagBinName(size_t bin);
+    //the non-empty lag bins as "bin:count,..."
+    static std::string FormatLag(const std::vector<uint64_t> &lag);
+    //adds the status of the streams of one builder to the status merged by name
+    static void MergeStatus(std::map<std::string, StreamStatus> &status,
+                            const std::vector<StreamStatus> &add);
+    //sets the window, reorder depth, timeout and policy from the EUDAQ_TG_* keys
+    void Configure(const Configuration &conf);
+    void SetWindow(uint32_t window);
+    void SetReorderDepth(uint32_t depth);
+    //0 waits until the trigger is passed or pushed out of the window
+    void SetTimeout(std::chrono::milliseconds timeout);
+    void SetIncompletePolicy(IncompletePolicy policy);
+    IncompletePolicy GetIncompletePolicy() const {return m_policy;}
+
+    //a closed stream of the same name is reopened with its id
+    uint32_t AddStream(const std::string &name);
+    void CloseStream(uint32_t id);
+    void Push(uint32_t id, uint32_t trigger_n, EventSPC ev);
+    //false if no event is ready yet
+    bool Pop(Built &built);
+    //builds the pending triggers without waiting, at the end of a run
+    void Flush();
+    //drops the pending events and the counters, the streams are kept
+    void Reset();
+
+    uint64_t GetCompleteN() const {return m_complete_n;}
+    uint64_t GetIncompleteN() const {return m_incomplete_n;}
+    uint64_t GetDroppedN() const {return m_dropped_n;}
+    std::vector<StreamStatus> GetStreamStatus() const;
+
+  private:
+    struct Stream{
+      std::string name;
+      bool closed;
+      int64_t seen;
+      uint64_t received_n;
+      uint64_t late_n;
+      std::vector<uint64_t> lag;
+    };
+    struct Slot{
+      bool used;
+      uint32_t trigger_n;
+      uint32_t n;
+      std::chrono::steady_clock::time_point tp_first;
+      std::vector<EventSPC> evs;
+    };
+    struct Seen{
+      int64_t seen;
+      uint32_t id;
+      bool operator<(const Seen &r) const {return seen > r.seen;}
+    };
+    int64_t GetMinSeen();
+    void Advance();
+    void Emit(Slot &slot);
+    void Skip();
+
+    uint32_t m_window;
+    uint32_t m_depth;
+    std::chrono::milliseconds m_timeout;
+    IncompletePolicy m_policy;
+    std::vector<Stream> m_streams;
+    uint32_t m_open_n;
+    std::vector<Seen> m_seen_heap;
+    std::vector<Slot> m_ring;
+    uint32_t m_occupied;
+    uint64_t m_next;
+    uint64_t m_force_until;
+    int64_t m_max_trigger;
+    std::chrono::steady_clock::time_point m_tp_head;
+    bool m_flush;
+    std::deque<Built> m_out;
+    uint64_t m_complete_n;
+    uint64_t m_incomplete_n;
+    uint64_t m_dropped_n;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_TriggerEventBuilder
@@ -1,5 +1,7 @@
 #include "eudaq/BufferSerializer.hh"
 
+#include <cstring>
+
 namespace eudaq {
 
   BufferSerializer::BufferSerializer(Deserializer &des) : m_offset(0) {
@@ -41,5 +43,30 @@ namespace eudaq {
     std::copy(&m_data[m_offset], &m_data[m_offset] + len, data);
   }
 
+  const unsigned char *BufferDeserializer::Take(size_t n) {
+    if (n > m_size - m_offset) {
+      EUDAQ_THROW("Deserialize asked for " + to_string(n) + ", only have " +
+                  to_string(m_size - m_offset));
+    }
+    const unsigned char *p = m_data + m_offset;
+    m_offset += n;
+    return p;
+  }
+
+  void BufferDeserializer::Deserialize(unsigned char *data, size_t len) {
+    if (!len)
+      return;
+    std::memcpy(data, Take(len), len);
+  }
+
+  void BufferDeserializer::PreDeserialize(unsigned char *data, size_t len) {
+    if (!len)
+      return;
+    if (len > m_size - m_offset) {
+      EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
+                  to_string(m_size - m_offset));
+    }
+    std::memcpy(data, m_data + m_offset, len);
+  }
 
 }
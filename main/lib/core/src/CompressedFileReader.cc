@@ -0,0 +1,206 @@
+#include "eudaq/FileDeserializer.hh"
+#include "eudaq/FileReader.hh"
+#include "eudaq/FileIndex.hh"
+#include "eudaq/Compression.hh"
+#include "eudaq/Exception.hh"
+
+#include <cstring>
+#include <vector>
+
+// Holds one decompressed frame of a rawz file and reads its events.
+class FrameDeserializer : public eudaq::Deserializer {
+public:
+  FrameDeserializer() :m_file_offset(0), m_offset(0){}
+  bool HasData() override {return m_offset < m_data.size();}
+  //false at the end of the file
+  bool ReadFrame(eudaq::FileDeserializer &des);
+  uint64_t FileOffset() const {return m_file_offset;}
+  size_t EventN() const {return m_ev_offsets.size();}
+  eudaq::EventUP GetEvent(size_t i);
+private:
+  void Deserialize(uint8_t *data, size_t len) override;
+  void PreDeserialize(uint8_t *data, size_t len) override;
+  uint64_t m_file_offset;
+  std::vector<uint32_t> m_ev_offsets;
+  std::vector<uint8_t> m_comp;
+  std::vector<uint8_t> m_data;
+  size_t m_offset;
+};
+
+class CompressedFileReader : public eudaq::FileReader {
+public:
+  CompressedFileReader(const std::string& filename);
+  eudaq::EventSPC GetNextEvent() override;
+  uint64_t BuildIndex() override;
+  bool SeekEvent(uint64_t index) override;
+  bool SelectEvents(const eudaq::FileIndexSelection &sel) override;
+private:
+  std::unique_ptr<eudaq::FileDeserializer> Open() const;
+  bool SeekFrame(size_t index);
+  std::string m_filename;
+  std::unique_ptr<eudaq::FileDeserializer> m_des;
+  FrameDeserializer m_frame;
+  size_t m_frame_ev;
+  std::unique_ptr<eudaq::FileIndex> m_idx;
+  std::vector<size_t> m_sel;
+  size_t m_sel_n;
+  bool m_has_sel;
+};
+
+namespace{
+  auto dummy0 = eudaq::Factory<eudaq::FileReader>::
+    Register<CompressedFileReader, std::string&>(eudaq::cstr2hash("rawz"));
+  auto dummy1 = eudaq::Factory<eudaq::FileReader>::
+    Register<CompressedFileReader, std::string&&>(eudaq::cstr2hash("rawz"));
+  const char RAWZ_MAGIC[8] = {'E', 'U', 'D', 'A', 'Q', 'R', 'Z', '\0'};
+  const uint32_t RAWZ_VERSION = 1;
+}
+
+bool FrameDeserializer::ReadFrame(eudaq::FileDeserializer &des){
+  m_ev_offsets.clear();
+  m_data.clear();
+  m_offset = 0;
+  if(!des.HasData())
+    return false;
+  m_file_offset = des.Tell();
+  uint32_t codec, n_events, raw_size, comp_size;
+  des.read(codec);
+  des.read(n_events);
+  des.read(raw_size);
+  des.read(comp_size);
+  //each event takes at least its type id
+  if(n_events > raw_size / sizeof(uint32_t))
+    EUDAQ_THROWX(eudaq::FileReadException, "CompressedFileReader: Corrupted frame at byte "
+		 + std::to_string(m_file_offset) + ", too many events");
+  m_ev_offsets.resize(n_events);
+  for(size_t i = 0; i < n_events; i++){
+    des.read(m_ev_offsets[i]);
+    if(m_ev_offsets[i] >= raw_size || (i && m_ev_offsets[i] <= m_ev_offsets[i-1])){
+      m_ev_offsets.clear();
+      EUDAQ_THROWX(eudaq::FileReadException, "CompressedFileReader: Corrupted frame at byte "
+		   + std::to_string(m_file_offset) + ", bad offset of event " + std::to_string(i));
+    }
+  }
+  m_comp.resize(comp_size);
+  if(comp_size)
+    des.read(m_comp.data(), comp_size);
+  m_data.resize(raw_size);
+  eudaq::DecompressBuffer(codec, m_comp.data(), comp_size, m_data);
+  return true;
+}
+
+eudaq::EventUP FrameDeserializer::GetEvent(size_t i){
+  m_offset = m_ev_offsets.at(i);
+  uint32_t id;
+  PreRead(id);
+  auto ev = eudaq::Factory<eudaq::Event>::Create<eudaq::Deserializer&>(id, *this);
+  if(!ev)
+    EUDAQ_THROWX(eudaq::FileReadException, "CompressedFileReader: Unknown event type in frame at byte "
+		 + std::to_string(m_file_offset));
+  return ev;
+}
+
+void FrameDeserializer::Deserialize(uint8_t *data, size_t len){
+  if(len > m_data.size() - m_offset)
+    EUDAQ_THROWX(eudaq::FileReadException, "CompressedFileReader: event exceeds its frame");
+  std::memcpy(data, &m_data[m_offset], len);
+  m_offset += len;
+}
+
+void FrameDeserializer::PreDeserialize(uint8_t *data, size_t len){
+  if(len > m_data.size() - m_offset)
+    EUDAQ_THROWX(eudaq::FileReadException, "CompressedFileReader: event exceeds its frame");
+  std::memcpy(data, &m_data[m_offset], len);
+}
+
+CompressedFileReader::CompressedFileReader(const std::string& filename)
+  :m_filename(filename), m_frame_ev(0), m_sel_n(0), m_has_sel(false){
+}
+
+std::unique_ptr<eudaq::FileDeserializer> CompressedFileReader::Open() const{
+  std::unique_ptr<eudaq::FileDeserializer> des(new eudaq::FileDeserializer(m_filename));
+  char magic[sizeof(RAWZ_MAGIC)] = {0};
+  uint32_t version = 0;
+  if(des->HasData()){
+    des->read(reinterpret_cast<unsigned char*>(magic), sizeof(magic));
+    des->read(version);
+  }
+  if(std::memcmp(magic, RAWZ_MAGIC, sizeof(magic)) != 0)
+    EUDAQ_THROWX(eudaq::FileReadException, "CompressedFileReader: Not a rawz file: " + m_filename);
+  if(version != RAWZ_VERSION)
+    EUDAQ_THROWX(eudaq::FileReadException, "CompressedFileReader: Unsupported rawz version "
+		 + std::to_string(version) + ": " + m_filename);
+  return des;
+}
+
+eudaq::EventSPC CompressedFileReader::GetNextEvent(){
+  if(!m_des)
+    m_des = Open();
+  if(m_has_sel){
+    if(m_sel_n >= m_sel.size())
+      return nullptr;
+    if(!SeekFrame(m_sel[m_sel_n++]))
+      return nullptr;
+  }
+  while(m_frame_ev >= m_frame.EventN()){
+    if(!m_frame.ReadFrame(*m_des))
+      return nullptr;
+    m_frame_ev = 0;
+  }
+  return m_frame.GetEvent(m_frame_ev++);
+}
+
+bool CompressedFileReader::SeekFrame(size_t index){
+  //the events of a frame share the offset of the frame in the index
+  uint64_t offset = m_idx->At(index).offset;
+  size_t first = index;
+  while(first > 0 && m_idx->At(first - 1).offset == offset)
+    first--;
+  if(!m_frame.EventN() || m_frame.FileOffset() != offset){
+    m_des->Seek(offset);
+    if(!m_frame.ReadFrame(*m_des))
+      return false;
+  }
+  if(index - first >= m_frame.EventN())
+    EUDAQ_THROWX(eudaq::FileReadException, "CompressedFileReader: the index does not match "
+		 + m_filename);
+  m_frame_ev = index - first;
+  return true;
+}
+
+uint64_t CompressedFileReader::BuildIndex(){
+  if(!m_idx){
+    m_idx.reset(new eudaq::FileIndex);
+    if(!m_idx->Load(eudaq::FileIndex::IndexPath(m_filename))){
+      auto des = Open();
+      FrameDeserializer frame;
+      while(frame.ReadFrame(*des)){
+	for(size_t i = 0; i < frame.EventN(); i++)
+	  m_idx->Add(eudaq::FileIndex::MakeEntry(frame.FileOffset(), *frame.GetEvent(i)));
+      }
+    }
+  }
+  return m_idx->Size();
+}
+
+bool CompressedFileReader::SeekEvent(uint64_t index){
+  if(!m_idx || index >= m_idx->Size())
+    return false;
+  if(!m_des)
+    m_des = Open();
+  m_has_sel = false;
+  return SeekFrame(index);
+}
+
+bool CompressedFileReader::SelectEvents(const eudaq::FileIndexSelection &sel){
+  if(!m_idx){
+    std::unique_ptr<eudaq::FileIndex> idx(new eudaq::FileIndex);
+    if(!idx->Load(eudaq::FileIndex::IndexPath(m_filename)))
+      return false;
+    m_idx = std::move(idx);
+  }
+  m_sel = m_idx->Select(sel);
+  m_sel_n = 0;
+  m_has_sel = true;
+  return true;
+}
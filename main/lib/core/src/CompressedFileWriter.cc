@@ -0,0 +1,391 @@
+#include "eudaq/FileNamer.hh"
+#include "eudaq/FileWriter.hh"
+#include "eudaq/FileSerializer.hh"
+#include "eudaq/FileIndex.hh"
+#include "eudaq/Compression.hh"
+#include "eudaq/Platform.hh"
+#include "eudaq/Logger.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <vector>
+#if !EUDAQ_PLATFORM_IS(WIN32)
+#include <unistd.h>
+#endif
+
+// The rawz format: a file header followed by frames of whole events,
+//   header: "EUDAQRZ\0", uint32 version
+//   frame:  uint32 codec, uint32 n_events, uint32 raw size, uint32 compressed size,
+//           uint32 offset of each event in the uncompressed data, compressed data
+// The uncompressed data of a frame is the native serialization of its events.
+// All integers are little-endian.
+
+// Serializes into a memory buffer.
+class ChunkSerializer : public eudaq::Serializer {
+public:
+  explicit ChunkSerializer(std::vector<uint8_t> &buf) :m_buf(buf){}
+private:
+  void Serialize(const uint8_t *data, size_t len) override {
+    m_buf.insert(m_buf.end(), data, data + len);
+  }
+  std::vector<uint8_t> &m_buf;
+};
+
+class CompressedFileWriter : public eudaq::FileWriter {
+public:
+  CompressedFileWriter(const std::string &patt);
+  ~CompressedFileWriter() override;
+  void WriteEvent(eudaq::EventSPC ev) override;
+  void WriteSerialized(eudaq::EventSPC ev, eudaq::BufferSerializerSPC ser) override;
+  bool TakesSerialized() const override {return true;};
+  uint64_t FileBytes() const override;
+  uint64_t WriteLatency() const override;
+  uint64_t RawBytes() const override;
+  uint64_t CompressTime() const override;
+private:
+  struct OutFile{
+    ~OutFile();
+    std::string name;
+    std::shared_ptr<std::FILE> fd;
+    std::unique_ptr<eudaq::FileSerializer> idx;
+    uint32_t codec;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> raw_bytes;
+    std::atomic<uint64_t> compress_us;
+  };
+  struct Chunk{
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> comp;
+    std::vector<uint32_t> ev_offsets;
+    std::vector<eudaq::FileIndexEntry> entries;
+    std::shared_ptr<OutFile> file;
+    bool sync;
+    bool done;
+  };
+  void OpenFile(uint32_t run_n);
+  void Write(eudaq::EventSPC ev, const eudaq::BufferSerializer *ser);
+  void QueueChunk(bool sync);
+  void CheckThreads();
+  bool AsyncCompressing();
+  bool AsyncWriting();
+  std::string m_filepattern;
+  uint32_t m_run_n;
+  uint32_t m_codec;
+  int m_level;
+  size_t m_chunk_bytes;
+  size_t m_chunk_events;
+  std::chrono::milliseconds m_flush_ms;
+  size_t m_max_chunks;
+  std::shared_ptr<OutFile> m_file;
+  std::shared_ptr<Chunk> m_chunk;
+  std::chrono::steady_clock::time_point m_tp_chunk;
+  std::atomic<uint64_t> m_latency_us;
+  std::deque<std::shared_ptr<Chunk>> m_qu_chunk; //all chunks in flight, in file order
+  std::deque<std::shared_ptr<Chunk>> m_qu_todo; //chunks waiting for compression
+  std::mutex m_mx;
+  std::condition_variable m_cv;
+  std::vector<std::future<bool>> m_fut_compress;
+  std::future<bool> m_fut_write;
+  bool m_is_running;
+};
+
+namespace{
+  auto dummy0 = eudaq::Factory<eudaq::FileWriter>::
+    Register<CompressedFileWriter, std::string&>(eudaq::cstr2hash("rawz"));
+  auto dummy1 = eudaq::Factory<eudaq::FileWriter>::
+    Register<CompressedFileWriter, std::string&&>(eudaq::cstr2hash("rawz"));
+  const char RAWZ_MAGIC[8] = {'E', 'U', 'D', 'A', 'Q', 'R', 'Z', '\0'};
+  const uint32_t RAWZ_VERSION = 1;
+}
+
+CompressedFileWriter::OutFile::~OutFile(){
+  uint64_t n_raw = raw_bytes;
+  uint64_t n = bytes;
+  if(n_raw && n){
+    EUDAQ_INFO("CompressedFileWriter: " + name + " with " + eudaq::GetCompressionName(codec)
+	       + ", " + std::to_string(n_raw) + " -> " + std::to_string(n) + " bytes"
+	       + ", ratio " + std::to_string(double(n_raw) / n)
+	       + ", " + std::to_string(compress_us / 1000) + " ms compressing");
+  }
+}
+
+CompressedFileWriter::CompressedFileWriter(const std::string &patt)
+  :m_filepattern(patt), m_run_n(0), m_codec(eudaq::CODEC_NONE), m_level(0),
+   m_chunk_bytes(0), m_chunk_events(0), m_flush_ms(0), m_max_chunks(0),
+   m_latency_us(0), m_is_running(false){
+}
+
+CompressedFileWriter::~CompressedFileWriter(){
+  if(m_fut_compress.empty())
+    return;
+  try{
+    std::unique_lock<std::mutex> lk(m_mx);
+    if(m_chunk)
+      QueueChunk(true);
+    m_is_running = false;
+    lk.unlock();
+    m_cv.notify_all();
+    for(auto &fut: m_fut_compress){
+      if(fut.valid())
+	fut.get();
+    }
+    if(m_fut_write.valid())
+      m_fut_write.get();
+  }
+  catch(const std::exception &e){
+    EUDAQ_ERROR(std::string("CompressedFileWriter: ") + e.what());
+  }
+}
+
+void CompressedFileWriter::OpenFile(uint32_t run_n){
+  std::time_t time_now = std::time(nullptr);
+  char time_buff[13];
+  time_buff[12] = 0;
+  std::strftime(time_buff, sizeof(time_buff),
+		"%y%m%d%H%M%S", std::localtime(&time_now));
+  std::string time_str(time_buff);
+  std::string filename = eudaq::FileNamer(m_filepattern).
+    Set('X', ".rawz").
+    Set('R', run_n).
+    Set('D', time_str);
+  auto conf = GetConfiguration();
+
+  std::unique_lock<std::mutex> lk(m_mx);
+  if(m_chunk)
+    QueueChunk(true);
+  std::atomic_store(&m_file, std::shared_ptr<OutFile>());
+  lk.unlock();
+
+  if(m_fut_compress.empty()){
+    //the settings of the first file hold for the whole lifetime of the writer
+    std::string codec = conf ? conf->Get("EUDAQ_FW_CODEC", "") : "";
+    m_codec = codec.empty() ? eudaq::GetDefaultCompressionCodec()
+      : eudaq::GetCompressionCodec(codec);
+    m_level = conf ? conf->Get("EUDAQ_FW_LEVEL", 0) : 0;
+    m_chunk_bytes = conf ? conf->Get("EUDAQ_FW_CHUNK_BYTES", 1 << 20) : 1 << 20;
+    m_chunk_events = conf ? conf->Get("EUDAQ_FW_CHUNK_EVENTS", 1000) : 1000;
+    m_flush_ms = std::chrono::milliseconds(conf ? conf->Get("EUDAQ_FW_FLUSH_MS", 200) : 200);
+    size_t n_threads = conf ? conf->Get("EUDAQ_FW_THREADS", 2) : 2;
+    if(!n_threads)
+      n_threads = 1;
+    m_max_chunks = 2 * n_threads + 2;
+    m_is_running = true;
+    for(size_t i = 0; i < n_threads; i++)
+      m_fut_compress.push_back(std::async(std::launch::async,
+					  &CompressedFileWriter::AsyncCompressing, this));
+    m_fut_write = std::async(std::launch::async, &CompressedFileWriter::AsyncWriting, this);
+  }
+
+  std::FILE *fd = std::fopen(filename.c_str(), "rb");
+  if(fd){
+    std::fclose(fd);
+    EUDAQ_THROWX(eudaq::FileExistsException, "File already exists: " + filename);
+  }
+  fd = std::fopen(filename.c_str(), "wb");
+  if(!fd)
+    EUDAQ_THROWX(eudaq::FileNotFoundException, "Unable to open file: " + filename);
+  std::shared_ptr<OutFile> file(new OutFile);
+  file->name = filename;
+  file->fd.reset(fd, std::fclose);
+  file->codec = m_codec;
+  file->bytes = 0;
+  file->raw_bytes = 0;
+  file->compress_us = 0;
+  if(conf && conf->Get("EUDAQ_FW_INDEX", 0)){
+    file->idx.reset(new eudaq::FileSerializer(eudaq::FileIndex::IndexPath(filename)));
+    eudaq::FileIndex::WriteHeader(*file->idx);
+  }
+  //the file header is queued as a chunk which needs no compression
+  std::shared_ptr<Chunk> chunk(new Chunk);
+  ChunkSerializer ser(chunk->comp);
+  ser.append(reinterpret_cast<const uint8_t*>(RAWZ_MAGIC), sizeof(RAWZ_MAGIC));
+  ser.write(RAWZ_VERSION);
+  chunk->file = file;
+  chunk->sync = false;
+  chunk->done = true;
+  lk.lock();
+  std::atomic_store(&m_file, file);
+  m_qu_chunk.push_back(chunk);
+  lk.unlock();
+  m_cv.notify_all();
+  m_run_n = run_n;
+}
+
+void CompressedFileWriter::CheckThreads(){
+  //called with m_mx locked
+  for(auto &fut: m_fut_compress){
+    if(!fut.valid() || fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+      if(fut.valid())
+	fut.get(); //rethrows the error of the thread
+      EUDAQ_THROW("CompressedFileWriter: A compressing thread has stopped");
+    }
+  }
+  if(!m_fut_write.valid() ||
+     m_fut_write.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+    if(m_fut_write.valid())
+      m_fut_write.get();
+    EUDAQ_THROW("CompressedFileWriter: The writing thread has stopped");
+  }
+}
+
+void CompressedFileWriter::WriteEvent(eudaq::EventSPC ev) {
+  Write(ev, nullptr);
+}
+
+void CompressedFileWriter::WriteSerialized(eudaq::EventSPC ev, eudaq::BufferSerializerSPC ser) {
+  Write(ev, ser.get());
+}
+
+void CompressedFileWriter::Write(eudaq::EventSPC ev, const eudaq::BufferSerializer *ser) {
+  uint32_t run_n = ev->GetRunN();
+  if(!m_file || m_run_n != run_n)
+    OpenFile(run_n);
+
+  std::unique_lock<std::mutex> lk(m_mx);
+  CheckThreads();
+  if(!m_chunk){
+    m_chunk.reset(new Chunk);
+    m_chunk->file = m_file;
+    m_chunk->sync = false;
+    m_chunk->done = false;
+    m_chunk->raw.reserve(m_chunk_bytes);
+    m_tp_chunk = std::chrono::steady_clock::now();
+  }
+  uint32_t offset = m_chunk->raw.size();
+  m_chunk->ev_offsets.push_back(offset);
+  if(ser)
+    m_chunk->raw.insert(m_chunk->raw.end(), ser->data(), ser->data() + ser->size());
+  else{
+    ChunkSerializer cser(m_chunk->raw);
+    cser.write(*(ev.get()));
+  }
+  if(m_file->idx)
+    m_chunk->entries.push_back(eudaq::FileIndex::MakeEntry(0, *ev));
+  bool sync = ev->IsEORE();
+  if(sync || m_chunk->raw.size() >= m_chunk_bytes
+     || m_chunk->ev_offsets.size() >= m_chunk_events
+     || std::chrono::steady_clock::now() - m_tp_chunk >= m_flush_ms){
+    while(m_qu_chunk.size() >= m_max_chunks){
+      //compression or the disk does not keep up
+      m_cv.wait_for(lk, std::chrono::milliseconds(100));
+      CheckThreads();
+    }
+    QueueChunk(sync);
+  }
+}
+
+void CompressedFileWriter::QueueChunk(bool sync){
+  //called with m_mx locked
+  m_chunk->sync = sync;
+  m_qu_chunk.push_back(m_chunk);
+  m_qu_todo.push_back(m_chunk);
+  m_chunk.reset();
+  m_cv.notify_all();
+}
+
+bool CompressedFileWriter::AsyncCompressing(){
+  std::unique_lock<std::mutex> lk(m_mx);
+  while(m_is_running || !m_qu_todo.empty()){
+    if(m_qu_todo.empty()){
+      m_cv.wait_for(lk, std::chrono::milliseconds(100));
+      continue;
+    }
+    auto chunk = m_qu_todo.front();
+    m_qu_todo.pop_front();
+    lk.unlock();
+
+    auto tp_start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> comp;
+    eudaq::CompressBuffer(chunk->file->codec, m_level, chunk->raw, comp);
+    uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>
+      (std::chrono::steady_clock::now() - tp_start).count();
+    ChunkSerializer ser(chunk->comp);
+    ser.write(chunk->file->codec);
+    ser.write(uint32_t(chunk->ev_offsets.size()));
+    ser.write(uint32_t(chunk->raw.size()));
+    ser.write(uint32_t(comp.size()));
+    for(auto offset: chunk->ev_offsets)
+      ser.write(offset);
+    ser.append(comp.data(), comp.size());
+    chunk->file->raw_bytes += chunk->raw.size();
+    chunk->file->compress_us += us;
+    std::vector<uint8_t>().swap(chunk->raw);
+
+    lk.lock();
+    chunk->done = true;
+    m_cv.notify_all();
+  }
+  return true;
+}
+
+bool CompressedFileWriter::AsyncWriting(){
+  std::unique_lock<std::mutex> lk(m_mx);
+  while(m_is_running || !m_qu_chunk.empty()){
+    if(m_qu_chunk.empty() || !m_qu_chunk.front()->done){
+      //flush a chunk which has waited too long for more events
+      if(m_chunk && std::chrono::steady_clock::now() - m_tp_chunk >= m_flush_ms)
+	QueueChunk(false);
+      else
+	m_cv.wait_for(lk, m_flush_ms.count() ? m_flush_ms : std::chrono::milliseconds(100));
+      continue;
+    }
+    auto chunk = m_qu_chunk.front();
+    m_qu_chunk.pop_front();
+    lk.unlock();
+    m_cv.notify_all();
+
+    auto &file = chunk->file;
+    auto tp_start = std::chrono::steady_clock::now();
+    uint64_t offset = file->bytes;
+    if(std::fwrite(chunk->comp.data(), 1, chunk->comp.size(), file->fd.get()) != chunk->comp.size())
+      EUDAQ_THROW("CompressedFileWriter: Error writing to file: " + eudaq::to_string(errno)
+		  + ", " + std::strerror(errno));
+    if(file->idx){
+      //the events of a frame share the offset of the frame
+      for(auto &e: chunk->entries){
+	e.offset = offset;
+	eudaq::FileIndex::WriteEntry(*file->idx, e);
+      }
+    }
+    if(chunk->sync){
+      std::fflush(file->fd.get());
+#if !EUDAQ_PLATFORM_IS(WIN32)
+      fsync(fileno(file->fd.get()));
+#endif
+      if(file->idx)
+	file->idx->Flush();
+    }
+    m_latency_us = std::chrono::duration_cast<std::chrono::microseconds>
+      (std::chrono::steady_clock::now() - tp_start).count();
+    file->bytes += chunk->comp.size();
+    chunk.reset();
+
+    lk.lock();
+  }
+  return true;
+}
+
+uint64_t CompressedFileWriter::FileBytes() const {
+  auto file = std::atomic_load(&m_file);
+  return file ? uint64_t(file->bytes) : 0;
+}
+
+uint64_t CompressedFileWriter::WriteLatency() const {
+  return m_latency_us;
+}
+
+uint64_t CompressedFileWriter::RawBytes() const {
+  auto file = std::atomic_load(&m_file);
+  return file ? uint64_t(file->raw_bytes) : 0;
+}
+
+uint64_t CompressedFileWriter::CompressTime() const {
+  auto file = std::atomic_load(&m_file);
+  return file ? uint64_t(file->compress_us) : 0;
+}
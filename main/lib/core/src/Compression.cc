@@ -0,0 +1,156 @@
+#include "eudaq/Compression.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Utils.hh"
+
+#include <cstring>
+#ifdef EUDAQ_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef EUDAQ_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef EUDAQ_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace eudaq {
+
+  CompressionCodec GetCompressionCodec(const std::string &name){
+    std::string n = lcase(name);
+    CompressionCodec codec;
+    if(n == "none")
+      codec = CODEC_NONE;
+    else if(n == "lz4")
+      codec = CODEC_LZ4;
+    else if(n == "zstd")
+      codec = CODEC_ZSTD;
+    else if(n == "zlib")
+      codec = CODEC_ZLIB;
+    else
+      EUDAQ_THROW("Unknown compression codec: " + name);
+    if(!IsCompressionAvailable(codec))
+      EUDAQ_THROW("Compression codec " + name + " is not compiled in");
+    return codec;
+  }
+
+  std::string GetCompressionName(uint32_t codec){
+    switch(codec){
+    case CODEC_NONE: return "none";
+    case CODEC_LZ4: return "lz4";
+    case CODEC_ZSTD: return "zstd";
+    case CODEC_ZLIB: return "zlib";
+    default: return "unknown(" + to_string(codec) + ")";
+    }
+  }
+
+  bool IsCompressionAvailable(uint32_t codec){
+    switch(codec){
+    case CODEC_NONE: return true;
+#ifdef EUDAQ_HAVE_LZ4
+    case CODEC_LZ4: return true;
+#endif
+#ifdef EUDAQ_HAVE_ZSTD
+    case CODEC_ZSTD: return true;
+#endif
+#ifdef EUDAQ_HAVE_ZLIB
+    case CODEC_ZLIB: return true;
+#endif
+    default: return false;
+    }
+  }
+
+  CompressionCodec GetDefaultCompressionCodec(){
+    for(auto codec: {CODEC_LZ4, CODEC_ZSTD, CODEC_ZLIB}){
+      if(IsCompressionAvailable(codec))
+	return codec;
+    }
+    return CODEC_NONE;
+  }
+
+  void CompressBuffer(uint32_t codec, int level, const std::vector<uint8_t> &in,
+		      std::vector<uint8_t> &out){
+    switch(codec){
+    case CODEC_NONE:
+      out = in;
+      return;
+#ifdef EUDAQ_HAVE_LZ4
+    case CODEC_LZ4:{
+      out.resize(LZ4_compressBound(int(in.size())));
+      int n = LZ4_compress_default(reinterpret_cast<const char*>(in.data()),
+				   reinterpret_cast<char*>(out.data()),
+				   int(in.size()), int(out.size()));
+      if(n <= 0)
+	EUDAQ_THROW("LZ4 compression failed");
+      out.resize(n);
+      return;
+    }
+#endif
+#ifdef EUDAQ_HAVE_ZSTD
+    case CODEC_ZSTD:{
+      out.resize(ZSTD_compressBound(in.size()));
+      size_t n = ZSTD_compress(out.data(), out.size(), in.data(), in.size(),
+			       level ? level : 3);
+      if(ZSTD_isError(n))
+	EUDAQ_THROW(std::string("Zstd compression failed: ") + ZSTD_getErrorName(n));
+      out.resize(n);
+      return;
+    }
+#endif
+#ifdef EUDAQ_HAVE_ZLIB
+    case CODEC_ZLIB:{
+      uLongf n = compressBound(in.size());
+      out.resize(n);
+      int err = compress2(out.data(), &n, in.data(), in.size(),
+			  level ? level : Z_DEFAULT_COMPRESSION);
+      if(err != Z_OK)
+	EUDAQ_THROW("Zlib compression failed: " + to_string(err));
+      out.resize(n);
+      return;
+    }
+#endif
+    default:
+      EUDAQ_THROW("Compression codec " + GetCompressionName(codec) + " is not available");
+    }
+  }
+
+  void DecompressBuffer(uint32_t codec, const uint8_t *in, size_t len,
+			std::vector<uint8_t> &out){
+    switch(codec){
+    case CODEC_NONE:
+      if(len != out.size())
+	EUDAQ_THROWX(FileReadException, "Uncompressed size mismatch");
+      if(len)
+	std::memcpy(out.data(), in, len);
+      return;
+#ifdef EUDAQ_HAVE_LZ4
+    case CODEC_LZ4:{
+      int n = LZ4_decompress_safe(reinterpret_cast<const char*>(in),
+				  reinterpret_cast<char*>(out.data()),
+				  int(len), int(out.size()));
+      if(n < 0 || size_t(n) != out.size())
+	EUDAQ_THROWX(FileReadException, "LZ4 decompression failed");
+      return;
+    }
+#endif
+#ifdef EUDAQ_HAVE_ZSTD
+    case CODEC_ZSTD:{
+      size_t n = ZSTD_decompress(out.data(), out.size(), in, len);
+      if(ZSTD_isError(n) || n != out.size())
+	EUDAQ_THROWX(FileReadException, "Zstd decompression failed");
+      return;
+    }
+#endif
+#ifdef EUDAQ_HAVE_ZLIB
+    case CODEC_ZLIB:{
+      uLongf n = out.size();
+      if(uncompress(out.data(), &n, in, len) != Z_OK || n != out.size())
+	EUDAQ_THROWX(FileReadException, "Zlib decompression failed");
+      return;
+    }
+#endif
+    default:
+      EUDAQ_THROWX(FileReadException, "Compression codec " + GetCompressionName(codec)
+		   + " is not available");
+    }
+  }
+}
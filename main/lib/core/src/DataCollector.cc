@@ -5,7 +5,17 @@
 #include <ostream>
 #include <ctime>
 #include <iomanip>
+#include <algorithm>
+#include <limits>
 namespace eudaq {
+  namespace{
+    //the collector and the shard of the building thread
+    thread_local const DataCollector *t_shard_dc = nullptr;
+    thread_local uint32_t t_shard = 0;
+    const uint64_t SHARD_IDLE = std::numeric_limits<uint64_t>::max();
+    const size_t SHARD_QUEUE_SIZE = 4096;
+  }
+
   template class DLLEXPORT Factory<DataCollector>;
   template DLLEXPORT std::map<uint32_t, typename Factory<DataCollector>::UP_BASE (*)
 			      (const std::string&, const std::string&)>&
@@ -16,9 +26,21 @@ namespace eudaq {
     m_dct_n= str2hash(GetFullName());
     m_evt_c = 0;
     m_fraction = 1;
+    m_mn_sampling = "auto";
+    m_mn_rate = 0;
+    m_mn_window_ms = 1000;
+    m_mn_flags = 0;
+    m_mn_evt_c = 0;
+    m_shard_key = SHARD_NONE;
+    m_shard_n = 0;
+    m_shard_slice = 1;
+    m_shard_seq = 0;
+    m_shard_stop = false;
+    m_write_waiting = false;
   }
 
-  DataCollector::~DataCollector(){  
+  DataCollector::~DataCollector(){
+    StopShards();
   }
 
   void DataCollector::DoInitialise(){
@@ -54,6 +76,18 @@ namespace eudaq {
   void DataCollector::SetServerAddress(const std::string &addr){
     m_data_addr = addr;
   }
+
+  void DataCollector::SetShardKey(ShardKey key){
+    m_shard_key = key;
+  }
+
+  uint32_t DataCollector::GetShardN() const{
+    return m_shard_n ? m_shard_n : 1;
+  }
+
+  uint32_t DataCollector::GetShard(){
+    return t_shard;
+  }
   
   void DataCollector::OnInitialise(){
     EUDAQ_INFO(GetFullName() + " is to be initialised...");
@@ -81,6 +115,25 @@ namespace eudaq {
       m_fwpatt = conf->Get("EUDAQ_FW_PATTERN", "$12D_run$6R$X");
       m_dct_n = conf->Get("EUDAQ_ID", m_dct_n);
       m_fraction = conf->Get("EUDAQ_DATACOL_SEND_MONITOR_FRACTION", 10);
+      m_mn_sampling = conf->Get("EUDAQ_DATACOL_MONITOR_SAMPLING", "auto");
+      m_mn_rate = conf->Get("EUDAQ_DATACOL_MONITOR_RATE", 0.0);
+      m_mn_window_ms = conf->Get("EUDAQ_DATACOL_MONITOR_WINDOW_MS", 1000);
+      m_mn_flags = conf->Get("EUDAQ_DATACOL_MONITOR_FLAGS", 0);
+      SetQueueSize(conf->Get("EUDAQ_DATARECEIVER_QUEUE_SIZE", 50000));
+      SetOverflowPolicy(conf->Get("EUDAQ_DATARECEIVER_POLICY", "block"));
+      SetDeserializeThreads(conf->Get("EUDAQ_DATARECEIVER_THREADS", 2));
+      SocketOptions sockopt;
+      sockopt.sndbuf = conf->Get("EUDAQ_SOCKET_SNDBUF", 0);
+      sockopt.rcvbuf = conf->Get("EUDAQ_SOCKET_RCVBUF", 0);
+      sockopt.nodelay = conf->Get("EUDAQ_TCP_NODELAY", 0);
+      sockopt.cork = conf->Get("EUDAQ_TCP_CORK", 0);
+      SetSocketOptions(sockopt);
+      m_shard_n = conf->Get("EUDAQ_DATACOL_BUILD_THREADS", 0);
+      m_shard_slice = std::max(conf->Get("EUDAQ_DATACOL_BUILD_SLICE", uint64_t(64)), uint64_t(1));
+      if(m_shard_n && m_shard_key == SHARD_NONE){
+	EUDAQ_WARN(GetFullName() + " builds its events in a single thread, EUDAQ_DATACOL_BUILD_THREADS is ignored");
+	m_shard_n = 0;
+      }
       DoConfigure();
       CommandReceiver::OnConfigure();
     }catch (const Exception &e) {
@@ -93,22 +146,43 @@ namespace eudaq {
   void DataCollector::OnStartRun(){
     EUDAQ_INFO("RUN #" + std::to_string(GetRunNumber()) + " is to be started...");
     try {
+      StartShards();
       m_data_addr = Listen(m_data_addr);
       SetStatusTag("_SERVER", m_data_addr);
       m_writer = Factory<FileWriter>::Create<std::string&>(str2hash(m_fwtype), m_fwpatt);
+      if(m_writer)
+	m_writer->SetConfiguration(GetConfiguration());
       m_evt_c = 0;
+      m_mn_evt_c = 0;
 
       std::string mn_str = GetConfiguration()->Get("EUDAQ_MN", "");
       std::vector<std::string> col_mn_name = split(mn_str, ";,", true);
+      //a slow monitor must not hold back the writing of the events
+      std::string mn_policy = GetConfiguration()->Get("EUDAQ_DATACOL_MONITOR_POLICY", "drop_oldest");
       std::string cur_backup = GetConfiguration()->GetCurrentSectionName();
       GetConfiguration()->SetSection("");
       for(auto &mn_name: col_mn_name){
 	std::string mn_addr =  GetConfiguration()->Get("Monitor."+mn_name, "");
 	std::unique_lock<std::mutex> lk(m_mtx_sender);
 	if(!mn_addr.empty()){
-	  m_senders[mn_addr]
-	    = std::shared_ptr<DataSender>(new DataSender("DataCollector", GetName()));
-	  m_senders[mn_addr]->Connect(mn_addr);
+	  auto mn = std::make_shared<MonitorLink>();
+	  mn->name = mn_name;
+	  mn->sender.reset(new DataSender("DataCollector", GetName()));
+	  mn->sender->SetOverflowPolicy(mn_policy);
+	  mn->sender->Connect(mn_addr);
+	  //the rate advertised by the monitor comes before the configured one
+	  double rate = mn->sender->GetTargetRate();
+	  if(rate <= 0)
+	    rate = m_mn_rate;
+	  std::string sampling = m_mn_sampling;
+	  if(lcase(sampling) == "auto")
+	    sampling = rate > 0 ? "rate" : "fraction";
+	  mn->sampler.SetPolicy(sampling);
+	  mn->sampler.SetFraction(m_fraction);
+	  mn->sampler.SetRate(rate);
+	  mn->sampler.SetWindow(std::chrono::milliseconds(m_mn_window_ms));
+	  mn->sampler.SetForwardFlags(m_mn_flags);
+	  m_monitors[mn_addr] = mn;
 	}
 	lk.unlock();
       }
@@ -125,11 +199,16 @@ namespace eudaq {
   void DataCollector::OnStopRun(){
     EUDAQ_INFO("RUN #" + std::to_string(GetRunNumber()) + " is to be stopped...");
     try {
+      //the events still queued are received and built before DoStopRun,
+      //so the user may flush what is left over
+      StopListen();
+      StopShards();
       DoStopRun();
       std::unique_lock<std::mutex> lk(m_mtx_sender);
-      m_senders.clear();
+      m_monitors.clear();
       lk.unlock();
-      StopListen();
+      //the memory of the events of this run is given back
+      EventPool::Trim();
       CommandReceiver::OnStopRun();
     } catch (const Exception &e) {
       std::string msg = "Error stopping for run " + std::to_string(GetRunNumber()) + ": " + e.what();
@@ -143,9 +222,10 @@ namespace eudaq {
     try{
       DoReset();
       std::unique_lock<std::mutex> lk(m_mtx_sender);
-      m_senders.clear();
+      m_monitors.clear();
       lk.unlock();
       StopListen();
+      StopShards();
       CommandReceiver::OnReset();
     } catch (const std::exception &e) {
       EUDAQ_THROW( std::string("DataCollector Reset:: Caught exception: ") + e.what() );
@@ -164,26 +244,267 @@ namespace eudaq {
     
   void DataCollector::OnStatus(){
     SetStatusTag("EventN", std::to_string(m_evt_c));
-    SetStatusTag("MonitorEventN", std::to_string(float(m_evt_c/m_fraction)));
+    SetStatusTag("MonitorEventN", std::to_string(m_mn_evt_c));
+    for(auto &occ: GetQueueOccupancy()){
+      SetStatusTag("RecvQueue." + occ.first, std::to_string(occ.second.first)
+		   + "/" + std::to_string(occ.second.second));
+    }
+    SetStatusTag("RecvDroppedN", std::to_string(GetQueueDroppedN()));
+    for(auto &bytes: GetConnectionBytes()){
+      SetStatusTag("RecvBytes." + bytes.first, std::to_string(bytes.second.first)
+		   + "/" + std::to_string(bytes.second.second));
+    }
+    SetStatusTag("RecvSpilledN", std::to_string(GetQueueSpilledN()));
+    std::unique_lock<std::mutex> lk_sender(m_mtx_sender);
+    uint64_t mn_dropped_n = 0;
+    for(auto &e: m_monitors){
+      mn_dropped_n += e.second->sender->GetDroppedN();
+      //forwarded over offered events, after the adaption to the monitor
+      SetStatusTag("MonitorRatio." + e.second->name, std::to_string(e.second->sampler.GetRatio()));
+    }
+    lk_sender.unlock();
+    SetStatusTag("MonitorDroppedN", std::to_string(mn_dropped_n));
+    auto pool = EventPool::GetStat();
+    SetStatusTag("EventPoolAllocN", std::to_string(pool.alloc_n));
+    SetStatusTag("EventPoolHeapN", std::to_string(pool.heap_n));
+    SetStatusTag("EventPoolBytes", std::to_string(pool.cached_bytes));
+    std::unique_lock<std::mutex> lk_shards(m_mx_shards);
+    for(uint32_t i = 0; i < m_shards.size(); i++){
+      std::unique_lock<std::mutex> lk(m_shards[i]->mx);
+      SetStatusTag("BuildShardQueue." + std::to_string(i), std::to_string(m_shards[i]->in.size())
+		   + "/" + std::to_string(m_shards[i]->out.size()));
+    }
+    lk_shards.unlock();
     DoStatus();
-    // if(m_writer && m_writer->FileBytes()){
-    //   SetStatusTag("FILEBYTES", std::to_string(m_writer->FileBytes()));
-    // }
+    auto file_writer = m_writer;
+    if(file_writer){
+      SetStatusTag("FILEBYTES", std::to_string(file_writer->FileBytes()));
+      SetStatusTag("FILELATENCY_US", std::to_string(file_writer->WriteLatency()));
+      SetStatusTag("FILERAWBYTES", std::to_string(file_writer->RawBytes()));
+      SetStatusTag("FILECOMPRESS_US", std::to_string(file_writer->CompressTime()));
+    }
   }
 
   void DataCollector::OnConnect(ConnectionSPC id){
-    DoConnect(id);
+    if(m_shards.empty()){
+      ConnectShards(id, true);
+      return;
+    }
+    uint64_t seq = m_shard_seq;
+    for(uint32_t i = 0; i < m_shards.size(); i++)
+      PushShard(i, ShardItem{seq, id, nullptr, true});
+    m_shard_seq++;
   }
     
   void DataCollector::OnDisconnect(ConnectionSPC id){
-    DoDisconnect(id);
+    if(m_shards.empty()){
+      ConnectShards(id, false);
+      return;
+    }
+    uint64_t seq = m_shard_seq;
+    for(uint32_t i = 0; i < m_shards.size(); i++)
+      PushShard(i, ShardItem{seq, id, nullptr, false});
+    m_shard_seq++;
   }
     
+  void DataCollector::ConnectShards(ConnectionSPC id, bool connect){
+    //without the building threads (e.g. after the run), the state of every
+    //shard still follows the connections, as it does while they run
+    uint32_t n = GetShardN();
+    for(uint32_t i = 0; i < n; i++){
+      t_shard = i;
+      try{
+	if(connect)
+	  DoConnect(id);
+	else
+	  DoDisconnect(id);
+      }catch(...){
+	t_shard = 0;
+	throw;
+      }
+    }
+    t_shard = 0;
+  }
+
   void DataCollector::OnReceive(ConnectionSPC id, EventSP ev){
-    DoReceive(id, ev);
-  }  
-    
+    if(m_shards.empty()){
+      DoReceive(id, ev);
+      return;
+    }
+    uint64_t key;
+    if(m_shard_key == SHARD_TRIGGER)
+      key = ev->GetTriggerN();
+    else if(m_shard_key == SHARD_TIMESTAMP)
+      key = ev->GetTimestampBegin();
+    else
+      key = ev->GetEventN();
+    uint32_t i = (key / m_shard_slice) % m_shards.size();
+    PushShard(i, ShardItem{m_shard_seq, id, ev, false});
+    m_shard_seq++;
+  }
+
+  void DataCollector::PushShard(uint32_t i, ShardItem &&item){
+    Shard &sh = *m_shards[i];
+    std::unique_lock<std::mutex> lk(sh.mx);
+    sh.cv_not_full.wait(lk, [&sh](){return sh.in.size() < SHARD_QUEUE_SIZE;});
+    sh.in.push_back(std::move(item));
+    if(sh.waiting)
+      sh.cv_not_empty.notify_one();
+  }
+
+  void DataCollector::StartShards(){
+    StopShards();
+    m_shard_seq = 0;
+    m_shard_stop = false;
+    std::unique_lock<std::mutex> lk(m_mx_shards);
+    for(uint32_t i = 0; i < m_shard_n; i++){
+      m_shards.emplace_back(new Shard);
+      m_shards.back()->cur = SHARD_IDLE;
+      m_shards.back()->waiting = false;
+    }
+    lk.unlock();
+    for(uint32_t i = 0; i < m_shard_n; i++)
+      m_shards[i]->fut = std::async(std::launch::async, &DataCollector::AsyncBuilding, this, i);
+    if(m_shard_n)
+      m_fut_write = std::async(std::launch::async, &DataCollector::AsyncWriting, this);
+  }
+
+  void DataCollector::StopShards(){
+    if(m_shards.empty())
+      return;
+    m_shard_stop = true;
+    for(auto &sh: m_shards){
+      std::unique_lock<std::mutex> lk(sh->mx);
+      sh->cv_not_empty.notify_all();
+    }
+    for(auto &sh: m_shards)
+      if(sh->fut.valid())
+	sh->fut.get();
+    m_cv_write.notify_all();
+    if(m_fut_write.valid())
+      m_fut_write.get();
+    std::unique_lock<std::mutex> lk(m_mx_shards);
+    m_shards.clear();
+  }
+
+  bool DataCollector::AsyncBuilding(uint32_t i){
+    t_shard_dc = this;
+    t_shard = i;
+    Shard &sh = *m_shards[i];
+    std::deque<ShardItem> batch;
+    while(true){
+      std::unique_lock<std::mutex> lk(sh.mx);
+      sh.waiting = true;
+      sh.cv_not_empty.wait(lk, [&](){return !sh.in.empty() || m_shard_stop;});
+      sh.waiting = false;
+      if(sh.in.empty())
+	break;
+      batch.swap(sh.in);
+      sh.cur = batch.front().seq;
+      sh.cv_not_full.notify_all();
+      lk.unlock();
+      for(auto &item: batch){
+	sh.cur = item.seq;
+	try{
+	  if(item.ev)
+	    DoReceive(item.con, item.ev);
+	  else if(item.connect)
+	    DoConnect(item.con);
+	  else
+	    DoDisconnect(item.con);
+	}catch (const std::exception &e) {
+	  std::string msg = "Exception building the events of shard " + std::to_string(i) + ": " + e.what();
+	  EUDAQ_ERROR(msg);
+	  SetStatus(Status::STATE_ERROR, msg);
+	}
+      }
+      batch.clear();
+      lk.lock();
+      sh.cur = sh.in.empty() ? SHARD_IDLE : sh.in.front().seq;
+      lk.unlock();
+      WakeWriting();
+    }
+    sh.cur = SHARD_IDLE;
+    t_shard_dc = nullptr;
+    t_shard = 0;
+    WakeWriting();
+    return 0;
+  }
+
+  void DataCollector::WakeWriting(){
+    //only wake up the writing thread if it went to sleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_write_waiting){
+      std::unique_lock<std::mutex> lk(m_mx_write);
+      m_cv_write.notify_one();
+    }
+  }
+
+  bool DataCollector::AsyncWriting(){
+    //an event written while building the received event of seq q is stored
+    //once every shard is done with the received events before q
+    std::vector<std::deque<std::pair<uint64_t, EventSP>>> ready(m_shards.size() + 1);
+    while(true){
+      bool stopping = m_shard_stop;
+      uint64_t bound = SHARD_IDLE;
+      for(auto &sh: m_shards){
+	std::unique_lock<std::mutex> lk(sh->mx);
+	uint64_t oldest = sh->in.empty() ? sh->cur.load() : std::min(sh->cur.load(), sh->in.front().seq);
+	bound = std::min(bound, oldest);
+      }
+      bool pending = false;
+      for(uint32_t i = 0; i <= m_shards.size(); i++){
+	std::unique_lock<std::mutex> lk(i < m_shards.size() ? m_shards[i]->mx : m_mx_write);
+	auto &out = i < m_shards.size() ? m_shards[i]->out : m_write_ext;
+	while(!out.empty() && out.front().first <= bound){
+	  ready[i].push_back(std::move(out.front()));
+	  out.pop_front();
+	}
+	pending = pending || !out.empty();
+      }
+      bool written = false;
+      while(true){
+	uint32_t min_i = ready.size();
+	for(uint32_t i = 0; i < ready.size(); i++)
+	  if(!ready[i].empty() && (min_i == ready.size() || ready[i].front().first < ready[min_i].front().first))
+	    min_i = i;
+	if(min_i == ready.size())
+	  break;
+	StoreEvent(std::move(ready[min_i].front().second));
+	ready[min_i].pop_front();
+	written = true;
+      }
+      if(stopping && bound == SHARD_IDLE && !pending)
+	break;
+      if(!written){
+	std::unique_lock<std::mutex> lk(m_mx_write);
+	m_write_waiting = true;
+	m_cv_write.wait_for(lk, std::chrono::milliseconds(1));
+	m_write_waiting = false;
+      }
+    }
+    return 0;
+  }
+
   void DataCollector::WriteEvent(EventSP ev){
+    if(!m_shards.empty()){
+      if(t_shard_dc == this){
+	Shard &sh = *m_shards[t_shard];
+	std::unique_lock<std::mutex> lk(sh.mx);
+	sh.out.push_back(std::make_pair(sh.cur.load(), std::move(ev)));
+      }
+      else{
+	//written outside of the building threads, after the events received so far
+	std::unique_lock<std::mutex> lk(m_mx_write);
+	m_write_ext.push_back(std::make_pair(m_shard_seq.load(), std::move(ev)));
+      }
+      WakeWriting();
+      return;
+    }
+    StoreEvent(std::move(ev));
+  }
+
+  void DataCollector::StoreEvent(EventSP ev){
     try{
       if(ev->IsBORE()){
 	if(GetConfiguration())
@@ -197,21 +518,49 @@ namespace eudaq {
       m_evt_c ++;
       ev->SetStreamN(m_dct_n);
       auto file_writer = m_writer;
-      if(file_writer)
-	file_writer->WriteEvent(ev);
-      else
+      if(!file_writer)
 	EUDAQ_THROW("FileWriter is not created before writing.");
       std::unique_lock<std::mutex> lk(m_mtx_sender);
-      auto senders = m_senders;
+      auto monitors = m_monitors;
       lk.unlock();
-      if(m_evt_c%m_fraction != 0 && m_evt_c!=1){
-	return;
-      }
-      for(auto &e: senders){
-	if(e.second)
-	  e.second->SendEvent(ev);
-	else
+      //each monitor samples the events at its own pace, following the
+      //occupancy of its sending queue
+      std::vector<bool> mn_fwd(monitors.size());
+      std::vector<std::vector<EventSPC>> mn_picked(monitors.size());
+      bool to_monitor = false;
+      size_t mn_i = 0;
+      for(auto &e: monitors){
+	auto &sender = e.second->sender;
+	if(!sender)
 	  EUDAQ_THROW("DataCollector::WriterEvent, using a null pointer of DataSender");
+	double load = double(sender->GetQueueDepth()) / sender->GetQueueSize();
+	mn_fwd[mn_i] = e.second->sampler.Sample(ev, load, mn_picked[mn_i]);
+	to_monitor = to_monitor || mn_fwd[mn_i];
+	mn_i++;
+      }
+      //serialized once, the file writer and all the monitors share the bytes
+      BufferSerializerSPC ser;
+      if(to_monitor || file_writer->TakesSerialized()){
+	auto buf = std::make_shared<BufferSerializer>();
+	ev->Serialize(*buf);
+	ser = buf;
+      }
+      if(ser && file_writer->TakesSerialized())
+	file_writer->WriteSerialized(ev, ser);
+      else
+	file_writer->WriteEvent(ev);
+      mn_i = 0;
+      for(auto &e: monitors){
+	//the events picked earlier by a reservoir are serialized by the sender
+	for(auto &pev: mn_picked[mn_i]){
+	  e.second->sender->SendEvent(pev);
+	  m_mn_evt_c++;
+	}
+	if(mn_fwd[mn_i]){
+	  e.second->sender->SendEvent(ev, ser);
+	  m_mn_evt_c++;
+	}
+	mn_i++;
       }
     }catch (const Exception &e) {
       std::string msg = "Exception writing to file: ";
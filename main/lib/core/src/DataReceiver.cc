@@ -7,10 +7,16 @@
 #include <ostream>
 #include <ctime>
 #include <iomanip>
+#include <algorithm>
+#include <cstring>
 namespace eudaq {
   
   DataReceiver::DataReceiver()
-    :m_is_listening(false),m_is_destructing(false), m_last_addr("tcp://0"){
+    :m_is_listening(false),m_is_destructing(false), m_last_addr("tcp://0"),
+     m_qu_size(50000), m_policy(POLICY_LOSSY), m_fwd_waiting(false),
+     m_rcv_waiting(false), m_dropped_n(0), m_spilled_n(0),
+     m_spill_file(nullptr), m_spill_n(0), m_spill_offset(0), m_dsr_n(0),
+     m_target_rate(0), m_dsr_running(0), m_dsr_waiting(0), m_raw_waiting(false){
   }
 
   DataReceiver::~DataReceiver(){
@@ -18,6 +24,73 @@ namespace eudaq {
     if(m_fut_deamon.valid()){
       m_fut_deamon.get();
     }
+    if(m_spill_file)
+      std::fclose(m_spill_file);
+  }
+
+  void DataReceiver::SetQueueSize(size_t n){
+    if(n == 0)
+      EUDAQ_THROW("DataReceiver: Queue size must be larger than zero");
+    m_qu_size = n;
+  }
+
+  void DataReceiver::SetOverflowPolicy(OverflowPolicy policy){
+    m_policy = policy;
+  }
+
+  void DataReceiver::SetOverflowPolicy(const std::string &policy){
+    std::string p = lcase(policy);
+    if(p == "block")
+      m_policy = POLICY_BLOCK;
+    else if(p == "lossy")
+      m_policy = POLICY_LOSSY;
+    else if(p == "spill")
+      m_policy = POLICY_SPILL;
+    else
+      EUDAQ_THROW("DataReceiver: Unknown overflow policy '" + policy
+		  + "' (block, lossy or spill)");
+  }
+
+  void DataReceiver::SetDeserializeThreads(size_t n){
+    m_dsr_n = n;
+  }
+
+  void DataReceiver::SetTargetRate(double hz){
+    m_target_rate = hz > 0 ? hz : 0;
+  }
+
+  void DataReceiver::SetSocketOptions(const SocketOptions &opt){
+    m_sockopt = opt;
+  }
+
+  std::map<std::string, std::pair<uint64_t, uint64_t>>
+  DataReceiver::GetQueueOccupancy(){
+    std::map<std::string, std::pair<uint64_t, uint64_t>> occ;
+    std::unique_lock<std::mutex> lk(m_mx_qu_stat);
+    for(auto &stat: m_qu_stat){
+      occ[stat.second->name] = std::make_pair(stat.second->n.load(),
+					      stat.second->hw.load());
+    }
+    return occ;
+  }
+
+  std::map<std::string, std::pair<uint64_t, uint64_t>>
+  DataReceiver::GetConnectionBytes(){
+    std::map<std::string, std::pair<uint64_t, uint64_t>> bytes;
+    std::unique_lock<std::mutex> lk(m_mx_qu_stat);
+    for(auto &stat: m_qu_stat){
+      bytes[stat.second->name] = std::make_pair(stat.second->con->GetBytesReceived(),
+						stat.second->con->GetBytesSent());
+    }
+    return bytes;
+  }
+
+  uint64_t DataReceiver::GetQueueDroppedN() const{
+    return m_dropped_n;
+  }
+
+  uint64_t DataReceiver::GetQueueSpilledN() const{
+    return m_spilled_n;
   }
 
   void DataReceiver::OnConnect(ConnectionSPC id){
@@ -33,18 +106,22 @@ namespace eudaq {
     auto con = ev.id;
     bool has_con_for_discon = false;
     switch (ev.etype) {
-    case (TransportEvent::CONNECT):
-      m_dataserver->SendPacket("OK EUDAQ DATA DataReceiver", *con, true);
+    case (TransportEvent::CONNECT): {
+      //the optional words which follow are the features of this DataReceiver
+      std::string greeting = "OK EUDAQ DATA DataReceiver PACK";
+      double rate = m_target_rate;
+      if(rate > 0)
+	greeting += " RATE=" + std::to_string(rate);
+      m_dataserver->SendPacket(greeting, *con, true);
       break;
+    }
     case (TransportEvent::DISCONNECT):
       con->SetState(0);
       EUDAQ_INFO("DataReceiver: Disconnected from " + to_string(*con));
       for (size_t i = 0; i < m_vt_con.size(); ++i){
 	if (m_vt_con[i] == con){
 	  m_vt_con.erase(m_vt_con.begin() + i);
-	  std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-	  m_qu_ev.push(std::make_pair<EventSP, ConnectionSPC>(nullptr, con));
-	  m_cv_not_empty.notify_all();
+	  QueuePacket(con, std::string());
 	  has_con_for_discon = true;
 	}
       }
@@ -53,6 +130,7 @@ namespace eudaq {
       break;
     case (TransportEvent::RECEIVE):
       if (con->GetState() == 0) { //unidentified connection
+	bool packed = false;
         do {
           size_t i0 = 0, i1 = ev.packet.find(' ');
           if (i1 == std::string::npos)
@@ -82,28 +160,33 @@ namespace eudaq {
           i1 = ev.packet.find(' ', i0);
           part = std::string(ev.packet, i0, i1 - i0);
           con->SetName(part);
+	  //the optional words which follow are the features asked by the sender
+	  while (i1 != std::string::npos) {
+	    i0 = i1 + 1;
+	    i1 = ev.packet.find(' ', i0);
+	    if (std::string(ev.packet, i0, i1 - i0) == "PACK")
+	      packed = true;
+	  }
         } while (false);
         m_dataserver->SendPacket("OK", *con, true);
         con->SetState(1); // successfully identified
 	EUDAQ_INFO("DataReceiver: Connection from " + to_string(*con));
 	m_vt_con.push_back(con);
-	std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-	m_qu_ev.push(std::make_pair<EventSP, ConnectionSPC>(nullptr, con));
-	m_cv_not_empty.notify_all();
+	std::unique_lock<std::mutex> lk(m_mx_qu_stat);
+	auto &stat = m_qu_stat[con.get()];
+	stat.reset(new QueueStat);
+	stat->name = con->GetType() + "." + con->GetName();
+	stat->con = con;
+	stat->packed = packed;
+	stat->n = 0;
+	stat->hw = 0;
+	stat->seq_in = 0;
+	stat->seq_out = 0;
+	lk.unlock();
+	QueuePacket(con, std::string());
       }
       else{ //identified connection  
-	BufferSerializer ser(ev.packet.begin(), ev.packet.end());
-	uint32_t id;
-	ser.PreRead(id);
-	auto ev_con = std::make_pair<EventSP, ConnectionSPC>
-	  (Factory<Event>::MakeUnique<Deserializer&>(id, ser), con);
-	std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-	m_qu_ev.push(ev_con);
-	if(m_qu_ev.size() > 50000){
-	  m_qu_ev.pop();
-	  EUDAQ_WARN("DataReceiver: Buffer of receving event is full.");
-	}
-	m_cv_not_empty.notify_all();
+	QueuePacket(con, std::move(ev.packet));
       }
       break;
     default:
@@ -111,6 +194,389 @@ namespace eudaq {
     }
   }
 
+  EventSP DataReceiver::DeserializeEvent(const unsigned char *data, size_t size){
+    BufferDeserializer ser(data, size);
+    uint32_t id;
+    ser.PreRead(id);
+    return MakePoolShared(Factory<Event>::MakeUnique<Deserializer&>(id, ser));
+  }
+
+  size_t DataReceiver::GetPacketEventN(const std::string &packet, bool packed){
+    if(packet.empty())
+      return 0;
+    if(!packed || packet.size() < sizeof(uint32_t))
+      return 1;
+    //each packed event takes at least its size word
+    uint32_t n;
+    std::memcpy(&n, packet.data(), sizeof(n));
+    return std::min<size_t>(n, packet.size() / sizeof(uint32_t) - 1);
+  }
+
+  void DataReceiver::DeserializePacket(const std::string &packet, bool packed,
+				       std::vector<EventSP> &evs){
+    //the events which can not be rebuilt are left empty
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(packet.data());
+    evs.assign(GetPacketEventN(packet, packed), nullptr);
+    try{
+      if(!packed){
+	if(!evs.empty())
+	  evs[0] = DeserializeEvent(data, packet.size());
+	return;
+      }
+      BufferDeserializer ser(data, packet.size());
+      ser.read<uint32_t>();
+      for(auto &ev: evs){
+	uint32_t size = ser.read<uint32_t>();
+	const unsigned char *ev_data = ser.Take(size);
+	try{
+	  ev = DeserializeEvent(ev_data, size);
+	}
+	catch(const std::exception &e){
+	  EUDAQ_WARN(std::string("DataReceiver: ") + e.what());
+	}
+      }
+    }
+    catch(const std::exception &e){
+      EUDAQ_WARN(std::string("DataReceiver: ") + e.what());
+    }
+  }
+
+  void DataReceiver::QueuePacket(ConnectionSPC con, std::string &&packet){
+    //an empty packet stands for a connection or disconnection
+    std::shared_ptr<QueueStat> stat;
+    std::unique_lock<std::mutex> lk_stat(m_mx_qu_stat);
+    auto it = m_qu_stat.find(con.get());
+    if(it != m_qu_stat.end())
+      stat = it->second;
+    lk_stat.unlock();
+    bool packed = stat && stat->packed;
+    if(stat){
+      uint64_t n = stat->n += std::max<size_t>(GetPacketEventN(packet, packed), 1);
+      uint64_t hw = stat->hw;
+      while(n > hw && !stat->hw.compare_exchange_weak(hw, n));
+    }
+
+    if(!m_dsr_n || !stat){
+      QueueItem item;
+      item.con = con;
+      item.stat = stat;
+      if(packet.empty()){
+	PushEvent(item);
+	return;
+      }
+      std::vector<EventSP> evs;
+      DeserializePacket(packet, packed, evs);
+      if(evs.empty()){
+	if(stat)
+	  stat->n--;
+	m_dropped_n++;
+      }
+      for(auto &ev: evs){
+	if(!ev){
+	  if(stat)
+	    stat->n--;
+	  m_dropped_n++;
+	  EUDAQ_WARN("DataReceiver: Unable to deserialize the event from "
+		     + to_string(*con));
+	  continue;
+	}
+	item.ev = std::move(ev);
+	item.con = con;
+	item.stat = stat;
+	PushEvent(item);
+      }
+      return;
+    }
+
+    RawItem raw;
+    raw.packet = std::move(packet);
+    raw.con = std::move(con);
+    raw.stat = stat;
+    raw.seq = stat->seq_in++;
+    //events of a connection waiting for an earlier one are bounded as well
+    bool pushed = raw.seq - stat->seq_out < m_qu_raw->Capacity()
+      && m_qu_raw->TryPush(std::move(raw));
+    while(!pushed){
+      if(!m_is_listening){
+	stat->n--;
+	m_dropped_n++;
+	EUDAQ_WARN("DataReceiver: Buffer of receving packet is full while stopping");
+	return;
+      }
+      std::unique_lock<std::mutex> lk(m_mx_qu_raw);
+      m_raw_waiting = true;
+      pushed = raw.seq - stat->seq_out < m_qu_raw->Capacity()
+	&& m_qu_raw->TryPush(std::move(raw));
+      if(!pushed)
+	m_cv_raw_not_full.wait_for(lk, std::chrono::milliseconds(100));
+      m_raw_waiting = false;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_dsr_waiting){
+      std::unique_lock<std::mutex> lk(m_mx_qu_raw);
+      m_cv_raw_not_empty.notify_one();
+    }
+  }
+
+  bool DataReceiver::PopPacket(RawItem &raw){
+    bool popped = m_qu_raw->TryPop(raw);
+    if(!popped){
+      std::unique_lock<std::mutex> lk(m_mx_qu_raw);
+      m_dsr_waiting++;
+      popped = m_qu_raw->TryPop(raw);
+      if(!popped){
+	m_cv_raw_not_empty.wait_for(lk, std::chrono::milliseconds(100));
+	popped = m_qu_raw->TryPop(raw);
+      }
+      m_dsr_waiting--;
+    }
+    if(!popped)
+      return false;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_raw_waiting){
+      std::unique_lock<std::mutex> lk(m_mx_qu_raw);
+      m_cv_raw_not_full.notify_all();
+    }
+    return true;
+  }
+
+  void DataReceiver::CommitEvents(uint64_t seq, std::vector<QueueItem> &items){
+    //forward the events of a connection in the order they were received
+    auto stat = items.front().stat;
+    std::unique_lock<std::mutex> lk(stat->mx);
+    if(seq != stat->seq_out){
+      stat->pending[seq] = std::move(items);
+      return;
+    }
+    while(true){
+      for(auto &item: items){
+	if(item.con)
+	  PushEvent(item);
+	else{
+	  stat->n--;
+	  m_dropped_n++;
+	}
+      }
+      stat->seq_out++;
+      auto it = stat->pending.find(stat->seq_out);
+      if(it == stat->pending.end())
+	break;
+      items = std::move(it->second);
+      stat->pending.erase(it);
+    }
+    lk.unlock();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_raw_waiting){
+      std::unique_lock<std::mutex> lk_raw(m_mx_qu_raw);
+      m_cv_raw_not_full.notify_all();
+    }
+  }
+
+  bool DataReceiver::AsyncDeserializing(){
+    try{
+      RawItem raw;
+      std::vector<EventSP> evs;
+      std::vector<QueueItem> items;
+      while(true){
+	bool is_rcv_return = m_is_async_rcv_return;
+	if(!PopPacket(raw)){
+	  if(is_rcv_return)
+	    break;
+	  continue;
+	}
+	QueueItem item;
+	item.con = raw.con;
+	item.stat = raw.stat;
+	if(raw.packet.empty())
+	  items.push_back(std::move(item));
+	else{
+	  DeserializePacket(raw.packet, raw.stat->packed, evs);
+	  for(auto &ev: evs){
+	    items.push_back(item);
+	    if(!ev){
+	      EUDAQ_WARN("DataReceiver: Unable to deserialize the event from "
+			 + to_string(*raw.con));
+	      items.back().con.reset(); //skipped, but keeps the sequence going
+	    }
+	    items.back().ev = std::move(ev);
+	  }
+	  if(items.empty()){
+	    //a packet without any event still takes its place in the sequence
+	    items.push_back(std::move(item));
+	    items.back().con.reset();
+	  }
+	}
+	CommitEvents(raw.seq, items);
+	items.clear();
+	raw = RawItem();
+      }
+    }
+    catch(...){
+      m_dsr_running--;
+      throw;
+    }
+    m_dsr_running--;
+    return 0;
+  }
+
+  void DataReceiver::PushEvent(QueueItem &item){
+    auto stat = item.stat;
+    bool pushed = false;
+    if(m_policy == POLICY_SPILL){
+      // once spilling has started, new events go behind the spilled ones
+      if(m_spill_n == 0)
+	pushed = m_qu_ev->TryPush(std::move(item));
+      if(!pushed){
+	SpillEvent(item);
+	pushed = true;
+      }
+    }
+    else{
+      bool droppable = m_policy == POLICY_LOSSY && item.ev
+	&& !item.ev->IsBORE() && !item.ev->IsEORE();
+      pushed = m_qu_ev->TryPush(std::move(item));
+      while(!pushed){
+	if(droppable || !m_is_listening){
+	  if(stat)
+	    stat->n--;
+	  uint64_t dropped_n = ++m_dropped_n;
+	  if(dropped_n == 1 || dropped_n % 10000 == 0)
+	    EUDAQ_WARN("DataReceiver: Buffer of receving event is full, "
+		       + std::to_string(dropped_n) + " events have been dropped");
+	  break;
+	}
+	std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+	m_rcv_waiting++;
+	pushed = m_qu_ev->TryPush(std::move(item));
+	if(!pushed)
+	  m_cv_not_full.wait_for(lk, std::chrono::milliseconds(100));
+	m_rcv_waiting--;
+      }
+    }
+    
+    // only wake up the forwarding thread if it went to sleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(pushed && m_fwd_waiting){
+      std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+      m_cv_not_empty.notify_one();
+    }
+  }
+
+  bool DataReceiver::PopEvent(QueueItem &item){
+    bool popped = m_qu_ev->TryPop(item) || UnspillEvent(item);
+    if(!popped){
+      std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+      m_fwd_waiting = true;
+      popped = m_qu_ev->TryPop(item) || UnspillEvent(item);
+      if(!popped){
+	m_cv_not_empty.wait_for(lk, std::chrono::milliseconds(100));
+	popped = m_qu_ev->TryPop(item) || UnspillEvent(item);
+      }
+      m_fwd_waiting = false;
+    }
+    if(!popped)
+      return false;
+    if(item.stat)
+      item.stat->n--;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_rcv_waiting){
+      std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+      m_cv_not_full.notify_all();
+    }
+    return true;
+  }
+
+  void DataReceiver::SpillEvent(QueueItem &item){
+    BufferSerializer ser;
+    if(item.ev)
+      item.ev->Serialize(ser);
+    std::unique_lock<std::mutex> lk(m_mx_spill);
+    if(!m_spill_file){
+      m_spill_file = std::tmpfile();
+      if(!m_spill_file)
+	EUDAQ_THROW("DataReceiver: Unable to create the spill file");
+      m_spill_offset = 0;
+    }
+    SpillItem sp;
+    sp.con = item.con;
+    sp.stat = item.stat;
+    sp.offset = m_spill_offset;
+    sp.size = ser.size();
+    if(sp.size){
+      if(std::fseek(m_spill_file, sp.offset, SEEK_SET) ||
+	 std::fwrite(&ser[0], 1, sp.size, m_spill_file) != sp.size)
+	EUDAQ_THROW("DataReceiver: Unable to write to the spill file");
+      m_spill_offset += sp.size;
+      m_spilled_n++;
+    }
+    if(m_spill.empty())
+      EUDAQ_WARN("DataReceiver: Buffer of receving event is full, spilling to disk");
+    m_spill.push_back(sp);
+    m_spill_n++;
+  }
+
+  bool DataReceiver::UnspillEvent(QueueItem &item){
+    if(m_spill_n == 0)
+      return false;
+    std::unique_lock<std::mutex> lk(m_mx_spill);
+    if(m_spill.empty())
+      return false;
+    SpillItem sp = m_spill.front();
+    std::vector<unsigned char> data(sp.size);
+    if(sp.size){
+      if(std::fseek(m_spill_file, sp.offset, SEEK_SET) ||
+	 std::fread(&data[0], 1, sp.size, m_spill_file) != sp.size)
+	EUDAQ_THROW("DataReceiver: Unable to read from the spill file");
+    }
+    m_spill.pop_front();
+    if(m_spill.empty())
+      m_spill_offset = 0;
+    m_spill_n--;
+    lk.unlock();
+
+    item.con = sp.con;
+    item.stat = sp.stat;
+    item.ev.reset();
+    if(sp.size){
+      BufferSerializer ser(data.begin(), data.end());
+      uint32_t id;
+      ser.PreRead(id);
+      item.ev = MakePoolShared(Factory<Event>::MakeUnique<Deserializer&>(id, ser));
+    }
+    return true;
+  }
+
+  size_t DataReceiver::ClearQueue(){
+    size_t n = 0;
+    if(m_qu_raw){
+      RawItem raw;
+      while(m_qu_raw->TryPop(raw))
+	n++;
+    }
+    std::unique_lock<std::mutex> lk_stat(m_mx_qu_stat);
+    for(auto &stat: m_qu_stat){
+      std::unique_lock<std::mutex> lk(stat.second->mx);
+      n += stat.second->pending.size();
+      stat.second->pending.clear();
+    }
+    lk_stat.unlock();
+    if(m_qu_ev){
+      QueueItem item;
+      while(m_qu_ev->TryPop(item))
+	n++;
+    }
+    std::unique_lock<std::mutex> lk(m_mx_spill);
+    n += m_spill.size();
+    m_spill.clear();
+    m_spill_n = 0;
+    m_spill_offset = 0;
+    if(m_spill_file){
+      std::fclose(m_spill_file);
+      m_spill_file = nullptr;
+    }
+    return n;
+  }
+
   bool DataReceiver::AsyncReceiving(){
     m_is_async_rcv_return = false;
     while (m_is_listening){
@@ -121,34 +587,27 @@ namespace eudaq {
   }
 
   bool DataReceiver::AsyncForwarding(){
-    while(!m_is_async_rcv_return){
-      std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-      while(m_qu_ev.empty()){
-	while(m_cv_not_empty.wait_for(lk, std::chrono::seconds(1))
-	      ==std::cv_status::timeout){
-	  if(m_is_async_rcv_return){
-	    for(auto &con: m_vt_con){
-	      OnDisconnect(con);
-	    }
-	    m_vt_con.clear();
-	    return 0;
-	  }
-	}
+    QueueItem item;
+    while(true){
+      //nothing can be queued anymore once the receiving and deserializing
+      //threads have returned
+      bool is_rcv_return = m_is_async_rcv_return && !m_dsr_running;
+      if(!PopEvent(item)){
+	if(is_rcv_return)
+	  break;
+	continue;
       }
-      auto ev = m_qu_ev.front().first;
-      auto con = m_qu_ev.front().second;
-      m_qu_ev.pop();
-      lk.unlock();
-      if(ev){
-	OnReceive(con, ev);
+      if(item.ev){
+	OnReceive(item.con, item.ev);
       }
       else{
-	if(con->GetState())
-	  OnConnect(con);
+	if(item.con->GetState())
+	  OnConnect(item.con);
 	else{
-	  OnDisconnect(con);
+	  OnDisconnect(item.con);
 	}
       }
+      item = QueueItem();
     }
     //clear remaining connections
     for(auto &con: m_vt_con){
@@ -174,11 +633,24 @@ namespace eudaq {
 
     auto dataserver = TransportServer::CreateServer(this_addr);
     dataserver->SetCallback(TransportCallback(this, &DataReceiver::DataHandler));
+    dataserver->SetSocketOptions(m_sockopt);
     
     m_last_addr = dataserver->ConnectionString();
     m_dataserver.reset(dataserver);
+    m_qu_ev.reset(new LockFreeQueue<QueueItem>(m_qu_size));
+    m_qu_raw.reset(new LockFreeQueue<RawItem>(m_qu_size));
+    std::unique_lock<std::mutex> lk_stat(m_mx_qu_stat);
+    m_qu_stat.clear();
+    lk_stat.unlock();
+    m_dropped_n = 0;
+    m_spilled_n = 0;
     m_is_listening = true;
     m_is_async_rcv_return = false;
+    m_dsr_running = m_dsr_n;
+    for(size_t i = 0; i < m_dsr_n; ++i){
+      m_fut_async_dsr.push_back(std::async(std::launch::async,
+					   &DataReceiver::AsyncDeserializing, this));
+    }
     m_fut_async_rcv = std::async(std::launch::async, &DataReceiver::AsyncReceiving, this); 
     m_fut_async_fwd = std::async(std::launch::async, &DataReceiver::AsyncForwarding, this);
     return m_last_addr;
@@ -187,7 +659,7 @@ namespace eudaq {
   void DataReceiver::StopListen(){
     m_is_listening = false;
     auto tp_stop = std::chrono::steady_clock::now();    
-    while( m_fut_async_rcv.valid() || m_fut_async_fwd.valid()){
+    while( m_fut_async_rcv.valid() || m_fut_async_fwd.valid() || m_dsr_running){
       std::this_thread::sleep_for(std::chrono::milliseconds(100));
       if((std::chrono::steady_clock::now()-tp_stop) > std::chrono::seconds(10)){
 	EUDAQ_THROW("DataReceiver: Unable to stop the data receving/forwarding threads");
@@ -206,6 +678,11 @@ namespace eudaq {
 	     m_fut_async_rcv.wait_for(t)!=std::future_status::timeout){
 	    m_fut_async_rcv.get();
 	  }
+	  for(auto &fut: m_fut_async_dsr){
+	    if(fut.valid() && fut.wait_for(t)!=std::future_status::timeout){
+	      fut.get();
+	    }
+	  }
 	  if(m_fut_async_fwd.valid() &&
 	     m_fut_async_fwd.wait_for(t)!=std::future_status::timeout){
 	    m_fut_async_fwd.get();
@@ -221,12 +698,17 @@ namespace eudaq {
 	  if(m_fut_async_rcv.valid()){
 	    m_fut_async_rcv.get();
 	  }
+	  for(auto &fut: m_fut_async_dsr){
+	    if(fut.valid()){
+	      fut.get();
+	    }
+	  }
+	  m_fut_async_dsr.clear();
 	  if(m_fut_async_fwd.valid()){
 	    m_fut_async_fwd.get();
 	  }
-	  if(!m_qu_ev.empty()){
+	  if(ClearQueue()){
 	    EUDAQ_WARN("DataReceiver: Data buffer is not empty during the stopping");
-	    m_qu_ev = std::queue<std::pair<EventSP, ConnectionSPC>>();
 	  }
 	  if(m_dataserver)
 	    m_dataserver.reset();
@@ -242,12 +724,17 @@ namespace eudaq {
       if(m_fut_async_rcv.valid()){
 	m_fut_async_rcv.get();
       }
+      for(auto &fut: m_fut_async_dsr){
+	if(fut.valid()){
+	  fut.get();
+	}
+      }
+      m_fut_async_dsr.clear();
       if(m_fut_async_fwd.valid()){
 	m_fut_async_fwd.get();
       }
-      if(!m_qu_ev.empty()){
+      if(ClearQueue()){
 	EUDAQ_WARN("DataReceiver: Data buffer is not empty during the exiting");
-	m_qu_ev = std::queue<std::pair<EventSP, ConnectionSPC>>();
       }
       if(m_dataserver)
 	m_dataserver.reset();
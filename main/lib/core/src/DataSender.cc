@@ -5,25 +5,95 @@
 #include "eudaq/Logger.hh"
 #include "eudaq/DataSender.hh"
 
+#include <algorithm>
+
 namespace eudaq {
 
   DataSender::DataSender(const std::string & type, const std::string & name)
     : m_type(type),
     m_name(name),
-    m_packetCounter(0) {}
+    m_packetCounter(0),
+    m_is_connected(false),
+    m_async(true),
+    m_batch(64),
+    m_pack_n(1),
+    m_pack_linger(0),
+    m_packed(false),
+    m_target_rate(0),
+    m_policy(POLICY_BLOCK),
+    m_ring(4096),
+    m_ring_head(0),
+    m_ring_n(0),
+    m_busy(false),
+    m_dropped_n(0),
+    m_bytes_sent(0),
+    m_bytes_last(0),
+    m_tp_last(std::chrono::steady_clock::now()){}
 
 
   DataSender::~DataSender(){
     std::cout<<"dataSender clearing"<<std::endl;
     m_is_connected = false;
+    m_cv_not_empty.notify_all();
     if(m_fut_async.valid()){
-      m_fut_async.get();
+      try{
+	m_fut_async.get();
+      }
+      catch(...){
+	EUDAQ_WARN("DataSender:: exception from sending thread during clearing");
+      }
     }
     std::cout<< "dataSender cleared"<<std::endl;
   }
 
+  void DataSender::SetAsync(bool async){
+    if(m_is_connected)
+      EUDAQ_THROW("DataSender:: SetAsync can not be called after Connect");
+    m_async = async;
+  }
+
+  void DataSender::SetQueueSize(size_t n){
+    if(m_is_connected)
+      EUDAQ_THROW("DataSender:: SetQueueSize can not be called after Connect");
+    m_ring.assign(n ? n : 1, QueuedEvent());
+  }
+
+  void DataSender::SetBatchSize(size_t n){
+    m_batch = n ? n : 1;
+  }
+
+  void DataSender::SetPacking(size_t n, std::chrono::microseconds linger){
+    if(m_is_connected)
+      EUDAQ_THROW("DataSender:: SetPacking can not be called after Connect");
+    m_pack_n = n ? n : 1;
+    m_pack_linger = linger;
+  }
+
+  void DataSender::SetSocketOptions(const SocketOptions &opt){
+    if(m_is_connected)
+      EUDAQ_THROW("DataSender:: SetSocketOptions can not be called after Connect");
+    m_sockopt = opt;
+  }
+
+  void DataSender::SetOverflowPolicy(OverflowPolicy policy){
+    m_policy = policy;
+  }
+
+  void DataSender::SetOverflowPolicy(const std::string & policy){
+    std::string p = lcase(policy);
+    if(p == "block")
+      m_policy = POLICY_BLOCK;
+    else if(p == "drop_oldest")
+      m_policy = POLICY_DROP_OLDEST;
+    else if(p == "drop_newest")
+      m_policy = POLICY_DROP_NEWEST;
+    else
+      EUDAQ_THROW("DataSender:: Unknown overflow policy: " + policy);
+  }
+
   void DataSender::Connect(const std::string & server) {
     m_is_connected = false;
+    m_cv_not_empty.notify_all();
     try{
       if(m_fut_async.valid()){
 	m_fut_async.get();
@@ -33,11 +103,20 @@ namespace eudaq {
     catch(...){
       EUDAQ_WARN("DataSender:: connection execption from disconnetion");
     }
+    m_failure = nullptr;
     
-    std::unique_lock<std::mutex> lk(m_mx_qu_ev);    
-    m_qu_ev = std::queue<EventSPC>();    
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    std::fill(m_ring.begin(), m_ring.end(), QueuedEvent());
+    m_ring_head = 0;
+    m_ring_n = 0;
+    m_busy = false;
     lk.unlock();
+    m_dropped_n = 0;
+    m_bytes_sent = 0;
+    m_bytes_last = 0;
+    m_tp_last = std::chrono::steady_clock::now();
     m_dataclient.reset(TransportClient::CreateClient(server));
+    m_dataclient->SetSocketOptions(m_sockopt);
     std::string packet;
     if (!m_dataclient->ReceivePacket(&packet, 1000000))
       EUDAQ_THROW("DataSender:: No response from DataReceiver server");
@@ -66,8 +145,23 @@ namespace eudaq {
     part = std::string(packet, i0, i1-i0);
     if (part != "DataReceiver" && part != "DataCollector" && part != "Monitor" )
       EUDAQ_THROW("DataSender:: Invalid response from DataReceiver server, part=" + part);
+    //the optional words which follow are the features of the DataReceiver
+    bool can_pack = false;
+    m_target_rate = 0;
+    while(i1 != std::string::npos){
+      i0 = i1+1;
+      i1 = packet.find(' ', i0);
+      std::string feature(packet, i0, i1-i0);
+      if(feature == "PACK")
+	can_pack = true;
+      else if(feature.compare(0, 5, "RATE=") == 0)
+	m_target_rate = from_string(feature.substr(5), 0.0);
+    }
+    m_packed = m_async && m_pack_n > 1 && can_pack;
+    if(m_async && m_pack_n > 1 && !can_pack)
+      EUDAQ_INFO("DataSender:: DataReceiver does not support packing, sending one event per packet");
 
-    m_dataclient->SendPacket("OK EUDAQ DATA " + m_type + " " + m_name);
+    m_dataclient->SendPacket("OK EUDAQ DATA " + m_type + " " + m_name + (m_packed ? " PACK" : ""));
     packet = "";
     if (!m_dataclient->ReceivePacket(&packet, 1000000))
       EUDAQ_THROW("DataSender:: No response from DataReceiver server");
@@ -75,52 +169,206 @@ namespace eudaq {
     if (std::string(packet, 0, i1) != "OK")
       EUDAQ_THROW("DataSender:: Connection refused by DataReceiver server: " + packet);
     m_is_connected = true;
-    m_fut_async = std::async(std::launch::async, &DataSender::AsyncSending, this);
+    if(m_async)
+      m_fut_async = std::async(std::launch::async, &DataSender::AsyncSending, this);
   }
 
-  void DataSender::SendEvent(EventSPC ev){
+  void DataSender::SendEvent(EventSPC ev, BufferSerializerSPC ser){
     if (!m_dataclient)
       EUDAQ_THROW("DataSender:: Transport not connected error");
 
-    /*
+    if(!m_async){
+      if(!ser){
+	auto own = std::make_shared<BufferSerializer>();
+	ev->Serialize(*own);
+	ser = own;
+      }
+      m_packetCounter += 1;
+      //TODO: catch exception below
+      m_dataclient->SendPacket(*ser);
+      m_bytes_sent += ser->size() + 4;
+      return;
+    }
+
+    CheckAsyncSending();
+    bool droppable = !ev->IsBORE() && !ev->IsEORE();
     std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-    m_qu_ev.push(ev);
-    if(m_qu_ev.size() > 50000){
-      m_qu_ev.pop();
-      EUDAQ_WARN("DataSender:: Buffer of sending event is full.");
-    }    
-    m_cv_not_empty.notify_all();
-    */
+    while(m_ring_n == m_ring.size()){
+      if(droppable && m_policy == POLICY_DROP_NEWEST){
+	lk.unlock();
+	if(m_dropped_n++ == 0)
+	  EUDAQ_WARN("DataSender:: Buffer of sending event is full, dropping the newest events.");
+	return;
+      }
+      if(droppable && m_policy == POLICY_DROP_OLDEST){
+	auto &oldest = m_ring[m_ring_head];
+	if(!oldest.ev->IsBORE() && !oldest.ev->IsEORE()){
+	  oldest = QueuedEvent();
+	  m_ring_head = (m_ring_head + 1) % m_ring.size();
+	  m_ring_n--;
+	  if(m_dropped_n++ == 0)
+	    EUDAQ_WARN("DataSender:: Buffer of sending event is full, dropping the oldest events.");
+	  break;
+	}
+      }
+      if(m_cv_not_full.wait_for(lk, std::chrono::milliseconds(100))
+	 ==std::cv_status::timeout){
+	lk.unlock();
+	CheckAsyncSending();
+	lk.lock();
+      }
+    }
+    auto &slot = m_ring[(m_ring_head + m_ring_n) % m_ring.size()];
+    slot.ev = std::move(ev);
+    slot.ser = std::move(ser);
+    m_ring_n++;
+    lk.unlock();
+    m_cv_not_empty.notify_one();
+  }
 
-    BufferSerializer ser;
-    ev->Serialize(ser);
-    m_packetCounter += 1;
-    //TODO: catch exception below
-    m_dataclient->SendPacket(ser);
+  void DataSender::CheckAsyncSending(){
+    //the failure is kept, every later call throws it again
+    if(!m_failure && m_fut_async.valid() &&
+       m_fut_async.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+      try{
+	m_fut_async.get(); // rethrows the exception from the sending thread
+	EUDAQ_THROW("DataSender:: Sending thread is not running");
+      }
+      catch(...){
+	m_failure = std::current_exception();
+      }
+    }
+    if(m_failure)
+      std::rethrow_exception(m_failure);
+  }
+
+  void DataSender::Flush(){
+    if(!m_async){
+      CheckAsyncSending();
+      return;
+    }
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    while(m_ring_n || m_busy){
+      if(m_cv_not_full.wait_for(lk, std::chrono::milliseconds(100))
+	 ==std::cv_status::timeout){
+	lk.unlock();
+	CheckAsyncSending();
+	lk.lock();
+      }
+    }
+    lk.unlock();
+    CheckAsyncSending();
   }
 
   bool DataSender::AsyncSending(){
-    while(m_is_connected){//TODO:
+    std::vector<QueuedEvent> batch;
+    std::vector<BufferSerializer> packets;
+    std::vector<PacketRef> refs;
+    BufferSerializer ser;
+    for(;;){
       std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-      while(m_qu_ev.empty()){
-	while(m_cv_not_empty.wait_for(lk, std::chrono::milliseconds(100))
-	      ==std::cv_status::timeout){
-	  if(!m_is_connected){
-	    return false;
+      while(m_ring_n == 0){
+	// queued events are always sent before stopping
+	if(!m_is_connected)
+	  return true;
+	m_cv_not_empty.wait_for(lk, std::chrono::milliseconds(100));
+      }
+      if(m_packed && m_pack_linger.count()){
+	auto tp_end = std::chrono::steady_clock::now() + m_pack_linger;
+	while(m_ring_n < m_pack_n && m_ring_n < m_ring.size() && m_is_connected
+	      && m_cv_not_empty.wait_until(lk, tp_end) == std::cv_status::no_timeout);
+      }
+      size_t n = std::min(m_ring_n, m_packed ? m_batch * m_pack_n : m_batch);
+      for(size_t i = 0; i < n; i++){
+	batch.push_back(std::move(m_ring[m_ring_head]));
+	m_ring_head = (m_ring_head + 1) % m_ring.size();
+      }
+      m_ring_n -= n;
+      m_busy = true;
+      lk.unlock();
+      m_cv_not_full.notify_all();
+
+      uint64_t bytes = 0;
+      refs.clear();
+      if(!m_packed){
+	//the shared serializations go out as they are, without a copy
+	packets.resize(n);
+	for(size_t i = 0; i < n; i++){
+	  const BufferSerializer *packet = batch[i].ser.get();
+	  if(!packet){
+	    packets[i].clear();
+	    batch[i].ev->Serialize(packets[i]);
+	    packet = &packets[i];
 	  }
+	  refs.push_back(PacketRef{packet->data(), packet->size()});
+	  bytes += packet->size() + 4;
 	}
       }
-      auto ev = m_qu_ev.front();
-      m_qu_ev.pop();
+      else{
+	//number of events, then the size and the bytes of each event
+	packets.resize((n + m_pack_n - 1) / m_pack_n);
+	for(size_t p = 0; p < packets.size(); p++){
+	  auto &packet = packets[p];
+	  size_t i0 = p * m_pack_n;
+	  size_t i1 = std::min(n, i0 + m_pack_n);
+	  packet.clear();
+	  packet.write(uint32_t(i1 - i0));
+	  for(size_t i = i0; i < i1; i++){
+	    const BufferSerializer *evser = batch[i].ser.get();
+	    if(!evser){
+	      ser.clear();
+	      batch[i].ev->Serialize(ser);
+	      evser = &ser;
+	    }
+	    packet.write(uint32_t(evser->size()));
+	    if(evser->size())
+	      packet.append(evser->data(), evser->size());
+	  }
+	  refs.push_back(PacketRef{packet.data(), packet.size()});
+	  bytes += packet.size() + 4;
+	}
+      }
+      m_dataclient->SendPackets(refs);
+      batch.clear();
+      m_packetCounter += n;
+      m_bytes_sent += bytes;
+      lk.lock();
+      m_busy = false;
       lk.unlock();
-      BufferSerializer ser;
-      ev->Serialize(ser);
-      m_packetCounter += 1;
-      //TODO: catch exception below
-      m_dataclient->SendPacket(ser);
+      m_cv_not_full.notify_all();
     }
-
     return true;
   }
 
+  size_t DataSender::GetQueueDepth(){
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    return m_ring_n;
+  }
+
+  size_t DataSender::GetQueueSize() const{
+    return m_ring.size();
+  }
+
+  double DataSender::GetTargetRate() const{
+    return m_target_rate;
+  }
+
+  uint64_t DataSender::GetDroppedN() const{
+    return m_dropped_n;
+  }
+
+  uint64_t DataSender::GetBytesSent() const{
+    return m_bytes_sent;
+  }
+
+  double DataSender::GetByteRate(){
+    auto tp_now = std::chrono::steady_clock::now();
+    uint64_t bytes = m_bytes_sent;
+    double dt = std::chrono::duration<double>(tp_now - m_tp_last).count();
+    double rate = (dt > 0 && bytes >= m_bytes_last) ? (bytes - m_bytes_last) / dt : 0;
+    m_bytes_last = bytes;
+    m_tp_last = tp_now;
+    return rate;
+  }
+
 }
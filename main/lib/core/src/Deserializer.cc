@@ -1,5 +1,7 @@
 #include "eudaq/Deserializer.hh"
 
+#include <algorithm>
+
 namespace eudaq{
   Deserializer::Deserializer()
     :m_interrupting(false){
@@ -30,4 +32,22 @@ namespace eudaq{
     PreDeserialize(dst, size);
   }
 
+  size_t Deserializer::PeekSpan(const uint8_t *&data){
+    data = nullptr;
+    return 0;
+  }
+
+  std::shared_ptr<const void> Deserializer::GetSpanOwner(){
+    return nullptr;
+  }
+
+  void Deserializer::Skip(size_t size){
+    unsigned char buf[4096];
+    while(size){
+      size_t n = std::min(size, sizeof(buf));
+      Deserialize(buf, n);
+      size -= n;
+    }
+  }
+
 }
@@ -2,6 +2,9 @@
 #include "eudaq/BufferSerializer.hh"
 #include "eudaq/Logger.hh"
 
+#include <algorithm>
+#include <cstring>
+
 namespace eudaq {
   
   template class DLLEXPORT Factory<Event>;
@@ -21,15 +24,14 @@ namespace eudaq {
   }
 
   EventSP Event::MakeShared(const std::string& dspt){
-    EventSP ev = MakeUnique(dspt);
-    return ev;
+    return MakePoolShared(MakeUnique(dspt));
   }
 
   EventSP Event::Make(const std::string& type, const std::string& argv){
     // auto ev =  Factory<Event>::MakeShared<const std::string&,const std::string&>
     //   (str2hash(type), argv);
     uint32_t typehash = str2hash(type);
-    auto ev =  Factory<Event>::MakeShared<>(str2hash(type));
+    EventSP ev = MakePoolShared(Factory<Event>::MakeUnique<>(str2hash(type)));
     if(typehash == cstr2hash("RawEvent")){
       ev->SetType(typehash);
       ev->SetExtendWord(eudaq::str2hash(argv));
@@ -39,10 +41,11 @@ namespace eudaq {
   }
   
   Event::Event()
-    :m_type(0), m_version(2), m_flags(0), m_stm_n(0), m_run_n(0), m_ev_n(0), m_tg_n(0), m_extend(0), m_ts_begin(0), m_ts_end(0){
+    :m_type(0), m_version(2), m_flags(0), m_stm_n(0), m_run_n(0), m_ev_n(0), m_tg_n(0), m_extend(0), m_ts_begin(0), m_ts_end(0), m_block_unused(0), m_block_ext(nullptr){
   }  
   
-  Event::Event(Deserializer & ds) {
+  Event::Event(Deserializer & ds)
+    :m_block_unused(0), m_block_ext(nullptr){
     ds.read(m_type);
     ds.read(m_version);
     ds.read(m_flags);
@@ -55,16 +58,83 @@ namespace eudaq {
     ds.read(m_ts_end);
     ds.read(m_dspt);
     ds.read(m_tags);
-    ds.read(m_blocks);
+    //same layout as a std::map<uint32_t, std::vector<uint8_t>>
+    uint32_t n_block;
+    ds.read(n_block);
+    m_block_table.reserve(n_block);
+    //with the data in memory, the buffer is sized from the block headers
+    bool sized = false;
+    const uint8_t *span;
+    size_t span_n = ds.PeekSpan(span);
+    if(span_n){
+      size_t total = 0;
+      size_t pos = 0;
+      uint32_t i = 0;
+      for(; i < n_block && pos + 8 <= span_n; i++){
+	uint32_t len = 0;
+	for(size_t k = 0; k < 4; k++)
+	  len |= uint32_t(span[pos + 4 + k]) << (8 * k);
+	total += len;
+	pos += 8 + size_t(len);
+      }
+      if(i == n_block && pos <= span_n){
+	auto owner = ds.GetSpanOwner();
+	if(owner && n_block){
+	  m_block_owner = owner;
+	  m_block_ext = span;
+	}
+	else
+	  m_block_data.reserve(total);
+	sized = true;
+      }
+    }
+    //the blocks stay where they are, the table holds their offsets in the span
+    size_t offset = 0;
+    for(; m_block_ext && n_block>0; n_block--){
+      uint32_t id;
+      uint32_t len;
+      ds.read(id);
+      ds.read(len);
+      auto it = std::lower_bound(m_block_table.begin(), m_block_table.end(), id,
+				 [](const BlockEntry &e, uint32_t id){return e.id < id;});
+      if(it == m_block_table.end() || it->id != id)
+	it = m_block_table.insert(it, BlockEntry{id, 0, 0});
+      it->offset = offset + 8;
+      it->size = len;
+      offset += 8 + size_t(len);
+      ds.Skip(len);
+    }
+    for(; n_block>0; n_block--){
+      uint32_t id;
+      uint32_t len;
+      ds.read(id);
+      ds.read(len);
+      //the blocks of an event have mostly the same size
+      if(m_block_table.empty() && !sized)
+	m_block_data.reserve(size_t(len) * n_block);
+      uint8_t *block = ReserveBlock(id, len);
+      if(len)
+	ds.read(block, len);
+    }
     uint32_t n_subev;
-    for(ds.read(n_subev); n_subev>0; n_subev--){
+    ds.read(n_subev);
+    m_sub_events.reserve(n_subev);
+    for(; n_subev>0; n_subev--){
       uint32_t evid;
       ds.PreRead(evid);
-      EventSP ev = Factory<Event>::Create<Deserializer&>(evid, ds);
+      EventSP ev = MakePoolShared(Factory<Event>::Create<Deserializer&>(evid, ds));
       m_sub_events.push_back(std::const_pointer_cast<const Event>(ev));
     }
   }
 
+  void *Event::operator new(size_t bytes){
+    return EventPool::Allocate(bytes);
+  }
+
+  void Event::operator delete(void *p, size_t bytes) noexcept{
+    EventPool::Release(p, bytes);
+  }
+
 
   void Event::AddSubEvent(EventSPC ev){
     bool exist = false;
@@ -97,7 +167,13 @@ namespace eudaq {
     ser.write(m_ts_end);
     ser.write(m_dspt);
     ser.write(m_tags);
-    ser.write(m_blocks);
+    ser.write((uint32_t)m_block_table.size());
+    for(auto &e: m_block_table){
+      ser.write(e.id);
+      ser.write(e.size);
+      if(e.size)
+	ser.append(BlockBase() + e.offset, e.size);
+    }
     ser.write((uint32_t)m_sub_events.size());
     for(auto &ev: m_sub_events){
       ser.write(*ev);
@@ -105,20 +181,140 @@ namespace eudaq {
   }
 
   std::vector<uint8_t> Event::GetBlock(uint32_t i) const{
-    auto it = m_blocks.find(i);
-    if(it == m_blocks.end()){
+    return GetBlockView(i).ToVector();
+  }
+
+  BlockView Event::GetBlockView(uint32_t i) const{
+    auto it = FindBlock(i);
+    if(it == m_block_table.end()){
       EUDAQ_WARN(std::string("RAWDATAEVENT:: no bolck with ID ") + std::to_string(i) + " exists");
+      return BlockView();
     }
-    return it->second;
+    return BlockView(BlockBase() + it->offset, it->size);
   }
 
   std::vector<uint32_t> Event::GetBlockNumList() const {
     std::vector<uint32_t> vnum;
-    for(auto &e : m_blocks){
-      vnum.push_back(e.first);
+    for(auto &e : m_block_table){
+      vnum.push_back(e.id);
     }
     return vnum;
   }
+
+  Event::BlockTable::iterator Event::FindBlock(uint32_t id){
+    auto it = std::lower_bound(m_block_table.begin(), m_block_table.end(), id,
+			       [](const BlockEntry &e, uint32_t id){return e.id < id;});
+    return (it != m_block_table.end() && it->id == id) ? it : m_block_table.end();
+  }
+
+  Event::BlockTable::const_iterator Event::FindBlock(uint32_t id) const{
+    auto it = std::lower_bound(m_block_table.begin(), m_block_table.end(), id,
+			       [](const BlockEntry &e, uint32_t id){return e.id < id;});
+    return (it != m_block_table.end() && it->id == id) ? it : m_block_table.end();
+  }
+
+  uint8_t *Event::ReserveBlock(uint32_t id, size_t bytes){
+    auto it = std::lower_bound(m_block_table.begin(), m_block_table.end(), id,
+			       [](const BlockEntry &e, uint32_t id){return e.id < id;});
+    if(it != m_block_table.end() && it->id == id){
+      if(it->offset + it->size != m_block_data.size())
+	m_block_unused += it->size;
+      else
+	m_block_data.resize(it->offset);
+    }
+    else
+      it = m_block_table.insert(it, BlockEntry{id, 0, 0});
+    it->offset = m_block_data.size();
+    it->size = bytes;
+    m_block_data.resize(it->offset + bytes);
+    return m_block_data.data() + it->offset;
+  }
+
+  void Event::SetBlockBytes(uint32_t id, const uint8_t *data, size_t bytes){
+    if(m_block_ext){
+      //the data may be a referenced block, its memory is kept until copied
+      auto owner = m_block_owner;
+      DetachBlocks();
+      SetBlockBytes(id, data, bytes);
+      return;
+    }
+    //the data may be a block of this event, which moves when the buffer grows
+    if(bytes && data >= m_block_data.data() && data < m_block_data.data() + m_block_data.size()){
+      std::vector<uint8_t> copy(data, data + bytes);
+      SetBlockBytes(id, copy.data(), bytes);
+      return;
+    }
+    uint8_t *block = ReserveBlock(id, bytes);
+    if(bytes)
+      std::memcpy(block, data, bytes);
+    if(m_block_unused > m_block_data.size() / 2)
+      CompactBlocks();
+  }
+
+  void Event::AppendBlockBytes(uint32_t id, const uint8_t *data, size_t bytes){
+    if(m_block_ext){
+      auto owner = m_block_owner;
+      DetachBlocks();
+      AppendBlockBytes(id, data, bytes);
+      return;
+    }
+    auto it = FindBlock(id);
+    if(it == m_block_table.end()){
+      SetBlockBytes(id, data, bytes);
+      return;
+    }
+    if(bytes && data >= m_block_data.data() && data < m_block_data.data() + m_block_data.size()){
+      std::vector<uint8_t> copy(data, data + bytes);
+      AppendBlockBytes(id, copy.data(), bytes);
+      return;
+    }
+    if(it->offset + it->size != m_block_data.size()){
+      //only the last block can grow in place, the others are moved to the end
+      size_t offset = m_block_data.size();
+      m_block_data.resize(offset + it->size + bytes);
+      if(it->size)
+	std::memcpy(m_block_data.data() + offset, m_block_data.data() + it->offset, it->size);
+      m_block_unused += it->size;
+      it->offset = offset;
+    }
+    else
+      m_block_data.resize(it->offset + it->size + bytes);
+    if(bytes)
+      std::memcpy(m_block_data.data() + it->offset + it->size, data, bytes);
+    it->size += bytes;
+    if(m_block_unused > m_block_data.size() / 2)
+      CompactBlocks();
+  }
+
+  void Event::CompactBlocks(){
+    BlockData data;
+    data.reserve(m_block_data.size() - m_block_unused);
+    for(auto &e: m_block_table){
+      size_t offset = data.size();
+      data.insert(data.end(), m_block_data.begin() + e.offset,
+		  m_block_data.begin() + e.offset + e.size);
+      e.offset = offset;
+    }
+    m_block_data.swap(data);
+    m_block_unused = 0;
+  }
+
+  void Event::DetachBlocks(){
+    size_t total = 0;
+    for(auto &e: m_block_table)
+      total += e.size;
+    m_block_data.clear();
+    m_block_data.reserve(total);
+    for(auto &e: m_block_table){
+      size_t offset = m_block_data.size();
+      m_block_data.insert(m_block_data.end(), m_block_ext + e.offset,
+			  m_block_ext + e.offset + e.size);
+      e.offset = offset;
+    }
+    m_block_ext = nullptr;
+    m_block_owner.reset();
+    m_block_unused = 0;
+  }
   
   void Event::Print(std::ostream & os, size_t offset) const{
     os << std::string(offset, ' ') << "<Event>\n";
@@ -141,7 +337,7 @@ namespace eudaq {
       }
       os << std::string(offset + 2, ' ') << "</Tags>\n";
     }
-    os << std::string(offset + 2, ' ')<<"<Block_Size>"<<m_blocks.size()<<"</Block_Size>\n";
+    os << std::string(offset + 2, ' ')<<"<Block_Size>"<<m_block_table.size()<<"</Block_Size>\n";
 
     if(!m_sub_events.empty()){
       os << std::string(offset + 2, ' ') << "<SubEvents>\n";
@@ -185,7 +381,7 @@ namespace eudaq {
     
   uint32_t Event::GetNumSubEvent() const {return m_sub_events.size();}
   EventSPC Event::GetSubEvent(uint32_t i) const {return m_sub_events.at(i);}
-  std::vector<EventSPC> Event::GetSubEvents() const {return m_sub_events;}
+  std::vector<EventSPC> Event::GetSubEvents() const {return std::vector<EventSPC>(m_sub_events.begin(), m_sub_events.end());}
     
   void Event::SetType(uint32_t id){m_type = id;}
   void Event::SetVersion(uint32_t v){m_version = v;}
@@ -216,8 +412,8 @@ namespace eudaq {
   uint32_t Event::GetEventNumber()const {return m_ev_n;}
   uint32_t Event::GetRunNumber()const {return m_run_n;}
 
-  size_t Event::GetNumBlock() const { return m_blocks.size(); }
-  size_t Event::NumBlocks() const { return m_blocks.size(); }
+  size_t Event::GetNumBlock() const { return m_block_table.size(); }
+  size_t Event::NumBlocks() const { return m_block_table.size(); }
 
   std::string Event::GetTag(const std::string &name, const char *def) const{
     return GetTag(name, std::string(def));
@@ -0,0 +1,184 @@
+#include "eudaq/EventPool.hh"
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <algorithm>
+
+namespace eudaq {
+  namespace{
+    const size_t CLASS_MIN_SHIFT = 4; // 16 B
+    const size_t CLASS_N = 19;        // up to 4 MB
+    const size_t CACHE_BYTES = 512 * 1024; // per class and thread
+    const size_t SHARED_BYTES = 16 * 1024 * 1024; // per class
+    const uint64_t STAT_FLUSH_N = 1024;
+
+    size_t ClassSize(size_t k){
+      return size_t(1) << (k + CLASS_MIN_SHIFT);
+    }
+
+    size_t ClassOf(size_t bytes){
+      size_t k = 0;
+      while(k < CLASS_N && ClassSize(k) < bytes)
+	k++;
+      return k;
+    }
+
+    size_t CacheN(size_t k){
+      size_t n = CACHE_BYTES / ClassSize(k);
+      return n < 2 ? 2 : n;
+    }
+
+    struct Shared{
+      std::mutex mx;
+      std::vector<void*> free[CLASS_N];
+      std::atomic<bool> enabled;
+      std::atomic<uint64_t> alloc_n;
+      std::atomic<uint64_t> heap_n;
+      std::atomic<int64_t> cached_bytes;
+      Shared():enabled(true), alloc_n(0), heap_n(0), cached_bytes(0){}
+    };
+
+    //never destroyed, the events may outlive the static objects
+    Shared &GetShared(){
+      static Shared *shared = new Shared;
+      return *shared;
+    }
+
+    struct Cache{
+      std::vector<void*> free[CLASS_N];
+      uint64_t alloc_n;
+      uint64_t heap_n;
+      int64_t cached_bytes;
+      Cache():alloc_n(0), heap_n(0), cached_bytes(0){}
+      ~Cache();
+      void FlushStat(){
+	Shared &sh = GetShared();
+	sh.alloc_n += alloc_n;
+	sh.heap_n += heap_n;
+	sh.cached_bytes += cached_bytes;
+	alloc_n = 0;
+	heap_n = 0;
+	cached_bytes = 0;
+      }
+    };
+
+    thread_local Cache t_cache;
+    thread_local bool t_cache_gone = false;
+
+    //moves n entries of class k from the thread cache to the shared list
+    void GiveBack(std::vector<void*> &from, size_t k, size_t n){
+      Shared &sh = GetShared();
+      std::vector<void*> excess;
+      {
+	std::unique_lock<std::mutex> lk(sh.mx);
+	auto &to = sh.free[k];
+	size_t room = SHARED_BYTES / ClassSize(k);
+	for(size_t i = 0; i < n; i++){
+	  if(to.size() < room)
+	    to.push_back(from.back());
+	  else
+	    excess.push_back(from.back());
+	  from.pop_back();
+	}
+      }
+      for(auto p: excess)
+	::operator delete(p);
+      sh.cached_bytes -= int64_t(excess.size() * ClassSize(k));
+    }
+
+    Cache::~Cache(){
+      for(size_t k = 0; k < CLASS_N; k++)
+	GiveBack(free[k], k, free[k].size());
+      FlushStat();
+      t_cache_gone = true;
+    }
+  }
+
+  void *EventPool::Allocate(size_t bytes){
+    size_t k = ClassOf(bytes);
+    Shared &sh = GetShared();
+    if(k == CLASS_N || !sh.enabled || t_cache_gone){
+      sh.alloc_n++;
+      sh.heap_n++;
+      return ::operator new(k == CLASS_N ? bytes : ClassSize(k));
+    }
+    Cache &c = t_cache;
+    if(++c.alloc_n >= STAT_FLUSH_N)
+      c.FlushStat();
+    auto &list = c.free[k];
+    if(list.empty()){
+      std::unique_lock<std::mutex> lk(sh.mx);
+      auto &from = sh.free[k];
+      size_t n = std::min(from.size(), CacheN(k) / 2 + 1);
+      list.insert(list.end(), from.end() - n, from.end());
+      from.resize(from.size() - n);
+    }
+    if(list.empty()){
+      c.heap_n++;
+      return ::operator new(ClassSize(k));
+    }
+    void *p = list.back();
+    list.pop_back();
+    c.cached_bytes -= ClassSize(k);
+    return p;
+  }
+
+  void EventPool::Release(void *p, size_t bytes) noexcept{
+    if(!p)
+      return;
+    size_t k = ClassOf(bytes);
+    Shared &sh = GetShared();
+    if(k == CLASS_N || !sh.enabled || t_cache_gone){
+      ::operator delete(p);
+      return;
+    }
+    Cache &c = t_cache;
+    auto &list = c.free[k];
+    try{
+      list.push_back(p);
+    }catch(...){
+      ::operator delete(p);
+      return;
+    }
+    c.cached_bytes += ClassSize(k);
+    if(list.size() > CacheN(k))
+      GiveBack(list, k, list.size() / 2);
+  }
+
+  void EventPool::SetEnabled(bool enabled){
+    GetShared().enabled = enabled;
+  }
+
+  bool EventPool::IsEnabled(){
+    return GetShared().enabled;
+  }
+
+  void EventPool::Trim(){
+    Shared &sh = GetShared();
+    std::vector<void*> lists[CLASS_N];
+    {
+      std::unique_lock<std::mutex> lk(sh.mx);
+      for(size_t k = 0; k < CLASS_N; k++)
+	lists[k].swap(sh.free[k]);
+    }
+    for(size_t k = 0; k < CLASS_N; k++){
+      for(auto p: lists[k])
+	::operator delete(p);
+      sh.cached_bytes -= int64_t(lists[k].size() * ClassSize(k));
+    }
+  }
+
+  EventPool::Stat EventPool::GetStat(){
+    if(!t_cache_gone)
+      t_cache.FlushStat();
+    Shared &sh = GetShared();
+    Stat st;
+    st.alloc_n = sh.alloc_n;
+    st.heap_n = sh.heap_n;
+    int64_t cached = sh.cached_bytes;
+    st.cached_bytes = cached > 0 ? cached : 0;
+    return st;
+  }
+}
@@ -38,6 +38,17 @@ namespace eudaq {
     return level() > 0;
   }
 
+  uint64_t FileDeserializer::Tell() {
+    return uint64_t(ftell(m_file)) - level();
+  }
+
+  void FileDeserializer::Seek(uint64_t offset) {
+    if (fseek(m_file, offset, SEEK_SET) != 0) {
+      EUDAQ_THROWX(FileReadException, "seek failed: " + m_filename);
+    }
+    m_start = m_stop = &m_buf[0];
+  }
+
   size_t FileDeserializer::FillBuffer(size_t min) {
     clearerr(m_file);
     if (level() == 0)
@@ -0,0 +1,192 @@
+#include "eudaq/FileIndex.hh"
+#include "eudaq/FileSerializer.hh"
+#include "eudaq/FileDeserializer.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Utils.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace eudaq {
+
+  namespace{
+    const char INDEX_MAGIC[8] = {'E', 'U', 'D', 'A', 'Q', 'I', 'D', 'X'};
+    const uint32_t INDEX_VERSION = 1;
+    const size_t INDEX_HEADER_SIZE = 16;
+    const size_t INDEX_ENTRY_SIZE = 36;
+  }
+
+  FileIndexSelection::FileIndexSelection()
+    :event_begin(0), event_end(0), trigger_begin(0), trigger_end(0),
+     ts_begin(0), ts_end(0){
+  }
+
+  bool FileIndexSelection::Contains(const FileIndexEntry &e) const{
+    if((event_begin || event_end) &&
+       (e.event_n < event_begin || e.event_n >= event_end))
+      return false;
+    if((trigger_begin || trigger_end) &&
+       (e.trigger_n < trigger_begin || e.trigger_n >= trigger_end))
+      return false;
+    if((ts_begin || ts_end) && (e.ts_begin < ts_begin || e.ts_end > ts_end))
+      return false;
+    return true;
+  }
+
+  std::string FileIndex::IndexPath(const std::string &datafile){
+    return datafile + ".idx";
+  }
+
+  FileIndex FileIndex::Build(const std::string &datafile){
+    FileIndex idx;
+    FileDeserializer des(datafile);
+    while(des.HasData()){
+      uint64_t offset = des.Tell();
+      uint32_t id;
+      des.PreRead(id);
+      auto ev = Factory<Event>::Create<Deserializer&>(id, des);
+      if(!ev)
+	EUDAQ_THROW("FileIndex: Unknown event type at byte " + to_string(offset)
+		    + " of " + datafile);
+      idx.Add(MakeEntry(offset, *ev));
+    }
+    return idx;
+  }
+
+  void FileIndex::WriteHeader(Serializer &ser){
+    ser.append(reinterpret_cast<const uint8_t*>(INDEX_MAGIC), sizeof(INDEX_MAGIC));
+    ser.write(INDEX_VERSION);
+    ser.write(uint32_t(INDEX_ENTRY_SIZE));
+  }
+
+  void FileIndex::WriteEntry(Serializer &ser, const FileIndexEntry &e){
+    ser.write(e.offset);
+    ser.write(e.event_n);
+    ser.write(e.trigger_n);
+    ser.write(e.stream_n);
+    ser.write(e.ts_begin);
+    ser.write(e.ts_end);
+  }
+
+  FileIndexEntry FileIndex::MakeEntry(uint64_t offset, const Event &ev){
+    FileIndexEntry e;
+    e.offset = offset;
+    e.event_n = ev.GetEventN();
+    e.trigger_n = ev.GetTriggerN();
+    e.stream_n = ev.GetStreamN();
+    e.ts_begin = ev.GetTimestampBegin();
+    e.ts_end = ev.GetTimestampEnd();
+    return e;
+  }
+
+  bool FileIndex::Load(const std::string &path){
+    FILE *fd = std::fopen(path.c_str(), "rb");
+    if(!fd)
+      return false;
+    std::vector<unsigned char> data;
+    unsigned char buf[65536];
+    size_t n;
+    while((n = std::fread(buf, 1, sizeof(buf), fd)) > 0)
+      data.insert(data.end(), buf, buf + n);
+    std::fclose(fd);
+    if(data.size() < INDEX_HEADER_SIZE ||
+       std::memcmp(&data[0], INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+      EUDAQ_THROWX(FileReadException, "FileIndex: Not an index file: " + path);
+    if(getlittleendian<uint32_t>(&data[8]) != INDEX_VERSION ||
+       getlittleendian<uint32_t>(&data[12]) != INDEX_ENTRY_SIZE)
+      EUDAQ_THROWX(FileReadException, "FileIndex: Unsupported index version: " + path);
+    m_entries.clear();
+    m_by_event.clear();
+    m_by_trigger.clear();
+    m_by_ts.clear();
+    //an incomplete last record (writer still running or killed) is ignored
+    size_t n_entries = (data.size() - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE;
+    m_entries.reserve(n_entries);
+    const unsigned char *p = &data[INDEX_HEADER_SIZE];
+    for(size_t i = 0; i < n_entries; ++i, p += INDEX_ENTRY_SIZE){
+      FileIndexEntry e;
+      e.offset = getlittleendian<uint64_t>(p);
+      e.event_n = getlittleendian<uint32_t>(p + 8);
+      e.trigger_n = getlittleendian<uint32_t>(p + 12);
+      e.stream_n = getlittleendian<uint32_t>(p + 16);
+      e.ts_begin = getlittleendian<uint64_t>(p + 20);
+      e.ts_end = getlittleendian<uint64_t>(p + 28);
+      m_entries.push_back(e);
+    }
+    return true;
+  }
+
+  void FileIndex::Save(const std::string &path) const{
+    FileSerializer ser(path, true);
+    WriteHeader(ser);
+    for(auto &e: m_entries)
+      WriteEntry(ser, e);
+    ser.Flush();
+  }
+
+  void FileIndex::Add(const FileIndexEntry &e){
+    m_entries.push_back(e);
+    m_by_event.clear();
+    m_by_trigger.clear();
+    m_by_ts.clear();
+  }
+
+  size_t FileIndex::Size() const{
+    return m_entries.size();
+  }
+
+  const FileIndexEntry &FileIndex::At(size_t i) const{
+    return m_entries.at(i);
+  }
+
+  std::vector<size_t> FileIndex::Select(const FileIndexSelection &sel) const{
+    //look up the first limited key in a sorted view, filter by the others
+    std::vector<size_t> *view = nullptr;
+    uint64_t lo = 0, hi = 0;
+    uint64_t (*key)(const FileIndexEntry&) = nullptr;
+    if(sel.event_begin || sel.event_end){
+      view = &m_by_event;
+      key = [](const FileIndexEntry &e)->uint64_t{return e.event_n;};
+      lo = sel.event_begin;
+      hi = sel.event_end;
+    }
+    else if(sel.trigger_begin || sel.trigger_end){
+      view = &m_by_trigger;
+      key = [](const FileIndexEntry &e)->uint64_t{return e.trigger_n;};
+      lo = sel.trigger_begin;
+      hi = sel.trigger_end;
+    }
+    else if(sel.ts_begin || sel.ts_end){
+      view = &m_by_ts;
+      key = [](const FileIndexEntry &e)->uint64_t{return e.ts_begin;};
+      lo = sel.ts_begin;
+      hi = sel.ts_end + 1;
+    }
+
+    std::vector<size_t> sel_pos;
+    if(!view){
+      sel_pos.resize(m_entries.size());
+      for(size_t i = 0; i < m_entries.size(); ++i)
+	sel_pos[i] = i;
+      return sel_pos;
+    }
+    if(view->size() != m_entries.size()){
+      view->resize(m_entries.size());
+      for(size_t i = 0; i < m_entries.size(); ++i)
+	(*view)[i] = i;
+      std::stable_sort(view->begin(), view->end(), [&](size_t a, size_t b){
+	  return key(m_entries[a]) < key(m_entries[b]);});
+    }
+    auto beg = std::lower_bound(view->begin(), view->end(), lo,
+				[&](size_t a, uint64_t v){return key(m_entries[a]) < v;});
+    auto end = std::lower_bound(beg, view->end(), hi,
+				[&](size_t a, uint64_t v){return key(m_entries[a]) < v;});
+    for(auto it = beg; it != end; ++it){
+      if(sel.Contains(m_entries[*it]))
+	sel_pos.push_back(*it);
+    }
+    std::sort(sel_pos.begin(), sel_pos.end());
+    return sel_pos;
+  }
+}
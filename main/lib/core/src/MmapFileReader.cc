@@ -0,0 +1,212 @@
+#include "eudaq/FileReader.hh"
+#include "eudaq/FileIndex.hh"
+#include "eudaq/Deserializer.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Platform.hh"
+
+#if !EUDAQ_PLATFORM_IS(WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include <memory>
+
+// Read-only mapping of a file, unmapped when the reader and the last event
+// referencing its blocks in it are gone.
+struct MmapRegion {
+  MmapRegion(uint8_t *data, size_t size) :data(data), size(size){}
+  ~MmapRegion(){if(data) munmap(data, size);}
+  uint8_t *data;
+  size_t size;
+};
+
+// Reads the events straight out of the mapping, their blocks stay in it.
+class MmapDeserializer : public eudaq::Deserializer {
+public:
+  MmapDeserializer(std::shared_ptr<const MmapRegion> region)
+    :m_region(region), m_begin(region->data), m_cur(m_begin), m_end(m_begin + region->size){}
+  bool HasData() override {return m_cur < m_end;}
+  size_t PeekSpan(const uint8_t *&data) override {data = m_cur; return m_end - m_cur;}
+  std::shared_ptr<const void> GetSpanOwner() override {return m_region;}
+  void Skip(size_t size) override;
+  uint64_t GetOffset() const {return m_cur - m_begin;}
+  void SetOffset(uint64_t offset) {m_cur = m_begin + offset;}
+private:
+  void Deserialize(uint8_t *data, size_t len) override;
+  void PreDeserialize(uint8_t *data, size_t len) override;
+  std::shared_ptr<const MmapRegion> m_region;
+  const uint8_t *m_begin;
+  const uint8_t *m_cur;
+  const uint8_t *m_end;
+};
+
+class MmapFileReader : public eudaq::FileReader {
+public:
+  MmapFileReader(const std::string& filename);
+  ~MmapFileReader() override;
+  eudaq::EventSPC GetNextEvent() override;
+  uint64_t BuildIndex() override;
+  bool SeekEvent(uint64_t index) override;
+  bool SelectEvents(const eudaq::FileIndexSelection &sel) override;
+private:
+  void Open();
+  void ReleaseBehind();
+  std::string m_filename;
+  std::shared_ptr<MmapRegion> m_region;
+  size_t m_released;
+  std::unique_ptr<MmapDeserializer> m_des;
+  std::unique_ptr<eudaq::FileIndex> m_idx;
+  std::vector<size_t> m_sel;
+  size_t m_sel_n;
+  bool m_has_sel;
+};
+
+namespace{
+  auto dummy0 = eudaq::Factory<eudaq::FileReader>::
+    Register<MmapFileReader, std::string&>(eudaq::cstr2hash("mmap"));
+  auto dummy1 = eudaq::Factory<eudaq::FileReader>::
+    Register<MmapFileReader, std::string&&>(eudaq::cstr2hash("mmap"));
+  //pages behind the read position are given back in chunks of this size
+  const size_t RELEASE_CHUNK = 64 << 20;
+}
+
+void MmapDeserializer::Deserialize(uint8_t *data, size_t len){
+  if(len > size_t(m_end - m_cur))
+    EUDAQ_THROWX(eudaq::FileReadException, "MmapFileReader: unexpected end of file");
+  std::memcpy(data, m_cur, len);
+  m_cur += len;
+}
+
+void MmapDeserializer::Skip(size_t len){
+  if(len > size_t(m_end - m_cur))
+    EUDAQ_THROWX(eudaq::FileReadException, "MmapFileReader: unexpected end of file");
+  m_cur += len;
+}
+
+void MmapDeserializer::PreDeserialize(uint8_t *data, size_t len){
+  if(len > size_t(m_end - m_cur))
+    EUDAQ_THROWX(eudaq::FileReadException, "MmapFileReader: unexpected end of file");
+  std::memcpy(data, m_cur, len);
+}
+
+MmapFileReader::MmapFileReader(const std::string& filename)
+  :m_filename(filename), m_released(0), m_sel_n(0), m_has_sel(false){
+}
+
+MmapFileReader::~MmapFileReader(){
+}
+
+void MmapFileReader::Open(){
+  int fd = open(m_filename.c_str(), O_RDONLY);
+  if(fd < 0)
+    EUDAQ_THROWX(eudaq::FileNotFoundException, "Unable to open file: " + m_filename);
+  struct stat st;
+  if(fstat(fd, &st) != 0){
+    close(fd);
+    EUDAQ_THROWX(eudaq::FileReadException, "Unable to stat file: " + m_filename);
+  }
+  size_t size = st.st_size;
+  uint8_t *data = nullptr;
+  if(size){
+    void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if(p == MAP_FAILED){
+      std::string err = std::strerror(errno);
+      close(fd);
+      EUDAQ_THROWX(eudaq::FileReadException, "Unable to map file: " + m_filename
+		   + " (" + err + ")");
+    }
+    data = static_cast<uint8_t*>(p);
+    madvise(data, size, MADV_SEQUENTIAL);
+  }
+  //the mapping stays valid without the descriptor
+  close(fd);
+  m_region = std::make_shared<MmapRegion>(data, size);
+  m_des.reset(new MmapDeserializer(m_region));
+}
+
+void MmapFileReader::ReleaseBehind(){
+  //the page cache keeps the file, only the mapping shrinks; the pages are
+  //read in again if an event still referencing its blocks there touches them
+  uint64_t offset = m_des->GetOffset();
+  if(offset < m_released + RELEASE_CHUNK)
+    return;
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t end = offset / page * page;
+  madvise(m_region->data + m_released, end - m_released, MADV_DONTNEED);
+  m_released = end;
+}
+
+eudaq::EventSPC MmapFileReader::GetNextEvent(){
+  if(!m_des)
+    Open();
+  if(m_has_sel){
+    if(m_sel_n >= m_sel.size())
+      return nullptr;
+    m_des->SetOffset(m_idx->At(m_sel[m_sel_n++]).offset);
+  }
+  if(!m_des->HasData())
+    return nullptr;
+  uint32_t id;
+  m_des->PreRead(id);
+  eudaq::EventUP ev = eudaq::Factory<eudaq::Event>::
+    Create<eudaq::Deserializer&>(id, *m_des);
+  ReleaseBehind();
+  return ev;
+}
+
+uint64_t MmapFileReader::BuildIndex(){
+  if(m_idx)
+    return m_idx->Size();
+  if(!m_des)
+    Open();
+  m_idx.reset(new eudaq::FileIndex);
+  if(m_idx->Load(eudaq::FileIndex::IndexPath(m_filename)))
+    return m_idx->Size();
+  uint64_t offset = m_des->GetOffset();
+  m_des->SetOffset(0);
+  while(m_des->HasData()){
+    uint64_t ev_offset = m_des->GetOffset();
+    uint32_t id;
+    m_des->PreRead(id);
+    auto ev = eudaq::Factory<eudaq::Event>::Create<eudaq::Deserializer&>(id, *m_des);
+    if(!ev)
+      EUDAQ_THROW("MmapFileReader: Unknown event type in " + m_filename);
+    m_idx->Add(eudaq::FileIndex::MakeEntry(ev_offset, *ev));
+  }
+  m_des->SetOffset(offset);
+  m_released = offset / sysconf(_SC_PAGESIZE) * sysconf(_SC_PAGESIZE);
+  return m_idx->Size();
+}
+
+bool MmapFileReader::SeekEvent(uint64_t index){
+  if(!m_idx || index >= m_idx->Size())
+    return false;
+  uint64_t offset = m_idx->At(index).offset;
+  m_des->SetOffset(offset);
+  m_released = offset / sysconf(_SC_PAGESIZE) * sysconf(_SC_PAGESIZE);
+  m_has_sel = false;
+  return true;
+}
+
+bool MmapFileReader::SelectEvents(const eudaq::FileIndexSelection &sel){
+  if(!m_idx){
+    std::unique_ptr<eudaq::FileIndex> idx(new eudaq::FileIndex);
+    if(!idx->Load(eudaq::FileIndex::IndexPath(m_filename)))
+      return false;
+    m_idx = std::move(idx);
+  }
+  if(!m_des)
+    Open();
+  //jumping around, read ahead would be wasted
+  if(m_region->data)
+    madvise(m_region->data, m_region->size, MADV_RANDOM);
+  m_sel = m_idx->Select(sel);
+  m_sel_n = 0;
+  m_has_sel = true;
+  return true;
+}
+
+#endif
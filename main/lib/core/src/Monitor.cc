@@ -68,6 +68,10 @@ namespace eudaq {
     auto conf = GetConfiguration();
     try {
       SetStatus(Status::STATE_UNCONF, "Configuring");
+      SetQueueSize(conf->Get("EUDAQ_DATARECEIVER_QUEUE_SIZE", 50000));
+      SetOverflowPolicy(conf->Get("EUDAQ_DATARECEIVER_POLICY", "lossy"));
+      SetDeserializeThreads(conf->Get("EUDAQ_DATARECEIVER_THREADS", 0));
+      SetTargetRate(conf->Get("EUDAQ_MONITOR_RATE", 0.0));
       DoConfigure();
       CommandReceiver::OnConfigure();
     }catch (const Exception &e) {
@@ -128,6 +132,12 @@ namespace eudaq {
     
   void Monitor::OnStatus(){
     SetStatusTag("EventN", std::to_string(m_evt_c));
+    for(auto &occ: GetQueueOccupancy()){
+      SetStatusTag("RecvQueue." + occ.first, std::to_string(occ.second.first)
+		   + "/" + std::to_string(occ.second.second));
+    }
+    SetStatusTag("RecvDroppedN", std::to_string(GetQueueDroppedN()));
+    SetStatusTag("RecvSpilledN", std::to_string(GetQueueSpilledN()));
     DoStatus();
     CommandReceiver::OnStatus();
   }
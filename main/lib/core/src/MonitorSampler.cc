@@ -0,0 +1,162 @@
+#include "eudaq/MonitorSampler.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Utils.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eudaq {
+  namespace{
+    //the sampling scale is adjusted at most this often
+    const std::chrono::milliseconds ADAPT_PERIOD(100);
+    //queue occupancy above which the sampling is halved, and below which
+    //it is raised again
+    const double LOAD_HIGH = 0.5;
+    const double LOAD_LOW = 0.1;
+    const double SCALE_MIN = 1.0 / 1024;
+    const double SCALE_UP = 1.25;
+  }
+
+  MonitorSampler::MonitorSampler()
+    :m_policy(POLICY_FRACTION), m_fraction(1), m_rate(0),
+     m_window(1000), m_flags(0), m_started(false), m_count(0), m_credit(1),
+     m_win_n(0), m_prev_win_n(0), m_rng(std::random_device()()),
+     m_scale(1), m_seen_n(0), m_sent_n(0){
+  }
+
+  void MonitorSampler::SetPolicy(Policy policy){
+    m_policy = policy;
+  }
+
+  void MonitorSampler::SetPolicy(const std::string &policy){
+    std::string p = lcase(policy);
+    if(p == "fraction")
+      m_policy = POLICY_FRACTION;
+    else if(p == "rate")
+      m_policy = POLICY_RATE;
+    else if(p == "reservoir")
+      m_policy = POLICY_RESERVOIR;
+    else
+      EUDAQ_THROW("MonitorSampler:: Unknown sampling policy: " + policy);
+  }
+
+  void MonitorSampler::SetFraction(uint32_t n){
+    m_fraction = n ? n : 1;
+  }
+
+  void MonitorSampler::SetRate(double hz){
+    m_rate = hz > 0 ? hz : 0;
+  }
+
+  void MonitorSampler::SetWindow(std::chrono::milliseconds window){
+    m_window = window.count() > 0 ? window : std::chrono::milliseconds(1);
+  }
+
+  void MonitorSampler::SetForwardFlags(uint32_t flags){
+    m_flags = flags;
+  }
+
+  void MonitorSampler::Adapt(double load, std::chrono::steady_clock::time_point now){
+    if(now - m_tp_adapt < ADAPT_PERIOD)
+      return;
+    m_tp_adapt = now;
+    double scale = m_scale;
+    if(load > LOAD_HIGH)
+      scale = std::max(scale / 2, SCALE_MIN);
+    else if(load < LOAD_LOW)
+      scale = std::min(scale * SCALE_UP, 1.0);
+    m_scale = scale;
+  }
+
+  void MonitorSampler::TakeReservoir(std::vector<EventSPC> &picked){
+    //forwarded in the order in which they were received
+    std::sort(m_reservoir.begin(), m_reservoir.end(),
+	      [](const std::pair<uint64_t, EventSPC> &a,
+		 const std::pair<uint64_t, EventSPC> &b){return a.first < b.first;});
+    for(auto &e: m_reservoir)
+      picked.push_back(std::move(e.second));
+    m_sent_n += m_reservoir.size();
+    m_reservoir.clear();
+  }
+
+  bool MonitorSampler::Sample(EventSPC ev, double load, std::vector<EventSPC> &picked){
+    auto now = std::chrono::steady_clock::now();
+    if(!m_started){
+      m_started = true;
+      m_tp_last = now;
+      m_tp_adapt = now;
+      m_tp_window = now;
+    }
+    m_seen_n++;
+    Adapt(load, now);
+    double scale = m_scale;
+
+    if(m_policy == POLICY_RESERVOIR && (now - m_tp_window >= m_window || ev->IsEORE())){
+      TakeReservoir(picked);
+      m_prev_win_n = m_win_n;
+      m_win_n = 0;
+      m_tp_window = now;
+    }
+    if(ev->IsBORE() || ev->IsEORE() || (ev->GetFlag() & m_flags)){
+      m_sent_n++;
+      return true;
+    }
+
+    bool fwd = false;
+    switch(m_policy){
+    case POLICY_FRACTION:{
+      uint64_t step = std::max<uint64_t>(1, std::llround(m_fraction / scale));
+      fwd = m_count == 0;
+      if(++m_count >= step)
+	m_count = 0;
+      break;
+    }
+    case POLICY_RATE:{
+      double dt = std::chrono::duration<double>(now - m_tp_last).count();
+      m_tp_last = now;
+      //no burst after a quiet period, the credit is capped at one event
+      m_credit = std::min(m_credit + (m_rate > 0 ? dt * m_rate * scale : scale), 1.0);
+      if(m_credit >= 1){
+	m_credit -= 1;
+	fwd = true;
+      }
+      break;
+    }
+    case POLICY_RESERVOIR:{
+      double k_win = m_rate > 0
+	? m_rate * scale * std::chrono::duration<double>(m_window).count()
+	: double(m_prev_win_n) * scale / m_fraction;
+      size_t k = std::max<size_t>(1, std::llround(k_win));
+      uint64_t i = m_win_n++;
+      if(m_reservoir.size() < k)
+	m_reservoir.emplace_back(i, ev);
+      else{
+	uint64_t j = std::uniform_int_distribution<uint64_t>(0, i)(m_rng);
+	if(j < k)
+	  m_reservoir[j] = std::make_pair(i, ev);
+      }
+      return false;
+    }
+    }
+    if(fwd)
+      m_sent_n++;
+    return fwd;
+  }
+
+  uint64_t MonitorSampler::GetSeenN() const{
+    return m_seen_n;
+  }
+
+  uint64_t MonitorSampler::GetSentN() const{
+    return m_sent_n;
+  }
+
+  double MonitorSampler::GetRatio() const{
+    uint64_t seen = m_seen_n;
+    return seen ? double(m_sent_n) / seen : 0;
+  }
+
+  double MonitorSampler::GetScale() const{
+    return m_scale;
+  }
+}
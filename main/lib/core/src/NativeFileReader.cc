@@ -1,13 +1,21 @@
 #include "eudaq/FileDeserializer.hh"
 #include "eudaq/FileReader.hh"
+#include "eudaq/FileIndex.hh"
 
 class NativeFileReader : public eudaq::FileReader {
 public:
   NativeFileReader(const std::string& filename);
   eudaq::EventSPC GetNextEvent()override;
+  uint64_t BuildIndex() override;
+  bool SeekEvent(uint64_t index) override;
+  bool SelectEvents(const eudaq::FileIndexSelection &sel) override;
 private:
   std::unique_ptr<eudaq::FileDeserializer> m_des;
   std::string m_filename;
+  std::unique_ptr<eudaq::FileIndex> m_idx;
+  std::vector<size_t> m_sel;
+  size_t m_sel_n;
+  bool m_has_sel;
 };
 
 namespace{
@@ -18,7 +26,7 @@ namespace{
 }
 
 NativeFileReader::NativeFileReader(const std::string& filename)
-  :m_filename(filename){    
+  :m_filename(filename), m_sel_n(0), m_has_sel(false){    
 }
 
 eudaq::EventSPC NativeFileReader::GetNextEvent(){
@@ -27,6 +35,13 @@ eudaq::EventSPC NativeFileReader::GetNextEvent(){
     if(!m_des)
       EUDAQ_THROW("unable to open file: " + m_filename);
   }
+  if(m_has_sel){
+    if(m_sel_n >= m_sel.size())
+      return nullptr;
+    uint64_t offset = m_idx->At(m_sel[m_sel_n++]).offset;
+    if(m_des->Tell() != offset)
+      m_des->Seek(offset);
+  }
   eudaq::EventUP ev;
   uint32_t id;
   
@@ -38,3 +53,35 @@ eudaq::EventSPC NativeFileReader::GetNextEvent(){
   }  else  return nullptr;
   
 }
+
+uint64_t NativeFileReader::BuildIndex(){
+  if(!m_idx){
+    m_idx.reset(new eudaq::FileIndex);
+    if(!m_idx->Load(eudaq::FileIndex::IndexPath(m_filename)))
+      *m_idx = eudaq::FileIndex::Build(m_filename);
+  }
+  return m_idx->Size();
+}
+
+bool NativeFileReader::SeekEvent(uint64_t index){
+  if(!m_idx || index >= m_idx->Size())
+    return false;
+  if(!m_des)
+    m_des.reset(new eudaq::FileDeserializer(m_filename));
+  m_des->Seek(m_idx->At(index).offset);
+  m_has_sel = false;
+  return true;
+}
+
+bool NativeFileReader::SelectEvents(const eudaq::FileIndexSelection &sel){
+  if(!m_idx){
+    std::unique_ptr<eudaq::FileIndex> idx(new eudaq::FileIndex);
+    if(!idx->Load(eudaq::FileIndex::IndexPath(m_filename)))
+      return false;
+    m_idx = std::move(idx);
+  }
+  m_sel = m_idx->Select(sel);
+  m_sel_n = 0;
+  m_has_sel = true;
+  return true;
+}
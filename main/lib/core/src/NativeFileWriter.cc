@@ -1,16 +1,78 @@
 #include "eudaq/FileNamer.hh"
 #include "eudaq/FileWriter.hh"
 #include "eudaq/FileSerializer.hh"
+#include "eudaq/FileIndex.hh"
+#include "eudaq/Platform.hh"
+#include "eudaq/Logger.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <vector>
+#if !EUDAQ_PLATFORM_IS(WIN32)
+#include <unistd.h>
+#endif
+
+// Serializes into a memory buffer, which is written out as a whole later.
+class MemorySerializer : public eudaq::Serializer {
+public:
+  explicit MemorySerializer(std::vector<uint8_t> &buf) :m_buf(buf){}
+private:
+  void Serialize(const uint8_t *data, size_t len) override {
+    m_buf.insert(m_buf.end(), data, data + len);
+  }
+  std::vector<uint8_t> &m_buf;
+};
 
 class NativeFileWriter : public eudaq::FileWriter {
 public:
   NativeFileWriter(const std::string &patt);
+  ~NativeFileWriter() override;
   void WriteEvent(eudaq::EventSPC ev) override;
+  void WriteSerialized(eudaq::EventSPC ev, eudaq::BufferSerializerSPC ser) override;
+  bool TakesSerialized() const override {return true;};
   uint64_t FileBytes() const override;
+  uint64_t WriteLatency() const override;
 private:
+  struct WriteBuffer{
+    std::vector<uint8_t> data;
+    std::shared_ptr<std::FILE> file;
+    bool sync;
+  };
+  void OpenFile(uint32_t run_n);
+  void Write(eudaq::EventSPC ev, const eudaq::BufferSerializer *ser);
+  void QueueBuffer(bool sync);
+  void DrainBuffers(std::unique_lock<std::mutex> &lk);
+  bool AsyncWriting();
   std::unique_ptr<eudaq::FileSerializer> m_ser;
+  std::unique_ptr<eudaq::FileSerializer> m_idx;
   std::string m_filepattern;
   uint32_t m_run_n;
+  std::atomic<uint64_t> m_latency_us;
+
+  //write-behind mode
+  bool m_buffered;
+  size_t m_flush_bytes;
+  size_t m_flush_events;
+  std::chrono::milliseconds m_flush_ms;
+  std::shared_ptr<std::FILE> m_file;
+  WriteBuffer m_buf;
+  size_t m_buf_events;
+  std::chrono::steady_clock::time_point m_tp_buf;
+  uint64_t m_bytes_queued;
+  std::atomic<uint64_t> m_bytes_written;
+  std::deque<WriteBuffer> m_qu_buf;
+  std::vector<std::vector<uint8_t>> m_free_buf;
+  std::mutex m_mx_buf;
+  std::condition_variable m_cv_buf;
+  std::future<bool> m_fut_async;
+  bool m_is_writing;
+  bool m_buf_in_flight;
 };
 
 namespace{
@@ -18,33 +80,237 @@ namespace{
     Register<NativeFileWriter, std::string&>(eudaq::cstr2hash("native"));
   auto dummy1 = eudaq::Factory<eudaq::FileWriter>::
     Register<NativeFileWriter, std::string&&>(eudaq::cstr2hash("native"));
+  //buffers waiting for the disk before WriteEvent blocks
+  const size_t MAX_QUEUED_BUFFERS = 8;
 }
 
-NativeFileWriter::NativeFileWriter(const std::string &patt){
+NativeFileWriter::NativeFileWriter(const std::string &patt)
+  :m_latency_us(0), m_buffered(false), m_flush_bytes(0), m_flush_events(0),
+   m_flush_ms(0), m_buf_events(0), m_bytes_queued(0), m_bytes_written(0),
+   m_is_writing(false), m_buf_in_flight(false){
   m_filepattern = patt;
 }
-  
+
+NativeFileWriter::~NativeFileWriter(){
+  if(!m_fut_async.valid())
+    return;
+  try{
+    std::unique_lock<std::mutex> lk(m_mx_buf);
+    if(!m_buf.data.empty())
+      QueueBuffer(true);
+    m_is_writing = false;
+    lk.unlock();
+    m_cv_buf.notify_all();
+    m_fut_async.get();
+  }
+  catch(const std::exception &e){
+    EUDAQ_ERROR(std::string("NativeFileWriter: ") + e.what());
+  }
+}
+
+void NativeFileWriter::OpenFile(uint32_t run_n){
+  std::time_t time_now = std::time(nullptr);
+  char time_buff[13];
+  time_buff[12] = 0;
+  std::strftime(time_buff, sizeof(time_buff),
+		"%y%m%d%H%M%S", std::localtime(&time_now));
+  std::string time_str(time_buff);
+  std::string filename = eudaq::FileNamer(m_filepattern).
+    Set('X', ".raw").
+    Set('R', run_n).
+    Set('D', time_str);
+  auto conf = GetConfiguration();
+  m_ser.reset();
+  if(m_fut_async.valid()){
+    //the rest of the last file goes out first
+    std::unique_lock<std::mutex> lk(m_mx_buf);
+    if(!m_buf.data.empty())
+      QueueBuffer(true);
+    DrainBuffers(lk);
+    m_file.reset();
+  }
+  m_buffered = conf && conf->Get("EUDAQ_FW_BUFFERED", 0);
+  if(m_buffered){
+    m_flush_bytes = conf->Get("EUDAQ_FW_FLUSH_BYTES", 4 << 20);
+    m_flush_events = conf->Get("EUDAQ_FW_FLUSH_EVENTS", 10000);
+    m_flush_ms = std::chrono::milliseconds(conf->Get("EUDAQ_FW_FLUSH_MS", 200));
+    std::FILE *fd = std::fopen(filename.c_str(), "rb");
+    if(fd){
+      std::fclose(fd);
+      EUDAQ_THROWX(eudaq::FileExistsException, "File already exists: " + filename);
+    }
+    fd = std::fopen(filename.c_str(), "wb");
+    if(!fd)
+      EUDAQ_THROWX(eudaq::FileNotFoundException, "Unable to open file: " + filename);
+    //whole buffers are handed to fwrite, no need for a second copy
+    std::setvbuf(fd, nullptr, _IONBF, 0);
+    std::unique_lock<std::mutex> lk(m_mx_buf);
+    m_file.reset(fd, std::fclose);
+    m_bytes_queued = 0;
+    m_bytes_written = 0;
+    if(!m_fut_async.valid()){
+      m_is_writing = true;
+      m_fut_async = std::async(std::launch::async, &NativeFileWriter::AsyncWriting, this);
+    }
+  }
+  else
+    m_ser.reset(new eudaq::FileSerializer(filename));
+  m_idx.reset();
+  if(conf && conf->Get("EUDAQ_FW_INDEX", 0)){
+    m_idx.reset(new eudaq::FileSerializer(eudaq::FileIndex::IndexPath(filename)));
+    eudaq::FileIndex::WriteHeader(*m_idx);
+  }
+  m_run_n = run_n;
+}
+
 void NativeFileWriter::WriteEvent(eudaq::EventSPC ev) {
+  Write(ev, nullptr);
+}
+
+void NativeFileWriter::WriteSerialized(eudaq::EventSPC ev, eudaq::BufferSerializerSPC ser) {
+  Write(ev, ser.get());
+}
+
+//the serialization of the event is used when given, as it is the file format
+void NativeFileWriter::Write(eudaq::EventSPC ev, const eudaq::BufferSerializer *ser) {
   uint32_t run_n = ev->GetRunN();
-  if(!m_ser || m_run_n != run_n){
-    std::time_t time_now = std::time(nullptr);
-    char time_buff[13];
-    time_buff[12] = 0;
-    std::strftime(time_buff, sizeof(time_buff),
-		  "%y%m%d%H%M%S", std::localtime(&time_now));
-    std::string time_str(time_buff);
-    m_ser.reset(new eudaq::FileSerializer((eudaq::FileNamer(m_filepattern).
-					   Set('X', ".raw").
-					   Set('R', run_n).
-					   Set('D', time_str))));
-    m_run_n = run_n;
-  }
-  if(!m_ser)
+  if((!m_ser && !m_file) || m_run_n != run_n)
+    OpenFile(run_n);
+  if(!m_ser && !m_file)
     EUDAQ_THROW("NativeFileWriter: Attempt to write unopened file");
-  m_ser->write(*(ev.get())); //TODO: Serializer accepts EventSPC
-  m_ser->Flush();
+
+  if(!m_buffered){
+    auto tp_start = std::chrono::steady_clock::now();
+    uint64_t offset = m_ser->FileBytes();
+    if(ser)
+      m_ser->append(ser->data(), ser->size());
+    else
+      m_ser->write(*(ev.get())); //TODO: Serializer accepts EventSPC
+    m_ser->Flush();
+    m_latency_us = std::chrono::duration_cast<std::chrono::microseconds>
+      (std::chrono::steady_clock::now() - tp_start).count();
+    if(m_idx){
+      eudaq::FileIndex::WriteEntry(*m_idx, eudaq::FileIndex::MakeEntry(offset, *ev));
+      m_idx->Flush();
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> lk(m_mx_buf);
+  if(m_fut_async.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+    m_fut_async.get(); //rethrows the error of the writing thread
+    EUDAQ_THROW("NativeFileWriter: The writing thread has stopped");
+  }
+  if(m_buf.data.empty()){
+    m_tp_buf = std::chrono::steady_clock::now();
+    if(!m_free_buf.empty()){
+      m_buf.data.swap(m_free_buf.back());
+      m_free_buf.pop_back();
+    }
+    m_buf.data.reserve(m_flush_bytes);
+    //the idle writing thread waits for the flush time of this buffer
+    m_cv_buf.notify_all();
+  }
+  uint64_t offset = m_bytes_queued + m_buf.data.size();
+  if(ser)
+    m_buf.data.insert(m_buf.data.end(), ser->data(), ser->data() + ser->size());
+  else{
+    MemorySerializer mser(m_buf.data);
+    mser.write(*(ev.get()));
+  }
+  m_buf_events++;
+  bool sync = ev->IsEORE();
+  if(sync || m_buf.data.size() >= m_flush_bytes || m_buf_events >= m_flush_events
+     || std::chrono::steady_clock::now() - m_tp_buf >= m_flush_ms){
+    while(m_qu_buf.size() >= MAX_QUEUED_BUFFERS){
+      //the disk does not keep up
+      m_cv_buf.wait_for(lk, std::chrono::milliseconds(100));
+      if(m_fut_async.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+	m_fut_async.get();
+	EUDAQ_THROW("NativeFileWriter: The writing thread has stopped");
+      }
+    }
+    QueueBuffer(sync);
+  }
+  lk.unlock();
+  if(m_idx){
+    eudaq::FileIndex::WriteEntry(*m_idx, eudaq::FileIndex::MakeEntry(offset, *ev));
+    if(sync)
+      m_idx->Flush();
+  }
 }
-  
+
+void NativeFileWriter::QueueBuffer(bool sync){
+  //called with m_mx_buf locked
+  m_buf.file = m_file;
+  m_buf.sync = sync;
+  m_bytes_queued += m_buf.data.size();
+  m_qu_buf.push_back(std::move(m_buf));
+  m_buf = WriteBuffer();
+  m_buf_events = 0;
+  m_cv_buf.notify_all();
+}
+
+void NativeFileWriter::DrainBuffers(std::unique_lock<std::mutex> &lk){
+  //called with m_mx_buf locked, waits until the writing thread is idle
+  while(!m_qu_buf.empty() || m_buf_in_flight){
+    m_cv_buf.wait_for(lk, std::chrono::milliseconds(100));
+    if(m_fut_async.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+      m_fut_async.get();
+      EUDAQ_THROW("NativeFileWriter: The writing thread has stopped");
+    }
+  }
+}
+
+bool NativeFileWriter::AsyncWriting(){
+  std::unique_lock<std::mutex> lk(m_mx_buf);
+  while(m_is_writing || !m_qu_buf.empty()){
+    if(m_qu_buf.empty()){
+      //flush a buffer which has waited too long for more events
+      if(m_buf.data.empty())
+	m_cv_buf.wait_for(lk, m_flush_ms.count() ? m_flush_ms : std::chrono::milliseconds(100));
+      else if(std::chrono::steady_clock::now() - m_tp_buf >= m_flush_ms)
+	QueueBuffer(false);
+      else
+	m_cv_buf.wait_until(lk, m_tp_buf + m_flush_ms);
+      continue;
+    }
+    WriteBuffer buf = std::move(m_qu_buf.front());
+    m_qu_buf.pop_front();
+    m_buf_in_flight = true;
+    lk.unlock();
+    m_cv_buf.notify_all();
+
+    auto tp_start = std::chrono::steady_clock::now();
+    if(std::fwrite(buf.data.data(), 1, buf.data.size(), buf.file.get()) != buf.data.size())
+      EUDAQ_THROW("NativeFileWriter: Error writing to file: " + eudaq::to_string(errno)
+		  + ", " + std::strerror(errno));
+    if(buf.sync){
+      std::fflush(buf.file.get());
+#if !EUDAQ_PLATFORM_IS(WIN32)
+      fsync(fileno(buf.file.get()));
+#endif
+    }
+    m_latency_us = std::chrono::duration_cast<std::chrono::microseconds>
+      (std::chrono::steady_clock::now() - tp_start).count();
+    m_bytes_written += buf.data.size();
+    buf.data.clear();
+
+    lk.lock();
+    m_buf_in_flight = false;
+    if(m_free_buf.size() < MAX_QUEUED_BUFFERS)
+      m_free_buf.push_back(std::move(buf.data));
+    m_cv_buf.notify_all();
+  }
+  return true;
+}
+
 uint64_t NativeFileWriter::FileBytes() const {
+  if(m_buffered)
+    return m_bytes_written;
   return m_ser ?m_ser->FileBytes() :0;
 }
+
+uint64_t NativeFileWriter::WriteLatency() const {
+  return m_latency_us;
+}
@@ -60,6 +60,18 @@ namespace eudaq {
       if(!IsStatus(Status::STATE_CONF) && !IsStatus(Status::STATE_STOPPED))
 	EUDAQ_THROW("OnStartRun can not be called unless in STATE_CONF");
       std::map<std::string, std::shared_ptr<DataSender>> senders;
+      auto conf = GetConfiguration();
+      bool ds_async = conf->Get("EUDAQ_DATASENDER_ASYNC", 1);
+      uint32_t ds_queue = conf->Get("EUDAQ_DATASENDER_QUEUE_SIZE", 4096);
+      uint32_t ds_batch = conf->Get("EUDAQ_DATASENDER_BATCH_SIZE", 64);
+      uint32_t ds_pack = conf->Get("EUDAQ_DATASENDER_PACK_SIZE", 1);
+      uint32_t ds_pack_us = conf->Get("EUDAQ_DATASENDER_PACK_US", 0);
+      std::string ds_policy = conf->Get("EUDAQ_DATASENDER_POLICY", "block");
+      SocketOptions ds_sockopt;
+      ds_sockopt.sndbuf = conf->Get("EUDAQ_SOCKET_SNDBUF", 0);
+      ds_sockopt.rcvbuf = conf->Get("EUDAQ_SOCKET_RCVBUF", 0);
+      ds_sockopt.nodelay = conf->Get("EUDAQ_TCP_NODELAY", 0);
+      ds_sockopt.cork = conf->Get("EUDAQ_TCP_CORK", 0);
       std::string dc_str = GetConfiguration()->Get("EUDAQ_DC", "");
       std::vector<std::string> col_dc_name = split(dc_str, ";,", true);
       std::string cur_backup = GetConfiguration()->GetCurrentSectionName();
@@ -69,6 +81,12 @@ namespace eudaq {
 	if(!dc_addr.empty()){
 	  senders[dc_addr]
 	    = std::unique_ptr<DataSender>(new DataSender("Producer", GetName()));
+	  senders[dc_addr]->SetAsync(ds_async);
+	  senders[dc_addr]->SetQueueSize(ds_queue);
+	  senders[dc_addr]->SetBatchSize(ds_batch);
+	  senders[dc_addr]->SetPacking(ds_pack, std::chrono::microseconds(ds_pack_us));
+	  senders[dc_addr]->SetOverflowPolicy(ds_policy);
+	  senders[dc_addr]->SetSocketOptions(ds_sockopt);
 	  senders[dc_addr]->Connect(dc_addr);
 	}
       }
@@ -94,9 +112,17 @@ namespace eudaq {
     try{
       if(!IsStatus(Status::STATE_RUNNING))
 	EUDAQ_THROW("OnStopRun can not be called unless in STATE_RUNNING");
-      DoStopRun();      
-      CommandReceiver::OnStopRun();
+      DoStopRun();
+      //the queued events, up to the EORE, leave before STOPPED is reported
       std::unique_lock<std::mutex> lk(m_mtx_sender);
+      auto senders = m_senders;
+      lk.unlock();
+      for(auto &e: senders){
+	if(e.second)
+	  e.second->Flush();
+      }
+      CommandReceiver::OnStopRun();
+      lk.lock();
       m_senders.clear();
     } catch (const std::exception &e) {
       printf("Caught exception: %s\n", e.what());
@@ -140,6 +166,24 @@ namespace eudaq {
   void Producer::OnStatus(){
     try{
       SetStatusTag("EventN", std::to_string(m_evt_c));
+      std::unique_lock<std::mutex> lk(m_mtx_sender);
+      auto senders = m_senders;
+      lk.unlock();
+      if(!senders.empty()){
+	size_t queue_n = 0;
+	uint64_t dropped_n = 0;
+	double byte_rate = 0;
+	for(auto &e: senders){
+	  if(!e.second)
+	    continue;
+	  queue_n += e.second->GetQueueDepth();
+	  dropped_n += e.second->GetDroppedN();
+	  byte_rate += e.second->GetByteRate();
+	}
+	SetStatusTag("SendQueueN", std::to_string(queue_n));
+	SetStatusTag("SendDroppedN", std::to_string(dropped_n));
+	SetStatusTag("SendBytesPerSec", std::to_string(uint64_t(byte_rate)));
+      }
       DoStatus();
     }catch (const std::exception &e) {
       printf("Caught exception: %s\n", e.what());
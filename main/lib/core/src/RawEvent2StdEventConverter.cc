@@ -22,7 +22,7 @@ namespace eudaq{
     }
 
     uint32_t id = ev->GetExtendWord();
-    auto cvt = Factory<StdEventConverter>::MakeUnique(id);
+    auto cvt = GetConverter(id, conf);
     if(cvt){
       return cvt->Converting(d1, d2, conf);
     }
@@ -84,7 +84,8 @@ namespace eudaq {
 	lk.lock();
 	std::string server_addr = m_conn_status[id]->GetTag("_SERVER");
 	lk.unlock();
-	if(server_addr.find("tcp://") == 0 && conn_addr.find("tcp://") == 0){
+	if((server_addr.find("tcp://") == 0 || server_addr.find("epoll://") == 0)
+	   && conn_addr.find("tcp://") == 0){
 	  server_addr = conn_addr.substr(0, conn_addr.find_last_not_of("0123456789"))
 	    + ":"
 	    + server_addr.substr(server_addr.find_last_not_of("0123456789")+1);
@@ -126,7 +127,8 @@ namespace eudaq {
 	lk.lock();
 	std::string server_addr = m_conn_status[conn]->GetTag("_SERVER");
 	lk.unlock();
-	if(server_addr.find("tcp://") == 0 && conn_addr.find("tcp://") == 0){
+	if((server_addr.find("tcp://") == 0 || server_addr.find("epoll://") == 0)
+	   && conn_addr.find("tcp://") == 0){
 	  server_addr = conn_addr.substr(0, conn_addr.find_last_not_of("0123456789"))
 	    + ":"
 	    + server_addr.substr(server_addr.find_last_not_of("0123456789")+1);
@@ -161,7 +163,8 @@ namespace eudaq {
 	lk.lock();
 	std::string server_addr = m_conn_status[id]->GetTag("_SERVER");
 	lk.unlock();
-	if(server_addr.find("tcp://") == 0 && conn_addr.find("tcp://") == 0){
+	if((server_addr.find("tcp://") == 0 || server_addr.find("epoll://") == 0)
+	   && conn_addr.find("tcp://") == 0){
 	  server_addr = conn_addr.substr(0, conn_addr.find_last_not_of("0123456789"))
 	    + ":"
 	    + server_addr.substr(server_addr.find_last_not_of("0123456789")+1);
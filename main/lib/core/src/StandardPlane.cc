@@ -1,18 +1,68 @@
 #include "eudaq/StandardPlane.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace{
+  // marks the compact layout in the serialized flags, followed by its version
+  const uint32_t FLAG_SERIAL_COMPACT = 0x80000000;
+  const uint32_t SERIAL_VERSION = 1;
+
+  // optional columns of the compact layout
+  enum COLUMNS : uint32_t {
+    COL_COORD16 = 0x1, // coordinates fit 16 bits
+    COL_PIX16 = 0x2, // integer pixel values in 16 bits, none of these: all 1
+    COL_PIX32 = 0x4,
+    COL_PIXDOUBLE = 0x8,
+    COL_TIME = 0x10,
+    COL_PIVOT = 0x20,
+    COL_SUBMAT = 0x40,
+    COL_WAVEFORM = 0x80
+  };
+
+  uint64_t WaveformKey(uint32_t index, uint32_t frame){
+    return uint64_t(frame) << 32 | index;
+  }
+
+  template <typename T, typename S>
+  void WriteColumn(eudaq::Serializer &ser, const std::vector<S> &v){
+    thread_local std::vector<T> buf;
+    buf.resize(v.size());
+    for (size_t i = 0; i < v.size(); ++i)
+      buf[i] = static_cast<T>(v[i]);
+    ser.write(buf);
+  }
+
+  template <typename T, typename S>
+  void ReadColumn(eudaq::Deserializer &ds, std::vector<S> &v){
+    thread_local std::vector<T> buf;
+    buf.clear();
+    ds.read(buf);
+    v.resize(buf.size());
+    for (size_t i = 0; i < buf.size(); ++i)
+      v[i] = static_cast<S>(buf[i]);
+  }
+
+  template <typename T> bool FitsInteger(double v){
+    return v >= std::numeric_limits<T>::min() && v <= std::numeric_limits<T>::max()
+      && v == std::trunc(v);
+  }
+}
+
 namespace eudaq{
   StandardPlane::StandardPlane()
     : m_id(0), m_xsize(0), m_ysize(0), m_flags(0),
-      m_pivotpixel(0), m_result_pix(0), m_result_x(0), m_result_y(0) {}
+      m_pivotpixel(0), m_result_pix(0), m_result_mapped(false), m_result_xy(false) {}
 
   StandardPlane::StandardPlane(uint32_t id, const std::string &type,
 			       const std::string &sensor)
     : m_type(type), m_sensor(sensor), m_id(id), m_xsize(0),
-      m_ysize(0), m_flags(0), m_pivotpixel(0), m_result_pix(0), m_result_x(0),
-      m_result_y(0) {}
+      m_ysize(0), m_flags(0), m_pivotpixel(0), m_result_pix(0),
+      m_result_mapped(false), m_result_xy(false) {}
 
   StandardPlane::StandardPlane(Deserializer &ds)
-    : m_result_pix(0), m_result_x(0), m_result_y(0) {
+    : m_result_pix(0), m_result_mapped(false), m_result_xy(false) {
     ds.read(m_type);
     ds.read(m_sensor);
     ds.read(m_id);
@@ -20,34 +70,190 @@ namespace eudaq{
     ds.read(m_ysize);
     ds.read(m_flags);
     ds.read(m_pivotpixel);
+    if (m_flags & FLAG_SERIAL_COMPACT) {
+      m_flags &= ~FLAG_SERIAL_COMPACT;
+      DeserializeCompact(ds);
+    } else {
+      DeserializeLegacy(ds);
+    }
+  }
+
+  void StandardPlane::DeserializeLegacy(Deserializer &ds) {
+    std::vector<std::vector<std::vector<double>>> waveform;
+    std::vector<std::vector<double>> waveform_x0, waveform_dx, x, y;
     ds.read(m_pix);
-    ds.read(m_waveform);
-    ds.read(m_waveform_x0);
-    ds.read(m_waveform_dx);
-    ds.read(m_x);
-    ds.read(m_y);
+    ds.read(waveform);
+    ds.read(waveform_x0);
+    ds.read(waveform_dx);
+    ds.read(x);
+    ds.read(y);
     ds.read(m_pivot);
     ds.read(m_mat);
     ds.read(m_time);
+    m_x.resize(x.size());
+    m_y.resize(y.size());
+    for (size_t f = 0; f < x.size(); ++f) {
+      m_x[f].resize(x[f].size());
+      for (size_t i = 0; i < x[f].size(); ++i)
+        m_x[f][i] = static_cast<uint32_t>(x[f][i]);
+    }
+    for (size_t f = 0; f < y.size(); ++f) {
+      m_y[f].resize(y[f].size());
+      for (size_t i = 0; i < y[f].size(); ++i)
+        m_y[f][i] = static_cast<uint32_t>(y[f][i]);
+    }
+    m_time.resize(m_x.size());
+    for (auto &time: m_time) {
+      bool any = false;
+      for (auto t: time)
+        any = any || t;
+      if (!any)
+        time.clear();
+    }
+    for (size_t f = 0; f < waveform.size(); ++f) {
+      for (size_t i = 0; i < waveform[f].size(); ++i) {
+        if (waveform[f][i].empty())
+          continue;
+        auto &wf = m_waveform[WaveformKey(i, f)];
+        wf.data = std::move(waveform[f][i]);
+        wf.x0 = (f < waveform_x0.size() && i < waveform_x0[f].size()) ? waveform_x0[f][i] : 0;
+        wf.dx = (f < waveform_dx.size() && i < waveform_dx[f].size()) ? waveform_dx[f][i] : 0;
+      }
+    }
+  }
+
+  void StandardPlane::DeserializeCompact(Deserializer &ds) {
+    uint32_t version, columns, n;
+    ds.read(version);
+    if (version != SERIAL_VERSION)
+      EUDAQ_THROW("Unsupported StandardPlane serialization version " + to_string(version));
+    ds.read(columns);
+    ds.read(n);
+    m_x.resize(n);
+    m_y.resize(n);
+    for (uint32_t f = 0; f < n; ++f) {
+      if (columns & COL_COORD16) {
+        ReadColumn<uint16_t>(ds, m_x[f]);
+        ReadColumn<uint16_t>(ds, m_y[f]);
+      } else {
+        ds.read(m_x[f]);
+        ds.read(m_y[f]);
+      }
+    }
+    ds.read(n);
+    m_pix.resize(n);
+    for (uint32_t f = 0; f < n; ++f) {
+      if (columns & COL_PIX16) {
+        ReadColumn<int16_t>(ds, m_pix[f]);
+      } else if (columns & COL_PIX32) {
+        ReadColumn<int32_t>(ds, m_pix[f]);
+      } else if (columns & COL_PIXDOUBLE) {
+        ds.read(m_pix[f]);
+      } else {
+        uint32_t npix;
+        ds.read(npix);
+        m_pix[f].assign(npix, 1);
+      }
+    }
+    if (columns & COL_TIME)
+      ds.read(m_time);
+    m_time.resize(m_x.size());
+    if (columns & COL_PIVOT)
+      ds.read(m_pivot);
+    if (columns & COL_SUBMAT)
+      ds.read(m_mat);
+    if (columns & COL_WAVEFORM) {
+      ds.read(n);
+      for (uint32_t i = 0; i < n; ++i) {
+        uint64_t key;
+        ds.read(key);
+        auto &wf = m_waveform[key];
+        ds.read(wf.x0);
+        ds.read(wf.dx);
+        ds.read(wf.data);
+      }
+    }
   }
 
   void StandardPlane::Serialize(Serializer &ser) const {
+    uint32_t coord_max = 0;
+    for (auto &frame: m_x)
+      for (auto x: frame)
+        coord_max = std::max(coord_max, x);
+    for (auto &frame: m_y)
+      for (auto y: frame)
+        coord_max = std::max(coord_max, y);
+    bool pix_one = true, pix16 = true, pix32 = true;
+    for (auto &frame: m_pix) {
+      for (auto p: frame) {
+        pix_one = pix_one && p == 1;
+        pix16 = pix16 && FitsInteger<int16_t>(p);
+        pix32 = pix32 && FitsInteger<int32_t>(p);
+      }
+    }
+    bool has_time = false;
+    for (auto &time: m_time)
+      has_time = has_time || !time.empty();
+
+    uint32_t columns = 0;
+    if (coord_max <= std::numeric_limits<uint16_t>::max())
+      columns |= COL_COORD16;
+    if (!pix_one)
+      columns |= pix16 ? COL_PIX16 : (pix32 ? COL_PIX32 : COL_PIXDOUBLE);
+    if (has_time)
+      columns |= COL_TIME;
+    if (!m_pivot.empty())
+      columns |= COL_PIVOT;
+    if (!m_mat.empty())
+      columns |= COL_SUBMAT;
+    if (!m_waveform.empty())
+      columns |= COL_WAVEFORM;
+
     ser.write(m_type);
     ser.write(m_sensor);
     ser.write(m_id);
     ser.write(m_xsize);
     ser.write(m_ysize);
-    ser.write(m_flags);
+    ser.write(m_flags | FLAG_SERIAL_COMPACT);
     ser.write(m_pivotpixel);
-    ser.write(m_pix);
-    ser.write(m_waveform);
-    ser.write(m_waveform_x0);
-    ser.write(m_waveform_dx);
-    ser.write(m_x);
-    ser.write(m_y);
-    ser.write(m_pivot);
-    ser.write(m_mat);
-    ser.write(m_time);
+    ser.write(SERIAL_VERSION);
+    ser.write(columns);
+    ser.write(uint32_t(m_x.size()));
+    for (size_t f = 0; f < m_x.size(); ++f) {
+      if (columns & COL_COORD16) {
+        WriteColumn<uint16_t>(ser, m_x[f]);
+        WriteColumn<uint16_t>(ser, m_y[f]);
+      } else {
+        ser.write(m_x[f]);
+        ser.write(m_y[f]);
+      }
+    }
+    ser.write(uint32_t(m_pix.size()));
+    for (auto &frame: m_pix) {
+      if (columns & COL_PIX16)
+        WriteColumn<int16_t>(ser, frame);
+      else if (columns & COL_PIX32)
+        WriteColumn<int32_t>(ser, frame);
+      else if (columns & COL_PIXDOUBLE)
+        ser.write(frame);
+      else
+        ser.write(uint32_t(frame.size()));
+    }
+    if (columns & COL_TIME)
+      ser.write(m_time);
+    if (columns & COL_PIVOT)
+      ser.write(m_pivot);
+    if (columns & COL_SUBMAT)
+      ser.write(m_mat);
+    if (columns & COL_WAVEFORM) {
+      ser.write(uint32_t(m_waveform.size()));
+      for (auto &wf: m_waveform) {
+        ser.write(wf.first);
+        ser.write(wf.second.x0);
+        ser.write(wf.second.dx);
+        ser.write(wf.second.data);
+      }
+    }
   }
 
 
@@ -74,10 +280,11 @@ namespace eudaq{
     // std::cout << "DBG flags " << hexdec(m_flags) << std::endl;
     m_xsize = w;
     m_ysize = h;
+    m_view_x_valid.clear();
+    m_view_y_valid.clear();
+    m_result_pix = 0;
+    m_result_xy = false;
     m_pix.resize(frames);
-    m_waveform.resize(frames);
-    m_waveform_x0.resize(frames);
-    m_waveform_dx.resize(frames);
     m_time.resize(GetFlags(FLAG_DIFFCOORDS) ? frames : 1);
     m_x.resize(GetFlags(FLAG_DIFFCOORDS) ? frames : 1);
     m_y.resize(GetFlags(FLAG_DIFFCOORDS) ? frames : 1);
@@ -90,10 +297,8 @@ namespace eudaq{
     for (size_t i = 0; i < m_x.size(); ++i) {
       m_x[i].resize(npix);
       m_y[i].resize(npix);
-      m_waveform[i].resize(npix);
-      m_waveform_x0[i].resize(npix);
-      m_waveform_dx[i].resize(npix);
-      m_time[i].resize(npix);
+      if (!m_time[i].empty())
+        m_time[i].resize(npix);
       if (m_pivot.size()) {
         m_pivot[i].resize(npix);
       }
@@ -104,13 +309,15 @@ namespace eudaq{
 				      bool pivot, uint32_t frame) {
     if (frame > m_x.size())
       EUDAQ_THROW("Bad frame number " + to_string(frame) + " in PushPixel");
+    InvalidateCache(frame);
     m_x[frame].push_back(x);
     m_y[frame].push_back(y);
     m_pix[frame].push_back(p);
-    m_waveform[frame].push_back(std::vector<double>());
-    m_waveform_x0[frame].push_back(0);
-    m_waveform_dx[frame].push_back(0);
-    m_time[frame].push_back(time_ps);
+    auto &time = m_time[frame];
+    if (time_ps || !time.empty()) {
+      time.resize(m_x[frame].size() - 1);
+      time.push_back(time_ps);
+    }
     if (m_pivot.size())
       m_pivot[frame].push_back(pivot);
     // std::cout << "DBG: " << frame << ", " << x << ", " << y << ", " << p <<
@@ -118,23 +325,29 @@ namespace eudaq{
   }
 
   void StandardPlane::SetWaveform(uint32_t index, std::vector<double> waveform, double x0, double dx, uint32_t frame) {
-    if (frame > m_x.size()) {
+    if (frame >= m_pix.size()) {
       EUDAQ_THROW("Bad frame number " + to_string(frame) + " in SetWaveform");
     }
 
-    if(index >= m_waveform.at(frame).size()) {
-      EUDAQ_THROW("Bad pixel index " + to_string(frame) + " in SetWaveform");
+    if(index >= m_pix[frame].size()) {
+      EUDAQ_THROW("Bad pixel index " + to_string(index) + " in SetWaveform");
     }
 
-    m_waveform.at(frame).at(index) = std::move(waveform);
-    m_waveform_x0.at(frame).at(index) = x0;
-    m_waveform_dx.at(frame).at(index) = dx;
+    if (waveform.empty()) {
+      m_waveform.erase(WaveformKey(index, frame));
+      return;
+    }
+    auto &wf = m_waveform[WaveformKey(index, frame)];
+    wf.data = std::move(waveform);
+    wf.x0 = x0;
+    wf.dx = dx;
   }
 
   void StandardPlane::SetPixelHelper(uint32_t index, uint32_t x, uint32_t y,
 				     double pix, uint64_t time_ps, bool pivot, uint32_t frame) {
     if (frame >= m_pix.size())
       EUDAQ_THROW("Bad frame number " + to_string(frame) + " in SetPixel");
+    InvalidateCache(frame);
     if (frame < m_x.size()) {
       m_x.at(frame).at(index) = x;
     }
@@ -147,52 +360,58 @@ namespace eudaq{
     if (frame < m_pix.size()) {
       m_pix.at(frame).at(index) = pix;
     }
-    if (frame < m_waveform.size()) {
-      m_waveform.at(frame).at(index) = std::vector<double>();
-    }
-    if (frame < m_waveform_x0.size()) {
-      m_waveform_x0.at(frame).at(index) = 0.;
-    }
-    if (frame < m_waveform_dx.size()) {
-      m_waveform_dx.at(frame).at(index) = 0.;
+    if (!m_waveform.empty()) {
+      m_waveform.erase(WaveformKey(index, frame));
     }
-    if (frame < m_time.size()) {
-      m_time.at(frame).at(index) = time_ps;
+    if (frame < m_time.size() && (time_ps || !m_time[frame].empty())) {
+      m_time[frame].resize(m_x[frame].size());
+      m_time[frame].at(index) = time_ps;
     }
   }
 
   void StandardPlane::SetFlags(StandardPlane::FLAGS flags) { m_flags |= flags; }
 
+  const StandardPlane::Waveform *
+  StandardPlane::GetWaveformEntry(uint32_t index, uint32_t frame) const {
+    if (m_waveform.empty())
+      return nullptr;
+    auto it = m_waveform.find(WaveformKey(index, frame));
+    return it == m_waveform.end() ? nullptr : &it->second;
+  }
+
   bool StandardPlane::HasWaveform(uint32_t index, uint32_t frame) const {
-    return !m_waveform.at(frame).at(index).empty();
+    return GetWaveformEntry(index, frame) != nullptr;
   }
 
   std::vector<double> StandardPlane::GetWaveform(uint32_t index, uint32_t frame) const {
-    return m_waveform.at(frame).at(index);
+    auto wf = GetWaveformEntry(index, frame);
+    return wf ? wf->data : std::vector<double>();
   }
   double StandardPlane::GetWaveformX0(uint32_t index, uint32_t frame) const {
-    return m_waveform_x0.at(frame).at(index);
+    auto wf = GetWaveformEntry(index, frame);
+    return wf ? wf->x0 : 0;
   }
   double StandardPlane::GetWaveformDX(uint32_t index, uint32_t frame) const {
-    return m_waveform_dx.at(frame).at(index);
+    auto wf = GetWaveformEntry(index, frame);
+    return wf ? wf->dx : 0;
   }
 
   bool StandardPlane::HasWaveform(uint32_t index) const {
-    SetupResult();
-    return !m_result_waveform->at(index).empty();
+    auto p = ResultPixel(index);
+    return HasWaveform(p.second, p.first);
   }
 
   std::vector<double> StandardPlane::GetWaveform(uint32_t index) const {
-    SetupResult();
-    return m_result_waveform->at(index);
+    auto p = ResultPixel(index);
+    return GetWaveform(p.second, p.first);
   }
   double StandardPlane::GetWaveformX0(uint32_t index) const {
-    SetupResult();
-    return m_result_waveform_x0->at(index);
+    auto p = ResultPixel(index);
+    return GetWaveformX0(p.second, p.first);
   }
   double StandardPlane::GetWaveformDX(uint32_t index) const {
-    SetupResult();
-    return m_result_waveform_dx->at(index);
+    auto p = ResultPixel(index);
+    return GetWaveformDX(p.second, p.first);
   }
 
   double StandardPlane::GetPixel(uint32_t index, uint32_t frame) const {
@@ -205,11 +424,14 @@ namespace eudaq{
   uint64_t StandardPlane::GetTimestamp(uint32_t index, uint32_t frame) const {
       if (!GetFlags(FLAG_DIFFCOORDS))
         frame = 0;
-      return m_time.at(frame).at(index);
+      auto &time = m_time.at(frame);
+      if (time.empty() && index < m_x.at(frame).size())
+        return 0;
+      return time.at(index);
   }
   uint64_t StandardPlane::GetTimestamp(uint32_t index) const {
-    SetupResult();
-    return m_result_time->at(index);
+    auto p = ResultPixel(index);
+    return GetTimestamp(p.second, p.first);
   }
   double StandardPlane::GetX(uint32_t index, uint32_t frame) const {
     if (!GetFlags(FLAG_DIFFCOORDS))
@@ -217,8 +439,8 @@ namespace eudaq{
     return m_x.at(frame).at(index);
   }
   double StandardPlane::GetX(uint32_t index) const {
-    SetupResult();
-    return m_result_x->at(index);
+    auto p = ResultPixel(index);
+    return GetX(p.second, p.first);
   }
   double StandardPlane::GetY(uint32_t index, uint32_t frame) const {
     if (!GetFlags(FLAG_DIFFCOORDS))
@@ -226,8 +448,8 @@ namespace eudaq{
     return m_y.at(frame).at(index);
   }
   double StandardPlane::GetY(uint32_t index) const {
-    SetupResult();
-    return m_result_y->at(index);
+    auto p = ResultPixel(index);
+    return GetY(p.second, p.first);
   }
   bool StandardPlane::GetPivot(uint32_t index, uint32_t frame) const {
     if (!GetFlags(FLAG_DIFFCOORDS))
@@ -237,26 +459,27 @@ namespace eudaq{
 
   void StandardPlane::SetPivot(uint32_t index, uint32_t frame, bool PivotFlag) {
     m_pivot.at(frame).at(index) = PivotFlag;
+    InvalidateCache(frame);
   }
 
   const std::vector<StandardPlane::coord_t> &
   StandardPlane::XVector(uint32_t frame) const {
-    return GetFrame(m_x, frame);
+    return GetView(m_x, m_view_x, m_view_x_valid, frame);
   }
 
   const std::vector<StandardPlane::coord_t> &StandardPlane::XVector() const {
-    SetupResult();
-    return *m_result_x;
+    SetupResultXY();
+    return m_result_x;
   }
 
   const std::vector<StandardPlane::coord_t> &
   StandardPlane::YVector(uint32_t frame) const {
-    return GetFrame(m_y, frame);
+    return GetView(m_y, m_view_y, m_view_y_valid, frame);
   }
 
   const std::vector<StandardPlane::coord_t> &StandardPlane::YVector() const {
-    SetupResult();
-    return *m_result_y;
+    SetupResultXY();
+    return m_result_y;
   }
 
   const std::vector<StandardPlane::pixel_t> &
@@ -314,42 +537,73 @@ namespace eudaq{
     return v.at(f);
   }
 
+  const std::vector<StandardPlane::coord_t> &
+  StandardPlane::GetView(const std::vector<std::vector<uint32_t>> &v,
+			 std::vector<std::vector<coord_t>> &view,
+			 std::vector<bool> &valid, uint32_t f) const {
+    auto &src = v.at(f);
+    if (view.size() < v.size()) {
+      view.resize(v.size());
+      valid.resize(v.size(), false);
+    }
+    if (!valid[f]) {
+      view[f].assign(src.begin(), src.end());
+      valid[f] = true;
+    }
+    return view[f];
+  }
+
+  void StandardPlane::InvalidateCache(uint32_t frame) {
+    if (frame < m_view_x_valid.size())
+      m_view_x_valid[frame] = false;
+    if (frame < m_view_y_valid.size())
+      m_view_y_valid[frame] = false;
+    m_result_pix = 0;
+    m_result_xy = false;
+  }
+
+  std::pair<uint32_t, uint32_t> StandardPlane::ResultPixel(uint32_t index) const {
+    SetupResult();
+    if (m_result_mapped)
+      return m_result_ref.at(index);
+    return std::make_pair(uint32_t(0), index);
+  }
+
+  void StandardPlane::SetupResultXY() const {
+    SetupResult();
+    if (m_result_xy)
+      return;
+    if (m_result_mapped) {
+      m_result_x.resize(m_result_ref.size());
+      m_result_y.resize(m_result_ref.size());
+      for (size_t i = 0; i < m_result_ref.size(); ++i) {
+        m_result_x[i] = GetX(m_result_ref[i].second, m_result_ref[i].first);
+        m_result_y[i] = GetY(m_result_ref[i].second, m_result_ref[i].first);
+      }
+    } else {
+      m_result_x.assign(m_x[0].begin(), m_x[0].end());
+      m_result_y.assign(m_y[0].begin(), m_y[0].end());
+    }
+    m_result_xy = true;
+  }
+
   void StandardPlane::SetupResult() const {
     if (m_result_pix)
       return;
-    m_result_x = &m_x[0];
-    m_result_y = &m_y[0];
-    m_result_time = &m_time[0];
-    m_result_waveform = &m_waveform[0];
-    m_result_waveform_x0 = &m_waveform_x0[0];
-    m_result_waveform_dx = &m_waveform_dx[0];
+    m_result_mapped = false;
+    m_result_ref.clear();
+    m_result_xy = false;
 
     if (GetFlags(FLAG_ACCUMULATE)) {
       m_temp_pix.resize(0);
-      m_temp_x.resize(0);
-      m_temp_y.resize(0);
-      m_temp_time.resize(0);
-      m_temp_waveform.resize(0);
-      m_temp_waveform_x0.resize(0);
-      m_temp_waveform_dx.resize(0);
       for (size_t f = 0; f < m_pix.size(); ++f) {
         for (size_t p = 0; p < m_pix[f].size(); ++p) {
-          m_temp_x.push_back(GetX(p, f));
-          m_temp_y.push_back(GetY(p, f));
           m_temp_pix.push_back(GetPixel(p, f));
-          m_temp_time.push_back(GetTimestamp(p,f));
-          m_temp_waveform.push_back(GetWaveform(p, f));
-          m_temp_waveform_x0.push_back(GetWaveformX0(p, f));
-          m_temp_waveform_dx.push_back(GetWaveformDX(p,f));
+          m_result_ref.emplace_back(f, p);
         }
       }
-      m_result_x = &m_temp_x;
-      m_result_y = &m_temp_y;
+      m_result_mapped = true;
       m_result_pix = &m_temp_pix;
-      m_result_time = & m_temp_time;
-      m_result_waveform = &m_temp_waveform;
-      m_result_waveform_x0 = &m_temp_waveform_x0;
-      m_result_waveform_dx = &m_temp_waveform_dx;
     } else if (m_pix.size() == 1 && !GetFlags(FLAG_NEEDCDS)) {
       m_result_pix = &m_pix[0];
     } else if (m_pix.size() == 2) {
@@ -365,51 +619,27 @@ namespace eudaq{
           for (size_t i = 0; i < m_temp_pix.size(); ++i) {
             m_temp_pix[i] = m_pix[1 - m_pivot[0][i]][i];
           }
-          m_temp_waveform = m_waveform[0];
-          m_temp_waveform_x0 = m_waveform_x0[0];
-          m_temp_waveform_dx = m_waveform_dx[0];
         } else {
-          m_temp_x.resize(0);
-          m_temp_y.resize(0);
           m_temp_pix.resize(0);
-          m_temp_time.resize(0);
-          m_temp_waveform.resize(0);
-          m_temp_waveform_x0.resize(0);
-          m_temp_waveform_dx.resize(0);
           const bool inverse = false;
           size_t i;
           for (i = 0; i < m_pix[1 - inverse].size(); ++i) {
             if (m_pivot[1][i])
             break;
-            m_temp_x.push_back(m_x[1 - inverse][i]);
-            m_temp_y.push_back(m_y[1 - inverse][i]);
             m_temp_pix.push_back(m_pix[1 - inverse][i]);
-            m_temp_time.push_back(m_time[1-inverse][i]);
-            m_temp_waveform.push_back(GetWaveform(i, 1-inverse));
-            m_temp_waveform_x0.push_back(GetWaveformX0(i, 1-inverse));
-            m_temp_waveform_dx.push_back(GetWaveformDX(i, 1-inverse));
+            m_result_ref.emplace_back(1 - inverse, i);
           }
           for (i = 0; i < m_pix[0 + inverse].size(); ++i) {
             if (m_pivot[0 + inverse][i])
             break;
           }
           for (/**/; i < m_pix[0 + inverse].size(); ++i) {
-            m_temp_x.push_back(m_x[0 + inverse][i]);
-            m_temp_y.push_back(m_y[0 + inverse][i]);
             m_temp_pix.push_back(m_pix[0 + inverse][i]);
-            m_temp_time.push_back(m_time[0 + inverse][i]);
-            m_temp_waveform.push_back(GetWaveform(i, 0 + inverse));
-            m_temp_waveform_x0.push_back(GetWaveformX0(i, 0 + inverse));
-            m_temp_waveform_dx.push_back(GetWaveformDX(i, 0 + inverse));
+            m_result_ref.emplace_back(0 + inverse, i);
           }
-          m_result_x = &m_temp_x;
-          m_result_y = &m_temp_y;
-          m_result_time = &m_temp_time;
+          m_result_mapped = true;
         }
         m_result_pix = &m_temp_pix;
-        m_result_waveform = &m_temp_waveform;
-        m_result_waveform_x0 = &m_temp_waveform_x0;
-        m_result_waveform_dx = &m_temp_waveform_dx;
       }
     } else if (m_pix.size() == 3 && GetFlags(FLAG_NEEDCDS)) {
       m_temp_pix.resize(m_pix[0].size());
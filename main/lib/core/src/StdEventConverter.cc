@@ -1,10 +1,134 @@
 #include "eudaq/StdEventConverter.hh"
+#include "eudaq/Logger.hh"
+
+#include <algorithm>
+#include <iostream>
 
 namespace eudaq{
 
   template DLLEXPORT
   std::map<uint32_t, typename Factory<StdEventConverter>::UP(*)()>&
   Factory<StdEventConverter>::Instance<>();
+
+  namespace{
+    // The converters of one thread by (event type, configuration), in an open
+    // addressing table. A converter is dropped once its configuration is gone.
+    class ConverterCache{
+    public:
+      ConverterCache() :m_n(0), m_n_sweep(64){}
+      ~ConverterCache(){Clear();}
+      StdEventConverter *Get(uint32_t id, const ConfigurationSPC &conf);
+      void Clear();
+    private:
+      struct Slot{
+	Slot() :used(false), id(0), conf_ptr(nullptr){}
+	bool used;
+	uint32_t id;
+	const Configuration *conf_ptr;
+	std::weak_ptr<const Configuration> conf;
+	StdEventConverterUP cvt;
+      };
+      static size_t Hash(uint32_t id, const Configuration *conf);
+      static void Terminate(Slot &s);
+      void Rebuild(size_t size);
+      std::vector<Slot> m_slots;
+      size_t m_n;
+      size_t m_n_sweep;
+    };
+
+    thread_local ConverterCache converter_cache;
+  }
+
+  size_t ConverterCache::Hash(uint32_t id, const Configuration *conf){
+    uint64_t h = (uint64_t(id) << 32) ^ uint64_t(reinterpret_cast<uintptr_t>(conf));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return size_t(h);
+  }
+
+  StdEventConverter *ConverterCache::Get(uint32_t id, const ConfigurationSPC &conf){
+    const Configuration *conf_ptr = conf.get();
+    if(!m_slots.empty()){
+      size_t mask = m_slots.size() - 1;
+      for(size_t i = Hash(id, conf_ptr) & mask; m_slots[i].used; i = (i + 1) & mask){
+	auto &s = m_slots[i];
+	//an expired configuration may have left its address to a new one
+	if(s.id == id && s.conf_ptr == conf_ptr && (!conf_ptr || !s.conf.expired()))
+	  return s.cvt.get();
+      }
+    }
+    if(m_n >= m_n_sweep){
+      //converters in use have a living configuration, only the others go
+      Rebuild(m_slots.size());
+      m_n_sweep = std::max(m_n_sweep, 2 * m_n);
+    }
+    if(2 * (m_n + 1) > m_slots.size())
+      Rebuild(m_slots.empty() ? 16 : 2 * m_slots.size());
+    auto cvt = Factory<StdEventConverter>::MakeUnique(id);
+    if(cvt)
+      cvt->Initialise(conf);
+    size_t mask = m_slots.size() - 1;
+    size_t i = Hash(id, conf_ptr) & mask;
+    while(m_slots[i].used)
+      i = (i + 1) & mask;
+    //a missing converter is remembered as well
+    auto &s = m_slots[i];
+    s.used = true;
+    s.id = id;
+    s.conf_ptr = conf_ptr;
+    s.conf = conf;
+    s.cvt = std::move(cvt);
+    m_n++;
+    return s.cvt.get();
+  }
+
+  void ConverterCache::Rebuild(size_t size){
+    std::vector<Slot> slots(size);
+    slots.swap(m_slots);
+    m_n = 0;
+    size_t mask = m_slots.size() - 1;
+    for(auto &s: slots){
+      if(!s.used)
+	continue;
+      if(s.conf_ptr && s.conf.expired()){
+	Terminate(s);
+	continue;
+      }
+      size_t i = Hash(s.id, s.conf_ptr) & mask;
+      while(m_slots[i].used)
+	i = (i + 1) & mask;
+      m_slots[i] = std::move(s);
+      m_n++;
+    }
+  }
+
+  void ConverterCache::Terminate(Slot &s){
+    if(!s.cvt)
+      return;
+    try{
+      s.cvt->Terminate();
+    }
+    catch(const std::exception &e){
+      EUDAQ_WARN(std::string("StdEventConverter: Terminate failed: ") + e.what());
+    }
+    s.cvt.reset();
+  }
+
+  void ConverterCache::Clear(){
+    for(auto &s: m_slots)
+      Terminate(s);
+    m_slots.clear();
+    m_n = 0;
+  }
+
+  StdEventConverter *StdEventConverter::GetConverter(uint32_t id, ConfigurationSPC conf){
+    return converter_cache.Get(id, conf);
+  }
+
+  void StdEventConverter::ClearConverters(){
+    converter_cache.Clear();
+  }
   
   bool StdEventConverter::Convert(EventSPC d1, StdEventSP d2, ConfigurationSPC conf){
 
@@ -42,7 +166,7 @@ namespace eudaq{
       d2->SetDescription(d1->GetDescription());
     }
     uint32_t id = d1->GetType();
-    auto cvt = Factory<StdEventConverter>::MakeUnique(id);
+    auto cvt = GetConverter(id, conf);
     if(cvt){
       return cvt->Converting(d1, d2, conf);
     }
@@ -0,0 +1,309 @@
+#include "eudaq/TimestampEventBuilder.hh"
+#include "eudaq/Exception.hh"
+
+#include <algorithm>
+
+namespace eudaq {
+
+  TimestampEventBuilder::TimestampEventBuilder()
+    :m_policy(WINDOW_INTERSECT), m_width(0), m_trigger_id(-1), m_timeout(0),
+     m_starved_n(0), m_late(false), m_flush(false), m_open(false),
+     m_ts_done(0), m_dropped_n(0), m_tp_status(std::chrono::steady_clock::now()){
+  }
+
+  TimestampEventBuilder::WindowPolicy TimestampEventBuilder::Str2Policy(const std::string &policy){
+    if(policy == "intersect")
+      return WINDOW_INTERSECT;
+    else if(policy == "overlap")
+      return WINDOW_OVERLAP;
+    else if(policy == "fixed")
+      return WINDOW_FIXED;
+    else if(policy == "trigger")
+      return WINDOW_TRIGGER;
+    EUDAQ_THROW("TimestampEventBuilder: unknown window policy " + policy);
+  }
+
+  void TimestampEventBuilder::MergeStatus(std::map<std::string, StreamStatus> &status,
+					  const std::vector<StreamStatus> &add){
+    for(auto &st: add){
+      auto it = status.find(st.name);
+      if(it == status.end()){
+	status[st.name] = st;
+	continue;
+      }
+      it->second.received_n += st.received_n;
+      it->second.built_n += st.built_n;
+      it->second.late_n += st.late_n;
+      it->second.queued_n += st.queued_n;
+      it->second.rate += st.rate;
+    }
+  }
+
+  void TimestampEventBuilder::Configure(const Configuration &conf){
+    auto policy = Str2Policy(conf.Get("EUDAQ_TS_WINDOW", "intersect"));
+    uint64_t width = conf.Get("EUDAQ_TS_WINDOW_WIDTH", uint64_t(0));
+    if(policy == WINDOW_FIXED && !width)
+      EUDAQ_THROW("TimestampEventBuilder: EUDAQ_TS_WINDOW_WIDTH is needed by the fixed window");
+    SetPolicy(policy);
+    SetWindowWidth(width);
+    SetTriggerStream(conf.Get("EUDAQ_TS_TRIGGER_PRODUCER", ""));
+    SetTimeout(std::chrono::milliseconds(conf.Get("EUDAQ_TS_TIMEOUT_MS", 0)));
+  }
+
+  void TimestampEventBuilder::SetPolicy(WindowPolicy policy){
+    m_policy = policy;
+  }
+
+  void TimestampEventBuilder::SetWindowWidth(uint64_t width){
+    m_width = width;
+  }
+
+  void TimestampEventBuilder::SetTriggerStream(const std::string &name){
+    m_trigger_name = name;
+    m_trigger_id = -1;
+    for(uint32_t i = 0; i < m_streams.size(); i++)
+      if(m_streams[i].name == name)
+	m_trigger_id = i;
+  }
+
+  void TimestampEventBuilder::SetTimeout(std::chrono::milliseconds timeout){
+    m_timeout = timeout;
+  }
+
+  uint32_t TimestampEventBuilder::AddStream(const std::string &name){
+    uint32_t id = m_streams.size();
+    for(uint32_t i = 0; i < m_streams.size(); i++){
+      if(m_streams[i].name != name)
+	continue;
+      if(!m_streams[i].closed)
+	EUDAQ_THROW("TimestampEventBuilder: multiple streams are sharing the name " + name);
+      if(m_streams[i].que.empty())
+	id = i;
+    }
+    if(id == m_streams.size())
+      m_streams.push_back(Stream());
+    Stream &st = m_streams[id];
+    st.name = name;
+    st.que.clear();
+    st.closed = false;
+    st.tp_last = std::chrono::steady_clock::now();
+    st.ts_last = 0;
+    st.received_n = 0;
+    st.built_n = 0;
+    st.late_n = 0;
+    st.rate_n = 0;
+    st.sliced = false;
+    st.carry.reset();
+    m_starved_n++;
+    if(name == m_trigger_name)
+      m_trigger_id = id;
+    return id;
+  }
+
+  void TimestampEventBuilder::CloseStream(uint32_t id){
+    Stream &st = m_streams.at(id);
+    if(st.closed)
+      return;
+    st.closed = true;
+    if(st.que.empty())
+      m_starved_n--;
+  }
+
+  void TimestampEventBuilder::Push(uint32_t id, EventSPC ev){
+    Stream &st = m_streams.at(id);
+    uint64_t ts_beg = ev->GetTimestampBegin();
+    if(ts_beg < st.ts_last)
+      EUDAQ_THROW("TimestampEventBuilder: events of " + st.name + " are not ordered in time");
+    st.ts_last = ts_beg;
+    st.tp_last = std::chrono::steady_clock::now();
+    st.received_n++;
+    if(ts_beg < m_ts_done){
+      //its slice is already built
+      st.late_n++;
+      return;
+    }
+    if(st.que.empty()){
+      m_heap.push_back(Head{ts_beg, id});
+      std::push_heap(m_heap.begin(), m_heap.end());
+      if(!st.closed)
+	m_starved_n--;
+    }
+    st.que.push_back(std::move(ev));
+  }
+
+  bool TimestampEventBuilder::CanMerge(){
+    if(!m_starved_n || m_flush)
+      return true;
+    if(m_timeout.count() == 0)
+      return false;
+    //the streams are scanned at most once per millisecond
+    auto tp = std::chrono::steady_clock::now();
+    if(tp - m_tp_check < std::chrono::milliseconds(1))
+      return m_late;
+    m_tp_check = tp;
+    m_late = true;
+    for(auto &st: m_streams)
+      if(!st.closed && st.que.empty() && tp - st.tp_last < m_timeout)
+	m_late = false;
+    return m_late;
+  }
+
+  EventSPC TimestampEventBuilder::PopHead(){
+    std::pop_heap(m_heap.begin(), m_heap.end());
+    uint32_t id = m_heap.back().id;
+    m_heap.pop_back();
+    Stream &st = m_streams[id];
+    EventSPC ev = std::move(st.que.front());
+    st.que.pop_front();
+    if(!st.que.empty()){
+      m_heap.push_back(Head{st.que.front()->GetTimestampBegin(), id});
+      std::push_heap(m_heap.begin(), m_heap.end());
+    }
+    else if(!st.closed){
+      m_starved_n++;
+      m_late = false;
+    }
+    return ev;
+  }
+
+  void TimestampEventBuilder::AddToSlice(uint32_t id, EventSPC ev){
+    uint64_t ts_beg = ev->GetTimestampBegin();
+    uint64_t ts_end = std::max(ev->GetTimestampEnd(), ts_beg + 1);
+    if(!m_open){
+      m_open = true;
+      m_slice.evs.clear();
+      m_slice.ts_beg = ts_beg;
+      m_slice.ts_end = ts_end;
+      m_slice_ids.clear();
+      if(m_policy == WINDOW_FIXED && m_width){
+	m_slice.ts_beg = ts_beg - ts_beg % m_width;
+	m_slice.ts_end = m_slice.ts_beg + m_width;
+      }
+      else if(m_policy == WINDOW_TRIGGER && m_width)
+	m_slice.ts_end = ts_beg + m_width;
+    }
+    else if(m_policy == WINDOW_OVERLAP)
+      m_slice.ts_end = std::max(m_slice.ts_end, ts_end);
+    else if(m_policy == WINDOW_INTERSECT)
+      m_slice.ts_end = std::min(m_slice.ts_end, ts_end);
+    m_slice.evs.push_back(std::move(ev));
+    m_slice_ids.push_back(id);
+    m_streams[id].sliced = true;
+    m_streams[id].built_n++;
+  }
+
+  void TimestampEventBuilder::CloseIntersect(){
+    //the window ends with the earliest event, so each stream has at most one
+    //event in it; a stream without one adds the event still running from an
+    //earlier slice, if any
+    std::vector<uint32_t> carry_ids;
+    for(auto id: m_carry_ids){
+      Stream &st = m_streams[id];
+      if(st.sliced)
+	continue;
+      uint64_t ts_end = std::max(st.carry->GetTimestampEnd(), st.carry->GetTimestampBegin() + 1);
+      if(ts_end > m_slice.ts_beg)
+	m_slice.evs.push_back(st.carry);
+      if(ts_end > m_slice.ts_end)
+	carry_ids.push_back(id);
+      else
+	st.carry.reset();
+    }
+    for(size_t i = 0; i < m_slice_ids.size(); i++){
+      Stream &st = m_streams[m_slice_ids[i]];
+      st.sliced = false;
+      const EventSPC &ev = m_slice.evs[i];
+      if(std::max(ev->GetTimestampEnd(), ev->GetTimestampBegin() + 1) > m_slice.ts_end){
+	st.carry = ev;
+	carry_ids.push_back(m_slice_ids[i]);
+      }
+      else
+	st.carry.reset();
+    }
+    std::swap(m_carry_ids, carry_ids);
+  }
+
+  bool TimestampEventBuilder::Pop(Slice &slice){
+    while(CanMerge()){
+      if(!m_heap.empty()){
+	const Head &top = m_heap.front();
+	bool in_slice = m_open && top.ts_beg < m_slice.ts_end;
+	if(m_policy == WINDOW_TRIGGER && top.id == m_trigger_id)
+	  in_slice = false;
+	if(in_slice || !m_open){
+	  uint32_t id = top.id;
+	  EventSPC ev = PopHead();
+	  if(!m_open && m_policy == WINDOW_TRIGGER && id != m_trigger_id){
+	    //outside of any trigger window
+	    m_dropped_n++;
+	    continue;
+	  }
+	  AddToSlice(id, std::move(ev));
+	  continue;
+	}
+      }
+      //the next event starts after the slice, or nothing more can arrive
+      if(!m_open)
+	return false;
+      m_open = false;
+      if(m_policy == WINDOW_INTERSECT)
+	CloseIntersect();
+      m_ts_done = m_slice.ts_end;
+      std::swap(slice, m_slice);
+      return true;
+    }
+    return false;
+  }
+
+  void TimestampEventBuilder::Flush(){
+    m_flush = true;
+  }
+
+  void TimestampEventBuilder::Reset(){
+    for(auto &st: m_streams){
+      st.que.clear();
+      st.ts_last = 0;
+      st.received_n = 0;
+      st.built_n = 0;
+      st.late_n = 0;
+      st.rate_n = 0;
+      st.sliced = false;
+      st.carry.reset();
+    }
+    m_heap.clear();
+    m_slice_ids.clear();
+    m_carry_ids.clear();
+    m_starved_n = 0;
+    for(auto &st: m_streams)
+      if(!st.closed)
+	m_starved_n++;
+    m_late = false;
+    m_flush = false;
+    m_open = false;
+    m_slice.evs.clear();
+    m_ts_done = 0;
+    m_dropped_n = 0;
+    m_tp_status = std::chrono::steady_clock::now();
+  }
+
+  std::vector<TimestampEventBuilder::StreamStatus> TimestampEventBuilder::GetStreamStatus(){
+    auto tp = std::chrono::steady_clock::now();
+    double dt = std::chrono::duration<double>(tp - m_tp_status).count();
+    m_tp_status = tp;
+    std::vector<StreamStatus> status;
+    for(auto &st: m_streams){
+      if(st.closed && st.que.empty())
+	continue;
+      StreamStatus s;
+      s.name = st.name;
+      s.received_n = st.received_n;
+      s.built_n = st.built_n;
+      s.late_n = st.late_n;
+      s.queued_n = st.que.size();
+      s.rate = dt > 0 ? (st.received_n - st.rate_n) / dt : 0;
+      st.rate_n = st.received_n;
+      status.push_back(s);
+    }
+    return status;
+  }
+}
@@ -26,6 +26,13 @@ namespace eudaq {
     m_callback = callback;
   }
 
+  void TransportBase::SendPackets(const std::vector<PacketRef> &packets,
+                                  const ConnectionInfo &inf) {
+    for (auto &packet : packets) {
+      SendPacket(packet.data, packet.size, inf);
+    }
+  }
+
   void TransportBase::Process(int timeout) {
     if (timeout == -1)
       timeout = DEFAULT_TIMEOUT;
@@ -36,7 +43,7 @@ namespace eudaq {
       std::unique_lock<std::recursive_mutex> lk(m_mutex);
       if (m_events.empty())
         break;
-      TransportEvent evt(m_events.front());
+      TransportEvent evt(std::move(m_events.front()));
       m_events.pop();
       lk.unlock();
       m_callback(evt);
@@ -61,7 +68,7 @@ namespace eudaq {
     bool ret = false;
     if (!m_events.empty() && conn.Matches(*(m_events.front().id))) {
       ret = true;
-      *packet = m_events.front().packet;
+      *packet = std::move(m_events.front().packet);
       m_events.pop();
     }
     return ret;
@@ -0,0 +1,764 @@
+#include "eudaq/TransportSHM.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Time.hh"
+#include "eudaq/Utils.hh"
+#include "eudaq/Logger.hh"
+
+#if EUDAQ_PLATFORM_IS(LINUX)
+
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <new>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+namespace eudaq {
+
+  const std::string SHMServer::name = "shm";
+  const std::string SHMClient::name = "shm";
+
+  namespace{
+    auto d0=Factory<TransportServer>::Register<SHMServer, const std::string&>
+      (str2hash(SHMServer::name));
+    auto d1=Factory<TransportClient>::Register<SHMClient, const std::string&>
+      (str2hash(SHMClient::name));
+  }
+
+  struct ShmRingHeader {
+    alignas(64) std::atomic<uint64_t> head; // bytes written, by the writer
+    alignas(64) std::atomic<uint64_t> tail; // bytes read, by the reader
+    alignas(64) std::atomic<uint32_t> rd_waiting;
+    alignas(64) std::atomic<uint32_t> wr_waiting;
+  };
+
+  namespace {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+		  "the rings need lock-free atomics in shared memory");
+
+    struct ShmSegment {
+      uint32_t magic;
+      uint32_t version;
+      uint64_t c2s_size;
+      uint64_t s2c_size;
+    };
+
+    static const uint32_t SHM_MAGIC = 0x4d485345; // "ESHM"
+    static const uint32_t SHM_VERSION = 1;
+    // the segment header and both ring headers fill the first page
+    static const size_t SHM_HEADER_SIZE = 4096;
+    static const size_t SHM_C2S_OFFSET = 256;
+    static const size_t SHM_S2C_OFFSET = 512;
+    // the client to server ring carries the data, the other one the replies
+    static const uint64_t SHM_C2S_SIZE = 16 * 1024 * 1024;
+    static const uint64_t SHM_S2C_SIZE = 1024 * 1024;
+    enum { C2S_DATA, C2S_SPACE, S2C_DATA, S2C_SPACE, SHM_EFD_N };
+    static const int MAX_EPOLL_EVENTS = 64;
+    static const int MAXPENDING = 16;
+    static const size_t MAX_NAME_SIZE = 100;
+    // the client hands over its segment right after connecting
+    static const std::chrono::seconds SHM_HANDSHAKE_TIMEOUT(1);
+
+    static std::string LastErrorString(const std::string &msg) {
+      return msg + ": " + std::strerror(errno);
+    }
+
+    static bool is_pow2(uint64_t n) { return n && !(n & (n - 1)); }
+
+    static socklen_t make_address(const std::string &name, sockaddr_un &addr) {
+      // abstract namespace, nothing is left behind in the file system
+      std::memset(&addr, 0, sizeof addr);
+      addr.sun_family = AF_UNIX;
+      std::string path = "eudaq-shm-" + name;
+      std::memcpy(addr.sun_path + 1, path.data(), path.size());
+      return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + path.size());
+    }
+
+    static void close_fds(const int *fds, size_t n) {
+      for (size_t i = 0; i < n; i++)
+        if (fds[i] >= 0)
+          close(fds[i]);
+    }
+
+    static bool send_fds(int sock, const int *fds, size_t n) {
+      char byte = 0;
+      iovec iov;
+      iov.iov_base = &byte;
+      iov.iov_len = 1;
+      union {
+        cmsghdr h;
+        char buf[CMSG_SPACE(sizeof(int) * (SHM_EFD_N + 1))];
+      } u;
+      std::memset(&u, 0, sizeof u);
+      msghdr msg;
+      std::memset(&msg, 0, sizeof msg);
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = u.buf;
+      msg.msg_controllen = CMSG_SPACE(sizeof(int) * n);
+      cmsghdr *c = CMSG_FIRSTHDR(&msg);
+      c->cmsg_level = SOL_SOCKET;
+      c->cmsg_type = SCM_RIGHTS;
+      c->cmsg_len = CMSG_LEN(sizeof(int) * n);
+      std::memcpy(CMSG_DATA(c), fds, sizeof(int) * n);
+      ssize_t result;
+      do {
+        result = sendmsg(sock, &msg, MSG_NOSIGNAL);
+      } while (result < 0 && errno == EINTR);
+      return result == 1;
+    }
+
+    // 1 if received, 0 if nothing is there yet, -1 on error
+    static int recv_fds(int sock, int *fds, size_t n) {
+      char byte;
+      iovec iov;
+      iov.iov_base = &byte;
+      iov.iov_len = 1;
+      union {
+        cmsghdr h;
+        char buf[CMSG_SPACE(sizeof(int) * (SHM_EFD_N + 1))];
+      } u;
+      msghdr msg;
+      std::memset(&msg, 0, sizeof msg);
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = u.buf;
+      msg.msg_controllen = sizeof u.buf;
+      ssize_t result;
+      do {
+        result = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+      } while (result < 0 && errno == EINTR);
+      if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+      if (result != 1)
+        return -1;
+      cmsghdr *c = CMSG_FIRSTHDR(&msg);
+      if (!c || c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS)
+        return -1;
+      size_t got = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      std::vector<int> recvd(got);
+      std::memcpy(recvd.data(), CMSG_DATA(c), sizeof(int) * got);
+      if (got != n || (msg.msg_flags & MSG_CTRUNC)) {
+        close_fds(recvd.data(), got);
+        return -1;
+      }
+      std::copy(recvd.begin(), recvd.end(), fds);
+      return 1;
+    }
+
+    static void ring_copy_in(ShmRing &r, uint64_t pos, const unsigned char *src,
+                             size_t n) {
+      size_t at = pos & (r.size - 1);
+      size_t k = std::min<size_t>(n, r.size - at);
+      std::memcpy(r.data + at, src, k);
+      std::memcpy(r.data, src + k, n - k);
+    }
+
+    static void ring_copy_out(ShmRing &r, uint64_t pos, unsigned char *dst,
+                              size_t n) {
+      size_t at = pos & (r.size - 1);
+      size_t k = std::min<size_t>(n, r.size - at);
+      std::memcpy(dst, r.data + at, k);
+      std::memcpy(dst + k, r.data, n - k);
+    }
+  } // anonymous namespace
+
+  ConnectionInfoSHM::ConnectionInfoSHM(int sock, int memfd, const int *efd,
+                                       bool server, const std::string &remote)
+      : ConnectionInfo(""), m_sock(sock), m_remote(remote), m_base(nullptr),
+        m_base_len(0), m_have_len(false), m_got(0) {
+    std::copy(efd, efd + SHM_EFD_N, m_efd);
+    size_t len = 0;
+    std::string err;
+    if (!server) {
+      len = SHM_HEADER_SIZE + SHM_C2S_SIZE + SHM_S2C_SIZE;
+      if (ftruncate(memfd, len))
+        err = LastErrorString("Failed to size the shared segment");
+      // the server maps it too, it must not shrink below its feet
+      else if (fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL))
+        err = LastErrorString("Failed to seal the shared segment");
+    } else {
+      struct stat st;
+      if (fstat(memfd, &st))
+        err = LastErrorString("Failed to stat the shared segment");
+      else if (!(fcntl(memfd, F_GET_SEALS) & F_SEAL_SHRINK))
+        err = "The shared segment is not sealed";
+      else
+        len = st.st_size;
+      if (err.empty() && len < SHM_HEADER_SIZE)
+        err = "The shared segment is too small";
+    }
+    if (err.empty()) {
+      m_base = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+      if (m_base == MAP_FAILED) {
+        m_base = nullptr;
+        err = LastErrorString("Failed to map the shared segment");
+      } else
+        m_base_len = len;
+    }
+    close(memfd);
+    unsigned char *base = static_cast<unsigned char *>(m_base);
+    ShmSegment *seg = reinterpret_cast<ShmSegment *>(base);
+    if (err.empty() && !server) {
+      seg->c2s_size = SHM_C2S_SIZE;
+      seg->s2c_size = SHM_S2C_SIZE;
+      new (base + SHM_C2S_OFFSET) ShmRingHeader();
+      new (base + SHM_S2C_OFFSET) ShmRingHeader();
+      seg->version = SHM_VERSION;
+      seg->magic = SHM_MAGIC;
+    }
+    if (err.empty() && server &&
+        (seg->magic != SHM_MAGIC || seg->version != SHM_VERSION ||
+         !is_pow2(seg->c2s_size) || !is_pow2(seg->s2c_size) ||
+         SHM_HEADER_SIZE + seg->c2s_size + seg->s2c_size != len))
+      err = "The shared segment has an unknown layout";
+    if (!err.empty()) {
+      Release();
+      EUDAQ_THROW_NOLOG("TransportSHM:: " + err);
+    }
+    ShmRing c2s = {reinterpret_cast<ShmRingHeader *>(base + SHM_C2S_OFFSET),
+                   base + SHM_HEADER_SIZE, seg->c2s_size,
+                   m_efd[C2S_DATA], m_efd[C2S_SPACE]};
+    ShmRing s2c = {reinterpret_cast<ShmRingHeader *>(base + SHM_S2C_OFFSET),
+                   base + SHM_HEADER_SIZE + seg->c2s_size, seg->s2c_size,
+                   m_efd[S2C_DATA], m_efd[S2C_SPACE]};
+    m_in = server ? c2s : s2c;
+    m_out = server ? s2c : c2s;
+  }
+
+  ConnectionInfoSHM::~ConnectionInfoSHM() { Release(); }
+
+  void ConnectionInfoSHM::Release() {
+    if (m_base)
+      munmap(m_base, m_base_len);
+    m_base = nullptr;
+    close_fds(m_efd, SHM_EFD_N);
+    std::fill(m_efd, m_efd + SHM_EFD_N, -1);
+    if (m_sock >= 0)
+      close(m_sock);
+    m_sock = -1;
+  }
+
+  bool ConnectionInfoSHM::Matches(const ConnectionInfo &other) const {
+    const ConnectionInfoSHM *ptr =
+        dynamic_cast<const ConnectionInfoSHM *>(&other);
+    if (ptr && (ptr->m_sock == m_sock))
+      return true;
+    return false;
+  }
+
+  void ConnectionInfoSHM::Print(std::ostream &os, size_t offset) const {
+    os << std::string(offset, ' ') << "<ConnectionSHM>\n";
+    os << std::string(offset + 2, ' ') << "<FD>" << m_remote <<"</FD>\n";
+    ConnectionInfo::Print(os, offset+2);
+    os << std::string(offset, ' ') << "</ConnectionSHM>\n";
+  }
+
+  void ConnectionInfoSHM::Publish(uint64_t head) {
+    // pairs with Arm(): either the reader sees the data or we see it waiting
+    m_out.hdr->head.store(head);
+    if (m_out.hdr->rd_waiting.load())
+      eventfd_write(m_out.data_efd, 1);
+  }
+
+  void ConnectionInfoSHM::WaitSpace(uint64_t head) {
+    m_out.hdr->wr_waiting.store(1);
+    while (head - m_out.hdr->tail.load() == m_out.size) {
+      pollfd fds[2];
+      fds[0].fd = m_out.space_efd;
+      fds[0].events = POLLIN;
+      fds[1].fd = m_sock;
+      fds[1].events = POLLIN | POLLRDHUP;
+      int result = poll(fds, 2, -1);
+      if (result < 0 && errno != EINTR) {
+        m_out.hdr->wr_waiting.store(0);
+        EUDAQ_THROW_NOLOG(LastErrorString("TransportSHM:: Error in poll()"));
+      }
+      // nothing is ever sent on the socket, it only becomes readable on close
+      if (result > 0 && fds[1].revents) {
+        m_out.hdr->wr_waiting.store(0);
+        EUDAQ_THROW_NOLOG("TransportSHM:: Connection reset by peer");
+      }
+      eventfd_t v;
+      eventfd_read(m_out.space_efd, &v);
+    }
+    m_out.hdr->wr_waiting.store(0);
+  }
+
+  void ConnectionInfoSHM::Put(uint64_t &head, const unsigned char *data,
+                              size_t len) {
+    unsigned char prefix[4];
+    size_t n = len;
+    for (int i = 0; i < 4; ++i) {
+      prefix[i] = static_cast<unsigned char>(n & 0xff);
+      n >>= 8;
+    }
+    const unsigned char *parts[2] = {prefix, data};
+    size_t sizes[2] = {4, len};
+    for (int p = 0; p < 2; p++) {
+      const unsigned char *src = parts[p];
+      size_t left = sizes[p];
+      while (left) {
+        uint64_t room =
+            m_out.size - (head - m_out.hdr->tail.load(std::memory_order_acquire));
+        if (!room) {
+          // packets larger than the ring are streamed through it
+          Publish(head);
+          WaitSpace(head);
+          continue;
+        }
+        size_t k = std::min<uint64_t>(left, room);
+        ring_copy_in(m_out, head, src, k);
+        head += k;
+        src += k;
+        left -= k;
+      }
+    }
+    CountSent(len + 4);
+  }
+
+  void ConnectionInfoSHM::Send(const unsigned char *data, size_t len) {
+    uint64_t head = m_out.hdr->head.load(std::memory_order_relaxed);
+    Put(head, data, len);
+    Publish(head);
+  }
+
+  void ConnectionInfoSHM::Send(const std::vector<PacketRef> &packets) {
+    uint64_t head = m_out.hdr->head.load(std::memory_order_relaxed);
+    for (auto &packet : packets) {
+      Put(head, packet.data, packet.size);
+    }
+    Publish(head);
+  }
+
+  bool ConnectionInfoSHM::NextPacket(std::string &packet) {
+    ShmRingHeader *hdr = m_in.hdr;
+    uint64_t tail = hdr->tail.load(std::memory_order_relaxed);
+    uint64_t head = hdr->head.load(std::memory_order_acquire);
+    // the peer writes the head, it must not be trusted
+    if (head - tail > m_in.size)
+      EUDAQ_THROW_NOLOG("TransportSHM:: The peer has corrupted the ring, head "
+                        + to_string(head) + " tail " + to_string(tail));
+    if (!m_have_len) {
+      if (head - tail < 4)
+        return false;
+      unsigned char prefix[4];
+      ring_copy_out(m_in, tail, prefix, 4);
+      size_t len = 0;
+      for (int i = 0; i < 4; ++i) {
+        len |= size_t(prefix[i]) << (8 * i);
+      }
+      tail += 4;
+      m_packet.resize(len);
+      m_got = 0;
+      m_have_len = true;
+    }
+    size_t k = std::min<uint64_t>(m_packet.size() - m_got, head - tail);
+    if (k)
+      ring_copy_out(m_in, tail, reinterpret_cast<unsigned char *>(&m_packet[m_got]), k);
+    m_got += k;
+    tail += k;
+    hdr->tail.store(tail);
+    if (hdr->wr_waiting.load())
+      eventfd_write(m_in.space_efd, 1);
+    if (m_got < m_packet.size())
+      return false;
+    packet = std::move(m_packet);
+    m_packet = std::string();
+    m_have_len = false;
+    CountReceived(packet.size() + 4);
+    return true;
+  }
+
+  bool ConnectionInfoSHM::Arm() {
+    ShmRingHeader *hdr = m_in.hdr;
+    hdr->rd_waiting.store(1);
+    uint64_t avail = hdr->head.load() - hdr->tail.load(std::memory_order_relaxed);
+    return avail < (m_have_len ? 1 : 4);
+  }
+
+  void ConnectionInfoSHM::Disarm() {
+    m_in.hdr->rd_waiting.store(0);
+    eventfd_t v;
+    eventfd_read(m_in.data_efd, &v);
+  }
+
+  SHMServer::SHMServer(const std::string &param)
+      : m_name(trim(param)),
+        m_srvsock(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)),
+        m_epfd(epoll_create1(EPOLL_CLOEXEC)) {
+    if (m_srvsock < 0 || m_epfd < 0) {
+      std::string err = LastErrorString("SHMServer:: Failed to create socket");
+      if (m_srvsock >= 0)
+        close(m_srvsock);
+      if (m_epfd >= 0)
+        close(m_epfd);
+      EUDAQ_THROW_NOLOG(err);
+    }
+    if (m_name.empty() || m_name == "0") {
+      static std::atomic<uint32_t> n(0);
+      m_name = "eudaq-" + to_string(getpid()) + "-" + to_string(n++);
+      EUDAQ_INFO("SHMServer:: Listening on shm://" + m_name);
+    }
+    sockaddr_un addr;
+    if (m_name.size() > MAX_NAME_SIZE ||
+        bind(m_srvsock, (sockaddr *)&addr, make_address(m_name, addr))) {
+      std::string err = LastErrorString("SHMServer:: Failed to bind socket: " + param);
+      close(m_srvsock);
+      close(m_epfd);
+      EUDAQ_THROW_NOLOG(err);
+    }
+    if (listen(m_srvsock, MAXPENDING)) {
+      std::string err = LastErrorString("Failed to listen on socket: " + param);
+      close(m_srvsock);
+      close(m_epfd);
+      EUDAQ_THROW_NOLOG(err);
+    }
+    epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u64 = uint64_t(m_srvsock) << 1;
+    if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_srvsock, &ev)) {
+      std::string err = LastErrorString("SHMServer:: Failed to add socket to epoll");
+      close(m_srvsock);
+      close(m_epfd);
+      EUDAQ_THROW_NOLOG(err);
+    }
+  }
+
+  SHMServer::~SHMServer() {
+    m_conn.clear();
+    for (auto &p : m_pending)
+      close(p.first);
+    close(m_srvsock);
+    close(m_epfd);
+  }
+
+  std::vector<ConnectionSPC> SHMServer::GetConnections () const{
+    std::vector<ConnectionSPC> conns;
+    for(auto &conn: m_conn){
+      conns.push_back(conn.second);
+    }
+    return conns;
+  }
+
+  void SHMServer::Close(const ConnectionInfo &id) {
+    for(auto it = m_conn.begin(); it != m_conn.end();){
+      if(id.Matches(*(it->second))){
+        epoll_ctl(m_epfd, EPOLL_CTL_DEL, it->second->GetEventFd(), nullptr);
+        epoll_ctl(m_epfd, EPOLL_CTL_DEL, it->first, nullptr);
+        it = m_conn.erase(it);
+      }
+      else
+        ++it;
+    }
+  }
+
+  void SHMServer::SendPacket(const unsigned char *data, size_t len,
+                             const ConnectionInfo &id, bool duringconnect) {
+    for(auto &conn: m_conn){
+      if(id.Matches(*conn.second)){
+        if(conn.second->GetState() > 0 || duringconnect) {
+          conn.second->Send(data, len);
+        }
+      }
+    }
+  }
+
+  void SHMServer::SendPackets(const std::vector<PacketRef> &packets,
+                              const ConnectionInfo &id) {
+    for(auto &conn: m_conn){
+      if(id.Matches(*conn.second) && conn.second->GetState() > 0){
+        conn.second->Send(packets);
+      }
+    }
+  }
+
+  void SHMServer::AcceptConnections() {
+    for (;;) {
+      int peersock = accept4(m_srvsock, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (peersock < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          return;
+        if (errno == EINTR || errno == ECONNABORTED)
+          continue;
+        EUDAQ_THROW_NOLOG(LastErrorString("Error in accept()"));
+      }
+      // the segment is taken over once the socket is readable, the other
+      // connections are not held up by a slow peer
+      epoll_event ev;
+      memset(&ev, 0, sizeof ev);
+      ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+      ev.data.u64 = uint64_t(peersock) << 1;
+      if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, peersock, &ev)) {
+        std::string err = LastErrorString("SHMServer:: Failed to add connection to epoll");
+        close(peersock);
+        EUDAQ_THROW_NOLOG(err);
+      }
+      m_pending[peersock] = std::chrono::steady_clock::now();
+      Handshake(peersock);
+    }
+  }
+
+  void SHMServer::Handshake(int peersock) {
+    int fds[SHM_EFD_N + 1];
+    int got = recv_fds(peersock, fds, SHM_EFD_N + 1);
+    if (!got)
+      return;
+    m_pending.erase(peersock);
+    if (got < 0) {
+      EUDAQ_WARN("SHMServer:: Connection without a shared segment is refused");
+      close(peersock);
+      return;
+    }
+    ucred cred;
+    socklen_t cred_len = sizeof cred;
+    std::string remote = "shm://" + m_name;
+    if (!getsockopt(peersock, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len))
+      remote += ":" + to_string(cred.pid);
+    std::shared_ptr<ConnectionInfoSHM> conn_new;
+    try {
+      conn_new = std::make_shared<ConnectionInfoSHM>(peersock, fds[0], fds + 1,
+                                                     true, remote);
+    } catch (const Exception &e) {
+      EUDAQ_WARN("SHMServer:: Connection from " + remote + " is refused, " +
+                 e.what());
+      return;
+    }
+    epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u64 = (uint64_t(peersock) << 1) | 1;
+    if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, conn_new->GetEventFd(), &ev)) {
+      std::string err = LastErrorString("SHMServer:: Failed to add connection to epoll");
+      epoll_ctl(m_epfd, EPOLL_CTL_DEL, peersock, nullptr);
+      EUDAQ_THROW_NOLOG(err);
+    }
+    m_conn[peersock] = conn_new;
+    m_events.push(TransportEvent(TransportEvent::CONNECT, conn_new));
+    // its hangup may have been reported together with the segment
+    pollfd pfd;
+    pfd.fd = peersock;
+    pfd.events = POLLRDHUP;
+    if (poll(&pfd, 1, 0) > 0 && pfd.revents)
+      m_closing.push_back(peersock);
+  }
+
+  void SHMServer::ExpireHandshakes() {
+    auto tp = std::chrono::steady_clock::now();
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+      if (tp - it->second < SHM_HANDSHAKE_TIMEOUT) {
+        ++it;
+        continue;
+      }
+      EUDAQ_WARN("SHMServer:: Connection without a shared segment is refused");
+      close(it->first);
+      it = m_pending.erase(it);
+    }
+  }
+
+  void SHMServer::Drop(int fd) {
+    auto it = m_conn.find(fd);
+    if (it == m_conn.end())
+      return;
+    auto conn = it->second;
+    m_events.push(TransportEvent(TransportEvent::DISCONNECT, conn));
+    Close(*conn);
+  }
+
+  bool SHMServer::ReadConnections() {
+    bool done = false;
+    std::string packet;
+    std::vector<int> corrupted;
+    for (auto &conn : m_conn) {
+      // one ring worth per call, a busy producer does not starve the others
+      size_t bytes = 0;
+      try {
+        while (bytes < SHM_C2S_SIZE && conn.second->NextPacket(packet)) {
+          bytes += packet.size() + 4;
+          m_events.push(TransportEvent(TransportEvent::RECEIVE, conn.second,
+                                       std::move(packet)));
+          done = true;
+        }
+      } catch (const Exception &e) {
+        EUDAQ_WARN("SHMServer:: Connection from " + conn.second->GetRemote() +
+                   " is dropped, " + e.what());
+        corrupted.push_back(conn.first);
+      }
+    }
+    for (int fd : corrupted) {
+      Drop(fd);
+      done = true;
+    }
+    // the peer wrote everything before closing its socket
+    for (int fd : m_closing) {
+      auto it = m_conn.find(fd);
+      if (it == m_conn.end())
+        continue;
+      auto conn = it->second;
+      try {
+        while (conn->NextPacket(packet)) {
+          m_events.push(TransportEvent(TransportEvent::RECEIVE, conn,
+                                       std::move(packet)));
+        }
+      } catch (const Exception &e) {
+        EUDAQ_WARN("SHMServer:: Connection from " + conn->GetRemote() +
+                   " is dropped, " + e.what());
+      }
+      Drop(fd);
+      done = true;
+    }
+    m_closing.clear();
+    return done;
+  }
+
+  void SHMServer::ProcessEvents(int timeout) {
+    Time t_start = Time::Current();
+    Time t_remain = Time(0, timeout);
+    epoll_event events[MAX_EPOLL_EVENTS];
+    bool done = ReadConnections();
+    while (!done && t_remain > Time(0)) {
+      bool wait = true;
+      for (auto &conn : m_conn) {
+        wait = conn.second->Arm() && wait;
+      }
+      int ms = wait ? static_cast<int>(t_remain.Seconds() * 1000 + 0.999) : 0;
+      // wakes up to expire the peers which never hand over their segment
+      if (!m_pending.empty())
+        ms = std::min(ms, 100);
+      int result = epoll_wait(m_epfd, events, MAX_EPOLL_EVENTS, ms);
+      for (auto &conn : m_conn) {
+        conn.second->Disarm();
+      }
+      if (result < 0 && errno != EINTR) {
+        EUDAQ_THROW_NOLOG(LastErrorString("Error in epoll_wait()"));
+      }
+      for (int i = 0; i < result; i++) {
+        int fd = static_cast<int>(events[i].data.u64 >> 1);
+        if (fd == m_srvsock)
+          AcceptConnections();
+        else if (m_pending.count(fd))
+          Handshake(fd);
+        else if (!(events[i].data.u64 & 1))
+          m_closing.push_back(fd);
+      }
+      ExpireHandshakes();
+      done = ReadConnections() || !m_events.empty();
+      t_remain = Time(0, timeout) + t_start - Time::Current();
+    }
+  }
+
+  std::string SHMServer::ConnectionString() const {
+    return name + "://" + m_name;
+  }
+
+  SHMClient::SHMClient(const std::string &param) {
+    std::string server = trim(param);
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+      EUDAQ_THROW_NOLOG(LastErrorString("Failed to create socket"));
+    sockaddr_un addr;
+    if (server.size() > MAX_NAME_SIZE ||
+        connect(sock, (sockaddr *)&addr, make_address(server, addr))) {
+      std::string err = LastErrorString(
+          "Are you sure the server is running? - Error connecting to shm://" + server);
+      close(sock);
+      EUDAQ_THROW_NOLOG(err);
+    }
+    int fds[SHM_EFD_N + 2];
+    fds[0] = memfd_create("eudaq-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    for (int i = 0; i < SHM_EFD_N; i++)
+      fds[i + 1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    // the connection closes its segment descriptor once mapped
+    fds[SHM_EFD_N + 1] = fds[0] < 0 ? -1 : fcntl(fds[0], F_DUPFD_CLOEXEC, 0);
+    if (std::find(fds, fds + SHM_EFD_N + 2, -1) != fds + SHM_EFD_N + 2) {
+      std::string err = LastErrorString("TransportSHM:: Failed to create the shared segment");
+      close_fds(fds, SHM_EFD_N + 2);
+      close(sock);
+      EUDAQ_THROW_NOLOG(err);
+    }
+    int seg = fds[SHM_EFD_N + 1];
+    try {
+      m_buf = std::make_shared<ConnectionInfoSHM>(sock, fds[0], fds + 1, false,
+                                                  "shm://" + server);
+    } catch (...) {
+      close(seg);
+      throw;
+    }
+    fds[0] = seg;
+    bool sent = send_fds(sock, fds, SHM_EFD_N + 1);
+    std::string err = LastErrorString(
+        "TransportSHM:: Failed to hand over the shared segment to shm://" + server);
+    close(seg);
+    if (!sent)
+      EUDAQ_THROW_NOLOG(err);
+  }
+
+  SHMClient::~SHMClient() {}
+
+  void SHMClient::SendPacket(const unsigned char *data, size_t len,
+                             const ConnectionInfo &id, bool) {
+    if(id.Matches(*m_buf)) {
+      m_buf->Send(data, len);
+    }
+  }
+
+  void SHMClient::SendPackets(const std::vector<PacketRef> &packets,
+                              const ConnectionInfo &id) {
+    if(id.Matches(*m_buf)) {
+      m_buf->Send(packets);
+    }
+  }
+
+  void SHMClient::ProcessEvents(int timeout) {
+    Time t_start = Time::Current();
+    Time t_remain = Time(0, timeout);
+    bool done = false;
+    for (;;) {
+      std::string packet;
+      while (m_buf->NextPacket(packet)) {
+        m_events.push(TransportEvent(TransportEvent::RECEIVE, m_buf,
+                                     std::move(packet)));
+        done = true;
+      }
+      if (done || !(t_remain > Time(0)))
+        break;
+      if (m_buf->Arm()) {
+        pollfd fds[2];
+        fds[0].fd = m_buf->GetEventFd();
+        fds[0].events = POLLIN;
+        fds[1].fd = m_buf->GetFd();
+        fds[1].events = POLLIN | POLLRDHUP;
+        int ms = static_cast<int>(t_remain.Seconds() * 1000 + 0.999);
+        int result = poll(fds, 2, ms);
+        m_buf->Disarm();
+        if (result < 0 && errno != EINTR)
+          EUDAQ_THROW_NOLOG(LastErrorString("TransportSHM:: Error in poll()"));
+        if (result > 0 && fds[1].revents) {
+          while (m_buf->NextPacket(packet)) {
+            m_events.push(TransportEvent(TransportEvent::RECEIVE, m_buf,
+                                         std::move(packet)));
+            done = true;
+          }
+          if (!done)
+            EUDAQ_THROW_NOLOG("TransportSHM:: Connection reset by peer");
+          break;
+        }
+      } else {
+        m_buf->Disarm();
+      }
+      t_remain = Time(0, timeout) + t_start - Time::Current();
+    }
+  }
+}
+
+#endif
@@ -52,6 +52,16 @@ at some places we have constructions like:
 #pragma comment(lib, "Ws2_32.lib")
 #else
 #include "TransportTCP_POSIX.hh"
+#include <netinet/tcp.h>
+#include <sys/uio.h>
+#include <climits>
+#endif
+
+#if EUDAQ_PLATFORM_IS(LINUX)
+#include <sys/epoll.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <atomic>
 #endif
 
 // print debug messages that are optimized out if DEBUG_TRANSPORT is not set:
@@ -70,12 +80,28 @@ at some places we have constructions like:
 namespace eudaq {
   const std::string TCPServer::name = "tcp";
   const std::string TCPClient::name = "tcp";
+#if EUDAQ_PLATFORM_IS(LINUX)
+  const std::string EpollServer::name = "epoll";
+  const std::string IPCServer::name = "ipc";
+  const std::string IPCClient::name = "ipc";
+#endif
 
   namespace{
     auto d0=Factory<TransportServer>::Register<TCPServer, const std::string&>
       (str2hash(TCPServer::name));
     auto d1=Factory<TransportClient>::Register<TCPClient, const std::string&>
       (str2hash(TCPClient::name));
+#if EUDAQ_PLATFORM_IS(LINUX)
+    auto d2=Factory<TransportServer>::Register<EpollServer, const std::string&>
+      (str2hash(EpollServer::name));
+    // the epoll server talks plain TCP, so a TCPClient can connect to it
+    auto d3=Factory<TransportClient>::Register<TCPClient, const std::string&>
+      (str2hash(EpollServer::name));
+    auto d4=Factory<TransportServer>::Register<IPCServer, const std::string&>
+      (str2hash(IPCServer::name));
+    auto d5=Factory<TransportClient>::Register<IPCClient, const std::string&>
+      (str2hash(IPCClient::name));
+#endif
   }
   
   namespace {
@@ -99,6 +125,7 @@ namespace eudaq {
     }
 #endif
 
+#if EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW)
     static void do_send_data(SOCKET sock, const unsigned char *data,
                              size_t len) {
       size_t sent = 0;
@@ -147,6 +174,159 @@ namespace eudaq {
       }
     }
 
+    // Packets are gathered into a single send buffer up to this size,
+    // anything bigger is sent on its own to avoid an extra copy.
+    static const size_t MAX_COALESCE_SIZE = 262144;
+
+    static void do_send_packets(SOCKET sock,
+                                const std::vector<PacketRef> &packets) {
+      std::vector<unsigned char> buffer;
+      for (auto &packet : packets) {
+        size_t length = packet.size;
+        if (length + 4 > MAX_COALESCE_SIZE) {
+          if (!buffer.empty()) {
+            do_send_data(sock, &buffer[0], buffer.size());
+            buffer.clear();
+          }
+          do_send_packet(sock, packet.data, length);
+          continue;
+        }
+        if (buffer.size() + length + 4 > MAX_COALESCE_SIZE) {
+          do_send_data(sock, &buffer[0], buffer.size());
+          buffer.clear();
+        }
+        size_t len = length;
+        for (int i = 0; i < 4; ++i) {
+          buffer.push_back(static_cast<unsigned char>(len & 0xff));
+          len >>= 8;
+        }
+        if (length)
+          buffer.insert(buffer.end(), packet.data, packet.data + length);
+      }
+      if (!buffer.empty())
+        do_send_data(sock, &buffer[0], buffer.size());
+    }
+#else
+    // The length header and the payload leave in a single system call,
+    // a batch of packets is gathered without being copied.
+    static void do_send_iov(SOCKET sock, iovec *iov, size_t n) {
+      for (;;) {
+        while (n && !iov->iov_len) {
+          ++iov;
+          --n;
+        }
+        if (!n)
+          return;
+        msghdr msg;
+        std::memset(&msg, 0, sizeof msg);
+        msg.msg_iov = iov;
+        msg.msg_iovlen = std::min<size_t>(n, IOV_MAX);
+        ssize_t result = sendmsg(sock, &msg, FLAGS);
+        if (result > 0) {
+          size_t sent = result;
+          while (sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            ++iov;
+            --n;
+            if (!n)
+              return;
+          }
+          iov->iov_base = static_cast<char *>(iov->iov_base) + sent;
+          iov->iov_len -= sent;
+        }
+        else if (result < 0 &&
+		 (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable ||
+		  LastSockError() == EUDAQ_ERROR_Interrupted_function_call)){
+          // continue
+        }
+        else if (result == 0) {
+          EUDAQ_THROW_NOLOG("TransportTCP:: Connection reset by peer");
+        }
+        else {
+          EUDAQ_THROW_NOLOG(LastSockErrorString("TransportTCP:: Error sending data"));
+        }
+      }
+    }
+
+    static void put_length(unsigned char *buffer, size_t len) {
+      for (int i = 0; i < 4; ++i) {
+        buffer[i] = static_cast<unsigned char>(len & 0xff);
+        len >>= 8;
+      }
+    }
+
+    static void do_send_packet(SOCKET sock, const unsigned char *data,
+                               size_t length){
+      unsigned char buffer[4];
+      put_length(buffer, length);
+      iovec iov[2];
+      iov[0].iov_base = buffer;
+      iov[0].iov_len = 4;
+      iov[1].iov_base = const_cast<unsigned char *>(data);
+      iov[1].iov_len = length;
+      do_send_iov(sock, iov, 2);
+    }
+
+    static void do_send_packets(SOCKET sock,
+                                const std::vector<PacketRef> &packets) {
+      std::vector<unsigned char> headers(packets.size() * 4);
+      std::vector<iovec> iov(packets.size() * 2);
+      for (size_t i = 0; i < packets.size(); i++) {
+        size_t length = packets[i].size;
+        put_length(&headers[i * 4], length);
+        iov[i * 2].iov_base = &headers[i * 4];
+        iov[i * 2].iov_len = 4;
+        iov[i * 2 + 1].iov_base = const_cast<unsigned char *>(packets[i].data);
+        iov[i * 2 + 1].iov_len = length;
+      }
+      if (!iov.empty())
+        do_send_iov(sock, &iov[0], iov.size());
+    }
+#endif
+
+    static uint64_t packets_bytes(const std::vector<PacketRef> &packets) {
+      uint64_t n = 0;
+      for (auto &packet : packets)
+        n += packet.size + 4;
+      return n;
+    }
+
+    static void apply_socket_options(SOCKET sock, const SocketOptions &opt,
+                                     bool tcp = true) {
+      if (opt.sndbuf > 0)
+        setsockopt(sock, SOL_SOCKET, SO_SNDBUF,
+                   reinterpret_cast<const char *>(&opt.sndbuf), sizeof opt.sndbuf);
+      if (opt.rcvbuf > 0)
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
+                   reinterpret_cast<const char *>(&opt.rcvbuf), sizeof opt.rcvbuf);
+      if (tcp) {
+        int nodelay = opt.nodelay ? 1 : 0;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY,
+                   reinterpret_cast<const char *>(&nodelay), sizeof nodelay);
+      }
+    }
+
+    static void set_cork(SOCKET sock, bool on) {
+#ifdef TCP_CORK
+      int cork = on ? 1 : 0;
+      setsockopt(sock, IPPROTO_TCP, TCP_CORK, &cork, sizeof cork);
+#else
+      (void)sock;
+      (void)on;
+#endif
+    }
+
+    // corked, the batch leaves in full segments and is flushed at its end
+    static void do_send_batch(SOCKET sock,
+                              const std::vector<PacketRef> &packets,
+                              bool cork) {
+      if (cork)
+        set_cork(sock, true);
+      do_send_packets(sock, packets);
+      if (cork)
+        set_cork(sock, false);
+    }
+
   } // anonymous namespace
 
   bool ConnectionInfoTCP::Matches(const ConnectionInfo &other) const {
@@ -248,6 +428,15 @@ namespace eudaq {
   }
 
   
+  void TCPServer::SetSocketOptions(const SocketOptions &opt) {
+    TransportServer::SetSocketOptions(opt);
+    apply_socket_options(m_srvsock, opt);
+    for(auto &conn: m_conn){
+      if(conn)
+        apply_socket_options(conn->GetFd(), opt);
+    }
+  }
+
   std::vector<ConnectionSPC> TCPServer::GetConnections () const{
     std::vector<ConnectionSPC> conns;
     for(auto &conn: m_conn){
@@ -274,11 +463,22 @@ namespace eudaq {
       if(conn && id.Matches(*conn)){
         if(conn->GetState() > 0 || duringconnect) {
           do_send_packet(conn->GetFd(), data, len);
+          conn->CountSent(len + 4);
         }
       }
     }
   }
 
+  void TCPServer::SendPackets(const std::vector<PacketRef> &packets,
+                              const ConnectionInfo &id) {
+    for(auto &conn: m_conn){
+      if(conn && id.Matches(*conn) && conn->GetState() > 0){
+        do_send_batch(conn->GetFd(), packets, m_sockopt.cork);
+        conn->CountSent(packets_bytes(packets));
+      }
+    }
+  }
+
   void TCPServer::ProcessEvents(int timeout) {
 #if DEBUG_NOTIMEOUT == 0
     Time t_start = Time::Current(); /*t_curr = t_start,*/
@@ -309,6 +509,7 @@ namespace eudaq {
             FD_SET(peersock, &m_fdset);
             m_maxfd = (m_maxfd < peersock) ? peersock : m_maxfd;
             setup_socket(peersock);
+            apply_socket_options(peersock, m_sockopt);
             std::string host = inet_ntoa(addr.sin_addr);
             host = "tcp://"+host+":" + to_string(ntohs(addr.sin_port));
             auto conn_new = std::make_shared<ConnectionInfoTCP>(peersock, host);
@@ -338,6 +539,7 @@ namespace eudaq {
             if (result > 0) {
               buffer[result] = 0;
 	      auto m = GetInfo(j);
+              m->CountReceived(result);
               m->append(result, buffer);
               while (m->havepacket()) {
                 done = true;
@@ -386,15 +588,20 @@ namespace eudaq {
   }
 
   TCPClient::TCPClient(const std::string &param)
-      : m_server(param), m_port(44000),
-        m_sock(socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)),
+      : TCPClient(param, PF_INET) {}
+
+  TCPClient::TCPClient(const std::string &param, int family)
+      : m_server(param), m_port(44000), m_family(family),
+        m_sock(socket(family, SOCK_STREAM, family == PF_INET ? IPPROTO_TCP : 0)),
         m_buf(std::make_shared<ConnectionInfoTCP>(m_sock, param)) {
     if (m_sock == (SOCKET)-1)
       EUDAQ_THROW_NOLOG(LastSockErrorString(
           "Failed to create socket")); //$$ check if (SOCKET)-1 is correct
 
     size_t i = param.find(':');
-    if (i != std::string::npos) {
+    if (family != PF_INET) {
+      m_server = trim(param);
+    } else if (i != std::string::npos) {
       m_server = trim(std::string(param, 0, i));
       m_port = from_string(std::string(param, i + 1), 44000);
     }
@@ -405,6 +612,26 @@ namespace eudaq {
   }
 
   void TCPClient::OpenConnection() {
+#if EUDAQ_PLATFORM_IS(LINUX)
+    if (m_family == AF_UNIX) {
+      sockaddr_un addr;
+      std::memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      if (m_server.size() >= sizeof(addr.sun_path)) {
+        closesocket(m_sock);
+        EUDAQ_THROW_NOLOG("Socket path too long: " + m_server);
+      }
+      std::strcpy(addr.sun_path, m_server.c_str());
+      if (connect(m_sock, (sockaddr *)&addr, sizeof(addr))) {
+        EUDAQ_THROW_NOLOG(
+            LastSockErrorString("Are you sure the server is running? - Error " +
+                                to_string(LastSockError()) + " connecting to ipc://" +
+                                m_server));
+      }
+      setup_socket(m_sock); // set to non-blocking
+      return;
+    }
+#endif
     sockaddr_in addr;
     std::memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
@@ -432,9 +659,23 @@ namespace eudaq {
                              const ConnectionInfo &id, bool) {
     if(id.Matches(*m_buf)) {
       do_send_packet(m_buf->GetFd(), data, len);
+      m_buf->CountSent(len + 4);
     }
   }
 
+  void TCPClient::SendPackets(const std::vector<PacketRef> &packets,
+                              const ConnectionInfo &id) {
+    if(id.Matches(*m_buf)) {
+      do_send_batch(m_buf->GetFd(), packets, m_sockopt.cork);
+      m_buf->CountSent(packets_bytes(packets));
+    }
+  }
+
+  void TCPClient::SetSocketOptions(const SocketOptions &opt) {
+    TransportClient::SetSocketOptions(opt);
+    apply_socket_options(m_sock, opt, m_family == PF_INET);
+  }
+
   void TCPClient::ProcessEvents(int timeout) {
 #if DEBUG_NOTIMEOUT == 0
     Time t_start = Time::Current(); /*t_curr = t_start,*/
@@ -472,6 +713,7 @@ namespace eudaq {
           EUDAQ_THROW_NOLOG(LastSockErrorString(
               "SocketClient Error (" + to_string(LastSockError()) + ")"));
         } else if (result > 0) {
+          m_buf->CountReceived(result);
           m_buf->append(result, buffer);
           while (m_buf->havepacket()) {
             m_events.push(TransportEvent(TransportEvent::RECEIVE, m_buf,
@@ -494,4 +736,350 @@ namespace eudaq {
   }
 
   TCPClient::~TCPClient() { closesocket(m_sock); }
+
+#if EUDAQ_PLATFORM_IS(LINUX)
+  IPCClient::IPCClient(const std::string &param) : TCPClient(param, AF_UNIX) {}
+#endif
+
+#if EUDAQ_PLATFORM_IS(LINUX)
+  namespace {
+    static const int MAX_EPOLL_EVENTS = 64;
+    // minimum free space offered to recv()
+    static const size_t EPOLL_RECV_SIZE = 262144;
+    // packets at least this big are received directly into their own string
+    static const size_t EPOLL_LARGE_PACKET = 65536;
+  }
+
+  bool ConnectionInfoEpoll::Matches(const ConnectionInfo &other) const {
+    const ConnectionInfoEpoll *ptr =
+        dynamic_cast<const ConnectionInfoEpoll *>(&other);
+    if (ptr && (ptr->m_fd == m_fd))
+      return true;
+    return false;
+  }
+
+  void ConnectionInfoEpoll::Print(std::ostream &os, size_t offset) const {
+    os << std::string(offset, ' ') << "<ConnectionEpoll>\n";
+    os << std::string(offset + 2, ' ') << "<FD>" << m_host <<"</FD>\n";
+    ConnectionInfo::Print(os, offset+2);
+    os << std::string(offset, ' ') << "</ConnectionEpoll>\n";
+  }
+
+  char *ConnectionInfoEpoll::RecvBuffer(size_t &len) {
+    if (m_large) {
+      len = m_large_packet.size() - m_large_n;
+      return &m_large_packet[m_large_n];
+    }
+    if (m_buf.size() - m_wr < EPOLL_RECV_SIZE) {
+      // move the incomplete packet to the front, then grow if still needed
+      if (m_rd) {
+        std::memmove(m_buf.data(), m_buf.data() + m_rd, m_wr - m_rd);
+        m_wr -= m_rd;
+        m_rd = 0;
+      }
+      if (m_buf.size() - m_wr < EPOLL_RECV_SIZE)
+        m_buf.resize(m_wr + EPOLL_RECV_SIZE);
+    }
+    len = m_buf.size() - m_wr;
+    return &m_buf[m_wr];
+  }
+
+  void ConnectionInfoEpoll::Commit(size_t len) {
+    if (m_large)
+      m_large_n += len;
+    else
+      m_wr += len;
+  }
+
+  bool ConnectionInfoEpoll::NextPacket(std::string &packet) {
+    if (m_large) {
+      if (m_large_n < m_large_packet.size())
+        return false;
+      packet = std::move(m_large_packet);
+      m_large_packet = std::string();
+      m_large = false;
+      return true;
+    }
+    size_t avail = m_wr - m_rd;
+    if (avail < 4)
+      return false;
+    size_t len = 0;
+    for (int i = 0; i < 4; ++i) {
+      len |= to_int(m_buf[m_rd + i]) << (8 * i);
+    }
+    if (avail >= len + 4) {
+      packet.assign(&m_buf[m_rd + 4], len);
+      m_rd += len + 4;
+      if (m_rd == m_wr)
+        m_rd = m_wr = 0;
+      return true;
+    }
+    if (len >= EPOLL_LARGE_PACKET) {
+      m_large_packet.resize(len);
+      m_large_n = avail - 4;
+      std::memcpy(&m_large_packet[0], &m_buf[m_rd + 4], m_large_n);
+      m_rd = m_wr = 0;
+      m_large = true;
+    }
+    return false;
+  }
+
+  EpollServer::EpollServer(const std::string &param)
+      : EpollServer(param, PF_INET) {}
+
+  EpollServer::EpollServer(const std::string &param, int family)
+      : m_port(0),
+        m_srvsock(socket(family, SOCK_STREAM, family == PF_INET ? IPPROTO_TCP : 0)),
+        m_epfd(epoll_create1(0)) {
+    if (m_srvsock == (SOCKET)-1)
+      EUDAQ_THROW_NOLOG(LastSockErrorString("EpollServer:: Failed to create socket"));
+    if (m_epfd < 0) {
+      closesocket(m_srvsock);
+      EUDAQ_THROW_NOLOG(LastSockErrorString("EpollServer:: Failed to create epoll instance"));
+    }
+    setup_signal();
+    setup_socket(m_srvsock);
+
+    if (family == AF_UNIX) {
+      m_path = trim(param);
+      if (m_path.empty() || m_path == "0") {
+        static std::atomic<uint32_t> n(0);
+        m_path = "/tmp/eudaq-" + to_string(getpid()) + "-" + to_string(n++) + ".sock";
+      }
+      sockaddr_un addr;
+      memset(&addr, 0, sizeof addr);
+      addr.sun_family = AF_UNIX;
+      if (m_path.size() >= sizeof(addr.sun_path)) {
+        closesocket(m_srvsock);
+        close(m_epfd);
+        EUDAQ_THROW_NOLOG("EpollServer:: Socket path too long: " + m_path);
+      }
+      std::strcpy(addr.sun_path, m_path.c_str());
+      // a socket left behind by a server which is gone is replaced
+      struct stat st;
+      if (!stat(m_path.c_str(), &st) && S_ISSOCK(st.st_mode)) {
+        SOCKET probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe != (SOCKET)-1) {
+          if (connect(probe, (sockaddr *)&addr, sizeof addr) &&
+              LastSockError() == ECONNREFUSED)
+            unlink(m_path.c_str());
+          closesocket(probe);
+        }
+      }
+      if (bind(m_srvsock, (sockaddr *)&addr, sizeof addr)) {
+        closesocket(m_srvsock);
+        close(m_epfd);
+        m_path.clear();
+        EUDAQ_THROW_NOLOG(LastSockErrorString("EpollServer:: Failed to bind socket: " + param));
+      }
+      if (trim(param) != m_path)
+        EUDAQ_INFO("EpollServer:: Listening on " + m_path);
+    } else {
+      m_port = from_string(param, 0);
+      sockaddr_in addr;
+      memset(&addr, 0, sizeof addr);
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_ANY);
+      addr.sin_port = htons(m_port);
+
+      if (bind(m_srvsock, (sockaddr *)&addr, sizeof addr)) {
+        closesocket(m_srvsock);
+        close(m_epfd);
+        EUDAQ_THROW_NOLOG(LastSockErrorString("EpollServer:: Failed to bind socket: " + param));
+      }
+      socklen_t addr_len = sizeof addr;
+      if(m_port == 0){
+        getsockname(m_srvsock, (sockaddr *)&addr, &addr_len);
+        m_port = ntohs(addr.sin_port);
+        EUDAQ_INFO("EpollServer:: Listening on port " + std::to_string(m_port));
+      }
+    }
+    if (listen(m_srvsock, MAXPENDING)){
+      closesocket(m_srvsock);
+      close(m_epfd);
+      if (!m_path.empty())
+        unlink(m_path.c_str());
+      EUDAQ_THROW_NOLOG(
+          LastSockErrorString("Failed to listen on socket: " + param));
+    }
+    epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = m_srvsock;
+    if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_srvsock, &ev)) {
+      closesocket(m_srvsock);
+      close(m_epfd);
+      if (!m_path.empty())
+        unlink(m_path.c_str());
+      EUDAQ_THROW_NOLOG(LastSockErrorString("EpollServer:: Failed to add socket to epoll"));
+    }
+  }
+
+  EpollServer::~EpollServer() {
+    for(auto &conn : m_conn){
+      closesocket(conn.first);
+    }
+    closesocket(m_srvsock);
+    close(m_epfd);
+    if (!m_path.empty())
+      unlink(m_path.c_str());
+  }
+
+  void EpollServer::SetSocketOptions(const SocketOptions &opt) {
+    TransportServer::SetSocketOptions(opt);
+    apply_socket_options(m_srvsock, opt, m_path.empty());
+    for(auto &conn: m_conn){
+      apply_socket_options(conn.first, opt, m_path.empty());
+    }
+  }
+
+  std::vector<ConnectionSPC> EpollServer::GetConnections () const{
+    std::vector<ConnectionSPC> conns;
+    for(auto &conn: m_conn){
+      conns.push_back(conn.second);
+    }
+    return conns;
+  }
+
+  void EpollServer::Close(const ConnectionInfo &id) {
+    for(auto it = m_conn.begin(); it != m_conn.end();){
+      if(id.Matches(*(it->second))){
+        epoll_ctl(m_epfd, EPOLL_CTL_DEL, it->first, nullptr);
+        closesocket(it->first);
+        it = m_conn.erase(it);
+      }
+      else
+        ++it;
+    }
+  }
+
+  void EpollServer::SendPacket(const unsigned char *data, size_t len,
+                               const ConnectionInfo &id, bool duringconnect) {
+    for(auto &conn: m_conn){
+      if(id.Matches(*conn.second)){
+        if(conn.second->GetState() > 0 || duringconnect) {
+          do_send_packet(conn.first, data, len);
+          conn.second->CountSent(len + 4);
+        }
+      }
+    }
+  }
+
+  void EpollServer::SendPackets(const std::vector<PacketRef> &packets,
+                                const ConnectionInfo &id) {
+    for(auto &conn: m_conn){
+      if(id.Matches(*conn.second) && conn.second->GetState() > 0){
+        do_send_batch(conn.first, packets, m_sockopt.cork);
+        conn.second->CountSent(packets_bytes(packets));
+      }
+    }
+  }
+
+  void EpollServer::AcceptConnections() {
+    for (;;) {
+      sockaddr_in addr;
+      memset(&addr, 0, sizeof addr);
+      socklen_t len = sizeof(addr);
+      SOCKET peersock = accept(m_srvsock, (sockaddr *)&addr, &len);
+      if (peersock == INVALID_SOCKET) {
+        if (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable)
+          return;
+        if (LastSockError() == EUDAQ_ERROR_Interrupted_function_call)
+          continue;
+        EUDAQ_THROW_NOLOG(LastSockErrorString("Error in accept()"));
+      }
+      setup_socket(peersock);
+      apply_socket_options(peersock, m_sockopt, m_path.empty());
+      epoll_event ev;
+      memset(&ev, 0, sizeof ev);
+      ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+      ev.data.fd = peersock;
+      if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, peersock, &ev)) {
+        closesocket(peersock);
+        EUDAQ_THROW_NOLOG(LastSockErrorString("EpollServer:: Failed to add connection to epoll"));
+      }
+      std::string host;
+      if (m_path.empty()) {
+        host = inet_ntoa(addr.sin_addr);
+        host = "tcp://"+host+":" + to_string(ntohs(addr.sin_port));
+      } else {
+        host = IPCServer::name + "://" + m_path;
+      }
+      auto conn_new = std::make_shared<ConnectionInfoEpoll>(peersock, host);
+      m_conn[peersock] = conn_new;
+      m_events.push(TransportEvent(TransportEvent::CONNECT, conn_new));
+    }
+  }
+
+  void EpollServer::ReadConnection(std::shared_ptr<ConnectionInfoEpoll> conn) {
+    // edge-triggered: read until the socket is drained
+    for (;;) {
+      size_t len = 0;
+      char *buf = conn->RecvBuffer(len);
+      ssize_t result = recv(conn->GetFd(), buf, len, 0);
+      if (result > 0) {
+        conn->CountReceived(result);
+        conn->Commit(result);
+        std::string packet;
+        while (conn->NextPacket(packet)) {
+          m_events.push(TransportEvent(TransportEvent::RECEIVE, conn,
+                                       std::move(packet)));
+        }
+      } else if (result == 0) {
+        debug_transport("Server #%d, Disconnected.\n", conn->GetFd());
+        m_events.push(TransportEvent(TransportEvent::DISCONNECT, conn));
+        Close(*conn);
+        return;
+      } else if (LastSockError() == EUDAQ_ERROR_Interrupted_function_call) {
+        continue;
+      } else if (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable) {
+        return;
+      } else {
+        debug_transport("Server #%d, WSAError:%d (%s) \n", conn->GetFd(),
+                        errno, strerror(errno));
+        m_events.push(TransportEvent(TransportEvent::DISCONNECT, conn));
+        Close(*conn);
+        return;
+      }
+    }
+  }
+
+  void EpollServer::ProcessEvents(int timeout) {
+    Time t_start = Time::Current();
+    Time t_remain = Time(0, timeout);
+    epoll_event events[MAX_EPOLL_EVENTS];
+    do {
+      int ms = static_cast<int>(t_remain.Seconds() * 1000 + 0.999);
+      int result = epoll_wait(m_epfd, events, MAX_EPOLL_EVENTS, ms);
+      if (result < 0 &&
+          LastSockError() != EUDAQ_ERROR_Interrupted_function_call) {
+        EUDAQ_THROW_NOLOG(LastSockErrorString("Error in epoll_wait()"));
+      }
+      for (int i = 0; i < result; i++) {
+        SOCKET fd = events[i].data.fd;
+        if (fd == m_srvsock) {
+          AcceptConnections();
+          continue;
+        }
+        auto it = m_conn.find(fd);
+        if (it != m_conn.end())
+          ReadConnection(it->second);
+      }
+      if (!m_events.empty())
+        break;
+      t_remain = Time(0, timeout) + t_start - Time::Current();
+    } while (t_remain > Time(0));
+  }
+
+  std::string EpollServer::ConnectionString() const{
+    return name + "://" + to_string(m_port);
+  }
+
+  IPCServer::IPCServer(const std::string &param)
+      : EpollServer(param, AF_UNIX) {}
+
+  std::string IPCServer::ConnectionString() const{
+    return name + "://" + m_path;
+  }
+#endif
 }
@@ -0,0 +1,318 @@
+#include "eudaq/TriggerEventBuilder.hh"
+#include "eudaq/Exception.hh"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace eudaq {
+
+  TriggerEventBuilder::TriggerEventBuilder()
+    :m_window(0), m_depth(0), m_timeout(0), m_policy(INCOMPLETE_PARTIAL),
+     m_open_n(0), m_occupied(0), m_next(0), m_force_until(0), m_max_trigger(-1),
+     m_flush(false), m_complete_n(0), m_incomplete_n(0), m_dropped_n(0){
+    SetWindow(1024);
+  }
+
+  TriggerEventBuilder::IncompletePolicy TriggerEventBuilder::Str2Policy(const std::string &policy){
+    if(policy == "partial")
+      return INCOMPLETE_PARTIAL;
+    else if(policy == "drop")
+      return INCOMPLETE_DROP;
+    else if(policy == "tag")
+      return INCOMPLETE_TAG;
+    EUDAQ_THROW("TriggerEventBuilder: unknown policy for incomplete events " + policy);
+  }
+
+  std::string TriggerEventBuilder::LagBinName(size_t bin){
+    if(bin < 2)
+      return std::to_string(bin);
+    std::string name = std::to_string(uint64_t(1) << (bin - 1)) + "-";
+    if(bin + 1 < LAG_BINS)
+      name += std::to_string((uint64_t(1) << bin) - 1);
+    return name;
+  }
+
+  std::string TriggerEventBuilder::FormatLag(const std::vector<uint64_t> &lag){
+    std::string str;
+    for(size_t i = 0; i < lag.size(); i++){
+      if(!lag[i])
+	continue;
+      if(!str.empty())
+	str += ",";
+      str += LagBinName(i) + ":" + std::to_string(lag[i]);
+    }
+    return str;
+  }
+
+  void TriggerEventBuilder::MergeStatus(std::map<std::string, StreamStatus> &status,
+					const std::vector<StreamStatus> &add){
+    for(auto &st: add){
+      auto it = status.find(st.name);
+      if(it == status.end()){
+	status[st.name] = st;
+	continue;
+      }
+      it->second.received_n += st.received_n;
+      it->second.late_n += st.late_n;
+      for(size_t i = 0; i < st.lag.size() && i < it->second.lag.size(); i++)
+	it->second.lag[i] += st.lag[i];
+    }
+  }
+
+  void TriggerEventBuilder::Configure(const Configuration &conf){
+    SetWindow(conf.Get("EUDAQ_TG_WINDOW", 1024));
+    SetReorderDepth(conf.Get("EUDAQ_TG_REORDER_DEPTH", 0));
+    SetTimeout(std::chrono::milliseconds(conf.Get("EUDAQ_TG_TIMEOUT_MS", 0)));
+    SetIncompletePolicy(Str2Policy(conf.Get("EUDAQ_TG_INCOMPLETE", "partial")));
+  }
+
+  void TriggerEventBuilder::SetWindow(uint32_t window){
+    if(m_occupied)
+      EUDAQ_THROW("TriggerEventBuilder: the window is changed while events are pending");
+    m_window = std::max(window, uint32_t(1));
+    m_ring.assign(m_window, Slot());
+    for(auto &slot: m_ring){
+      slot.used = false;
+      slot.evs.resize(m_streams.size());
+    }
+  }
+
+  void TriggerEventBuilder::SetReorderDepth(uint32_t depth){
+    m_depth = depth;
+  }
+
+  void TriggerEventBuilder::SetTimeout(std::chrono::milliseconds timeout){
+    m_timeout = timeout;
+  }
+
+  void TriggerEventBuilder::SetIncompletePolicy(IncompletePolicy policy){
+    m_policy = policy;
+  }
+
+  uint32_t TriggerEventBuilder::AddStream(const std::string &name){
+    uint32_t id = m_streams.size();
+    for(uint32_t i = 0; i < m_streams.size(); i++){
+      if(m_streams[i].name != name)
+	continue;
+      if(!m_streams[i].closed)
+	EUDAQ_THROW("TriggerEventBuilder: multiple streams are sharing the name " + name);
+      id = i;
+    }
+    if(id == m_streams.size()){
+      m_streams.push_back(Stream());
+      for(auto &slot: m_ring)
+	slot.evs.resize(m_streams.size());
+    }
+    else{
+      //the pending events of the reopened stream count again
+      for(auto &slot: m_ring)
+	if(slot.used && slot.evs[id])
+	  slot.n++;
+    }
+    Stream &st = m_streams[id];
+    st.name = name;
+    st.closed = false;
+    st.seen = -1;
+    st.received_n = 0;
+    st.late_n = 0;
+    st.lag.assign(LAG_BINS, 0);
+    m_open_n++;
+    m_seen_heap.push_back(Seen{st.seen, id});
+    std::push_heap(m_seen_heap.begin(), m_seen_heap.end());
+    return id;
+  }
+
+  void TriggerEventBuilder::CloseStream(uint32_t id){
+    Stream &st = m_streams.at(id);
+    if(st.closed)
+      return;
+    st.closed = true;
+    m_open_n--;
+    //the events of the stream stay in their triggers, which no longer wait for it
+    for(auto &slot: m_ring)
+      if(slot.used && slot.evs[id])
+	slot.n--;
+    Advance();
+  }
+
+  void TriggerEventBuilder::Push(uint32_t id, uint32_t trigger_n, EventSPC ev){
+    Stream &st = m_streams.at(id);
+    st.received_n++;
+    int64_t lag = m_max_trigger - int64_t(trigger_n);
+    size_t bin = 0;
+    while(lag > 0 && bin + 1 < LAG_BINS){
+      lag >>= 1;
+      bin++;
+    }
+    st.lag[bin]++;
+    if(int64_t(trigger_n) > m_max_trigger)
+      m_max_trigger = trigger_n;
+
+    if(!m_occupied && m_timeout.count())
+      m_tp_head = std::chrono::steady_clock::now();
+    if(trigger_n < m_next){
+      st.late_n++;
+      return;
+    }
+    if(trigger_n >= m_next + m_window){
+      //the oldest triggers are pushed out of the window
+      m_force_until = uint64_t(trigger_n) - m_window + 1;
+      Advance();
+      if(m_next < m_force_until){
+	m_next = m_force_until;
+	m_tp_head = std::chrono::steady_clock::now();
+      }
+      m_force_until = 0;
+    }
+
+    Slot &slot = m_ring[trigger_n % m_window];
+    if(!slot.used){
+      slot.used = true;
+      slot.trigger_n = trigger_n;
+      slot.n = 0;
+      if(m_timeout.count())
+	slot.tp_first = std::chrono::steady_clock::now();
+      m_occupied++;
+    }
+    if(slot.evs[id]){
+      //the trigger was reported twice by the stream
+      st.late_n++;
+      return;
+    }
+    slot.evs[id] = std::move(ev);
+    slot.n++;
+    if(trigger_n > st.seen){
+      st.seen = trigger_n;
+      m_seen_heap.push_back(Seen{st.seen, id});
+      std::push_heap(m_seen_heap.begin(), m_seen_heap.end());
+    }
+    Advance();
+  }
+
+  int64_t TriggerEventBuilder::GetMinSeen(){
+    //the entries of closed streams and the outdated ones are removed lazily
+    while(!m_seen_heap.empty()){
+      const Seen &top = m_seen_heap.front();
+      const Stream &st = m_streams[top.id];
+      if(!st.closed && st.seen == top.seen)
+	return top.seen;
+      std::pop_heap(m_seen_heap.begin(), m_seen_heap.end());
+      m_seen_heap.pop_back();
+    }
+    return INT64_MAX;
+  }
+
+  void TriggerEventBuilder::Advance(){
+    std::chrono::steady_clock::time_point tp;
+    if(m_timeout.count())
+      tp = std::chrono::steady_clock::now();
+    while(m_occupied){
+      Slot &slot = m_ring[m_next % m_window];
+      bool used = slot.used && slot.trigger_n == m_next;
+      if(used && slot.n >= m_open_n){
+	Emit(slot);
+	continue;
+      }
+      bool give_up = m_flush || m_next < m_force_until ||
+	GetMinSeen() > int64_t(m_next + m_depth);
+      if(!give_up && m_timeout.count())
+	give_up = tp - (used ? slot.tp_first : m_tp_head) > m_timeout;
+      if(!give_up)
+	break;
+      if(used)
+	Emit(slot);
+      else
+	Skip();
+    }
+  }
+
+  void TriggerEventBuilder::Emit(Slot &slot){
+    bool complete = slot.n >= m_open_n;
+    if(complete)
+      m_complete_n++;
+    else
+      m_incomplete_n++;
+    if(!complete && m_policy == INCOMPLETE_DROP)
+      m_dropped_n++;
+    else{
+      m_out.push_back(Built());
+      Built &built = m_out.back();
+      built.trigger_n = slot.trigger_n;
+      built.complete = complete;
+      for(uint32_t i = 0; i < slot.evs.size(); i++){
+	if(slot.evs[i])
+	  built.evs.push_back(slot.evs[i]);
+	else if(!complete && !m_streams[i].closed)
+	  built.missing.push_back(m_streams[i].name);
+      }
+    }
+    for(auto &ev: slot.evs)
+      ev.reset();
+    slot.used = false;
+    m_occupied--;
+    Skip();
+  }
+
+  void TriggerEventBuilder::Skip(){
+    m_next++;
+    if(m_timeout.count())
+      m_tp_head = std::chrono::steady_clock::now();
+  }
+
+  bool TriggerEventBuilder::Pop(Built &built){
+    if(m_out.empty() && m_timeout.count())
+      Advance();
+    if(m_out.empty())
+      return false;
+    built = std::move(m_out.front());
+    m_out.pop_front();
+    return true;
+  }
+
+  void TriggerEventBuilder::Flush(){
+    m_flush = true;
+    Advance();
+  }
+
+  void TriggerEventBuilder::Reset(){
+    for(auto &slot: m_ring){
+      slot.used = false;
+      for(auto &ev: slot.evs)
+	ev.reset();
+    }
+    m_seen_heap.clear();
+    for(uint32_t i = 0; i < m_streams.size(); i++){
+      Stream &st = m_streams[i];
+      st.seen = -1;
+      st.received_n = 0;
+      st.late_n = 0;
+      st.lag.assign(LAG_BINS, 0);
+      if(!st.closed)
+	m_seen_heap.push_back(Seen{st.seen, i});
+    }
+    m_occupied = 0;
+    m_next = 0;
+    m_force_until = 0;
+    m_max_trigger = -1;
+    m_flush = false;
+    m_out.clear();
+    m_complete_n = 0;
+    m_incomplete_n = 0;
+    m_dropped_n = 0;
+  }
+
+  std::vector<TriggerEventBuilder::StreamStatus> TriggerEventBuilder::GetStreamStatus() const{
+    std::vector<StreamStatus> status;
+    for(auto &st: m_streams){
+      if(st.closed)
+	continue;
+      StreamStatus s;
+      s.name = st.name;
+      s.received_n = st.received_n;
+      s.late_n = st.late_n;
+      s.lag = st.lag;
+      status.push_back(s);
+    }
+    return status;
+  }
+}
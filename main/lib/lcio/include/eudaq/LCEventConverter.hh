@@ -30,6 +30,8 @@ namespace eudaq{
     LCEventConverter& operator = (const LCEventConverter&) = delete;
     bool Converting(EventSPC d1, LCEventSP d2, ConfigurationSPC conf) const override = 0;
     static bool Convert(EventSPC d1, LCEventSP d2, ConfigurationSPC conf);
+    //true if all the converters needed by the event are thread safe
+    static bool CanConvertInParallel(EventSPC d1);
     // static LCEventSP MakeSharedLCEvent(uint32_t run, uint32_t stm);
   };
 
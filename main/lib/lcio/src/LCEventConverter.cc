@@ -1,11 +1,38 @@
 #include "eudaq/LCEventConverter.hh"
 
+#include <map>
+
 namespace eudaq{
   
   template DLLEXPORT
   std::map<uint32_t, typename Factory<LCEventConverter>::UP(*)()>&
   Factory<LCEventConverter>::Instance<>();
   
+  bool LCEventConverter::CanConvertInParallel(EventSPC d1){
+    if(d1->IsFlagFake()){
+      return true;
+    }
+    if(d1->IsFlagPacket()){
+      size_t nsub = d1->GetNumSubEvent();
+      for(size_t i=0; i<nsub; i++){
+	if(!CanConvertInParallel(d1->GetSubEvent(i)))
+	  return false;
+      }
+      return true;
+    }
+    //the answer depends on the type only, and on the extend word of the
+    //RawEvent dispatching to the converter of the user
+    thread_local std::map<uint64_t, bool> thread_safe;
+    uint64_t key = uint64_t(d1->GetType()) << 32 | d1->GetExtendWord();
+    auto it = thread_safe.find(key);
+    if(it != thread_safe.end())
+      return it->second;
+    auto cvt = Factory<LCEventConverter>::MakeUnique(d1->GetType());
+    bool safe = !cvt || cvt->IsThreadSafe(d1);
+    thread_safe[key] = safe;
+    return safe;
+  }
+
   bool LCEventConverter::Convert(EventSPC d1, LCEventSP d2, ConfigurationSPC conf){
     if(d1->IsFlagFake()){
       return true;
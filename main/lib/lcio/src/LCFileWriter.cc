@@ -27,17 +27,43 @@ namespace eudaq {
   public:
     LCFileWriter(const std::string &patt);
     void WriteEvent(EventSPC ev) override;
+    ConvertedEventUP ConvertEvent(EventSPC ev) const override;
+    void WriteConverted(EventSPC ev, ConvertedEventUP cvt) override;
   private:
+    ConvertedEventUP Convert(EventSPC ev) const;
     std::unique_ptr<lcio::LCWriter> m_lcwriter;
     std::string m_filepattern;
     uint32_t m_run_n;
   };
 
+  class LCConvertedEvent : public ConvertedEvent {
+  public:
+    LCEventSP m_lcevent;
+  };
+
   LCFileWriter::LCFileWriter(const std::string &patt){
     m_filepattern = patt;
   }
 
   void LCFileWriter::WriteEvent(EventSPC ev) {
+    WriteConverted(ev, nullptr);
+  }
+
+  ConvertedEventUP LCFileWriter::ConvertEvent(EventSPC ev) const {
+    //the others are converted in order by WriteConverted
+    if(!LCEventConverter::CanConvertInParallel(ev))
+      return nullptr;
+    return Convert(ev);
+  }
+
+  ConvertedEventUP LCFileWriter::Convert(EventSPC ev) const {
+    std::unique_ptr<LCConvertedEvent> cvt(new LCConvertedEvent);
+    cvt->m_lcevent.reset(new lcio::LCEventImpl);
+    LCEventConverter::Convert(ev, cvt->m_lcevent, GetConfiguration());
+    return cvt;
+  }
+
+  void LCFileWriter::WriteConverted(EventSPC ev, ConvertedEventUP cvt) {
     uint32_t run_n = ev->GetRunN();
     if(!m_lcwriter || m_run_n != run_n){
       try {
@@ -56,8 +82,11 @@ namespace eudaq {
     }
     if(!m_lcwriter)
       EUDAQ_THROW("LCFileWriter: Attempt to write unopened file");
-    LCEventSP lcevent(new lcio::LCEventImpl);
-    LCEventConverter::Convert(ev, lcevent, GetConfiguration());
-    m_lcwriter->writeEvent(lcevent.get());
+    if(!cvt)
+      cvt = Convert(ev);
+    auto lccvt = dynamic_cast<LCConvertedEvent*>(cvt.get());
+    if(!lccvt)
+      EUDAQ_THROW("LCFileWriter: The event is not converted to LCIO");
+    m_lcwriter->writeEvent(lccvt->m_lcevent.get());
   }
 }
@@ -6,6 +6,7 @@ namespace eudaq{
   class RawEvent2LCEventConverter: public LCEventConverter{
   public:
     bool Converting(EventSPC d1, LCEventSP d2, ConfigurationSPC conf) const override;
+    bool IsThreadSafe(EventSPC d1) const override;
     static const uint32_t m_id_factory = cstr2hash("RawEvent");
   };
 
@@ -14,6 +15,15 @@ namespace eudaq{
       Register<RawEvent2LCEventConverter>(RawEvent2LCEventConverter::m_id_factory);
   }
   
+  //as thread safe as the converter it dispatches to
+  bool RawEvent2LCEventConverter::IsThreadSafe(EventSPC d1) const {
+    auto ev = std::dynamic_pointer_cast<const RawDataEvent>(d1);
+    if(!ev)
+      return true;
+    auto cvt = Factory<LCEventConverter>::MakeUnique(ev->GetExtendWord());
+    return !cvt || cvt->IsThreadSafe(d1);
+  }
+
   bool RawEvent2LCEventConverter::Converting(EventSPC d1, LCEventSP d2, ConfigurationSPC conf) const {
     auto ev = std::dynamic_pointer_cast<const RawDataEvent>(d1);
     if(!ev){
@@ -106,7 +106,7 @@ void  init_pybind_event(py::module &m){
   
   event_.def("GetBlock",
 	     [](const eudaq::EventSP ev,uint32_t n){
-	        std::vector<uint8_t> block=ev->GetBlock(n);
+	        eudaq::BlockView block=ev->GetBlockView(n);
 	        return py::bytes((const char*)block.data(),block.size());
              },
      	     "Get block", py::arg("n"));
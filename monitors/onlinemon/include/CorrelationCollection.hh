@@ -53,9 +53,20 @@ class CorrelationCollection : public BaseCollection {
                          const bool all_mimosa);
   void fillHistograms(vector<vector<pair<int, SimpleStandardCluster>>> tracks,
                       const SimpleStandardEvent &simpEv);
-  void fillHistograms(const SimpleStandardPlane &p1,
-                      const SimpleStandardPlane &p2,
-		      const SimpleStandardEvent &simpEv);
+  // cluster coordinates of a plane, computed once per event and sorted in x
+  struct ClusterPoint {
+    int x;
+    int y;
+    bool operator<(const ClusterPoint &r) const { return x < r.x; }
+  };
+  void getClusterPoints(const SimpleStandardPlane &p,
+                        vector<ClusterPoint> &points) const;
+  uint64_t countPairs(const vector<ClusterPoint> &a,
+                      const vector<ClusterPoint> &b) const;
+  void fillHistograms(CorrelationHistos *corrmap,
+                      const vector<ClusterPoint> &a,
+                      const vector<ClusterPoint> &b,
+                      const SimpleStandardEvent &simpEv);
 
 public:
   CorrelationCollection();
@@ -85,6 +96,10 @@ class CorrelationCollection : public BaseCollection {
     return planesNumberForCorrelation;
   }
   unsigned getWindowWidthForCorrelation() { return windowWidthForCorrelation; }
+  // cluster pairs filled in the last event and the fraction of the candidate
+  // pairs they are, below 1 if the MaxPairs budget was exceeded
+  unsigned int getLastPairs() const { return lastPairs; }
+  double getLastSampling() const { return lastSampling; }
 
 private:
   vector<bool> skip_this_plane; // a array of booleans, initialized with values
@@ -93,6 +108,12 @@ class CorrelationCollection : public BaseCollection {
   vector<int> selected_planes_to_skip;
   unsigned planesNumberForCorrelation;
   unsigned windowWidthForCorrelation;
+  // per event state of fillHistograms
+  vector<vector<ClusterPoint>> pointsInPlanes;
+  uint64_t pairStride;
+  uint64_t pairIndex;
+  unsigned int lastPairs;
+  double lastSampling;
 };
 
 #ifdef __CINT__
@@ -48,6 +48,9 @@ class CorrelationHistos {
   void FillCorrVsTime(const SimpleStandardCluster &cluster1,
 		      const SimpleStandardCluster &cluster2,
 		      const SimpleStandardEvent &simpev);
+  // fills the correlation and the correlation vs time histograms from
+  // cluster coordinates, the caller holds the mutex
+  void FillPair(int x1, int y1, int x2, int y2, unsigned int event_number);
 
   
   void Reset();
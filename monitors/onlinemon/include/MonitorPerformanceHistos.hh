@@ -24,6 +24,10 @@ class MonitorPerformanceHistos {
   TH1I *_FillTimeHisto;
   TH1I *_ClusteringTimeHisto;
   TH1I *_CorrelationTimeHisto;
+  TH1I *_CorrelationPairsHisto;
+  TH1I *_CorrelationSamplingHisto;
+  TH1I *_EventRateHisto;
+  TH1I *_EventRateNoCorrelationHisto;
 
   std::mutex m_mu;
   
@@ -37,6 +41,12 @@ class MonitorPerformanceHistos {
   TH1I *getFillTimeHisto() { return _FillTimeHisto; }
   TH1I *getClusteringTimeHisto() { return _ClusteringTimeHisto; }
   TH1I *getCorrelationTimeHisto() { return _CorrelationTimeHisto; }
+  TH1I *getCorrelationPairsHisto() { return _CorrelationPairsHisto; }
+  TH1I *getCorrelationSamplingHisto() { return _CorrelationSamplingHisto; }
+  TH1I *getEventRateHisto() { return _EventRateHisto; }
+  TH1I *getEventRateNoCorrelationHisto() {
+    return _EventRateNoCorrelationHisto;
+  }
   std::mutex* getMutex(){return &m_mu;};
   
 };
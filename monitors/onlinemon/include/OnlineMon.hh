@@ -55,6 +55,7 @@ class RootMonitor : public eudaq::Monitor{
   
   void setWriteRoot(const bool write);
   void setReduce(const unsigned int red);
+  void setAnalysisThreads(const unsigned int n);
   void setUpdate(const unsigned int up);
   void setCorr_width(const unsigned c_w);
   void setCorr_planes(const unsigned c_p);
@@ -69,6 +70,20 @@ class RootMonitor : public eudaq::Monitor{
   OnlineMonConfiguration mon_configdata; // FIXME
   std::shared_ptr<eudaq::Configuration> eu_cfgPtr;
 private:
+  // conversion and clustering, may run on several threads
+  void AnalyseEvent(eudaq::EventSP evsp, SimpleStandardEvent &simpEv);
+  // false if the event has not the number of planes seen in the first events
+  bool CheckPlanes(const SimpleStandardEvent &simpEv) const;
+  // filling of the collections, in the order of the events; the call
+  // filling the correlation keeps the performance monitor and the counters
+  void FillEvent(SimpleStandardEvent &simpEv, const std::vector<BaseCollection *> &colls);
+  void StartAnalysis();
+  void StopAnalysis();
+  struct AnalysisPool;
+  void Analysing(AnalysisPool *pool);
+  void Filling(AnalysisPool *pool, size_t lane);
+  std::shared_ptr<AnalysisPool> m_pool;
+  unsigned int m_ana_threads;
   std::vector<BaseCollection *> _colls;
   OnlineMonWindow *onlinemon;
   std::string rootfilename;
@@ -83,10 +98,10 @@ class RootMonitor : public eudaq::Monitor{
   bool useTrackCorrelator;
   TStopwatch my_event_processing_time;
   TStopwatch my_event_inner_operations_time;
-  double previous_event_analysis_time;
   double previous_event_fill_time;
-  double previous_event_clustering_time;
   double previous_event_correlation_time;
+  unsigned int previous_event_correlation_pairs;
+  double previous_event_correlation_sampling;
   unsigned int tracksPerEvent;
   uint32_t m_plane_c;
   uint32_t m_ev_rec_n = 0;
@@ -18,6 +18,11 @@
 
 class OnlineMonConfiguration {
 public:
+  // hit labelling of SimpleStandardPlane::doClustering
+  enum ClusterAlgorithm {
+    CLUSTER_PAIRWISE = 0, // compares the hits pairwise, quadratic
+    CLUSTER_SCANLINE = 1  // union-find over hits sorted by column and row
+  };
   OnlineMonConfiguration();
   OnlineMonConfiguration(std::string confname);
   virtual ~OnlineMonConfiguration();
@@ -45,6 +50,12 @@ class OnlineMonConfiguration {
 
   int getCorrel_minclustersize() const;
   void setCorrel_minclustersize(int correl_minclustersize);
+  int getCorrel_window() const;
+  void setCorrel_window(int correl_window);
+  int getCorrel_maxpairs() const;
+  void setCorrel_maxpairs(int correl_maxpairs);
+  int getCluster_algorithm() const;
+  void setCluster_algorithm(int cluster_algorithm);
   std::vector<int> getPlanes_to_be_skipped() const;
   void setPlanes_to_be_skipped(std::vector<int> planes_to_be_skipped);
 
@@ -60,7 +71,10 @@ class OnlineMonConfiguration {
   std::map<int, bool> correlation_xy_flip;
   std::vector<int> planes_to_be_skipped;
   int correl_minclustersize;
+  int correl_window;   // 0 correlates all cluster pairs
+  int correl_maxpairs; // 0 fills all cluster pairs of an event
   // Clusterizer settings
+  int cluster_algorithm;
 
   // hotcluster finder settings
   double hotpixelcut;
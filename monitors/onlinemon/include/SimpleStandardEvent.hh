@@ -50,17 +50,21 @@ class SimpleStandardEvent {
   SimpleStandardEvent();
 
   void addPlane(SimpleStandardPlane &plane);
-  SimpleStandardPlane getPlane(const int i) const { return _planes.at(i); }
+  const SimpleStandardPlane &getPlane(const int i) const { return _planes.at(i); }
   int getNPlanes() const { return _planes.size(); }
   void doClustering();
   double getMonitor_eventanalysistime() const;
   double getMonitor_eventfilltime() const;
   double getMonitor_clusteringtime() const;
   double getMonitor_correlationtime() const;
+  unsigned int getMonitor_correlationpairs() const;
+  double getMonitor_correlationsampling() const;
   void setMonitor_eventanalysistime(double monitor_eventanalysistime);
   void setMonitor_eventfilltime(double monitor_eventfilltime);
   void setMonitor_eventclusteringtime(double monitor_eventclusteringtime);
   void setMonitor_eventcorrelationtime(double monitor_eventcorrelationtime);
+  void setMonitor_correlationpairs(unsigned int monitor_correlationpairs);
+  void setMonitor_correlationsampling(double monitor_correlationsampling);
 
   unsigned int getEvent_number() const;
   void setEvent_number(unsigned int event_number);
@@ -75,6 +79,8 @@ class SimpleStandardEvent {
   double monitor_eventanalysistime;
   double monitor_clusteringtime; // stores the time to fill the histogram
   double monitor_correlationtime;
+  unsigned int monitor_correlationpairs; // cluster pairs filled in the correlations
+  double monitor_correlationsampling; // fraction of the candidate pairs filled
   unsigned int event_number;
   uint64_t event_timestamp;
   std::map<std::string, double> slowpara;
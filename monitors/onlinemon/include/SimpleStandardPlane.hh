@@ -94,6 +94,12 @@ class SimpleStandardPlane {
   bool is_UNKNOWN;
 
 private:
+  // cluster number of each hit
+  void labelHitsPairwise(std::vector<int> &clusterNumber);
+  void labelHitsScanline(std::vector<int> &clusterNumber);
+  static int findCluster(std::vector<int> &clusterNumber, int i);
+  static void joinClusters(std::vector<int> &clusterNumber, int a, int b);
+  void fillClusters(const std::vector<int> &clusterNumber);
   OnlineMonConfiguration *mon;
   bool AnalogPixelType; // dealing with pixels, that have analog information
   bool isRotated; // dealing with planes rotated by 90 degrees
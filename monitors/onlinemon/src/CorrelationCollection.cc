@@ -8,10 +8,15 @@
 #include "CorrelationCollection.hh"
 #include "OnlineMon.hh"
 
+#include <algorithm>
+#include <cstdlib>
+
 CorrelationCollection::CorrelationCollection()
     : BaseCollection(), _map(), _planes(), skip_this_plane(),
       correlateAllPlanes(false), selected_planes_to_skip(),
-      planesNumberForCorrelation(0), windowWidthForCorrelation(0) {
+      planesNumberForCorrelation(0), windowWidthForCorrelation(0),
+      pointsInPlanes(), pairStride(1), pairIndex(0), lastPairs(0),
+      lastSampling(1) {
   CollectionType = CORRELATION_COLLECTION_TYPE;
 }
 
@@ -91,6 +96,8 @@ void CorrelationCollection::Fill(const SimpleStandardEvent &simpev) {
   // int totalFills = 0;
   int nPlanes = simpev.getNPlanes();
   int nPlanes_disabled = 0;
+  lastPairs = 0;
+  lastSampling = 1;
 
   unsigned int plane_vector_size = 0;
   if (skip_this_plane.size() == 0) // do this only at the very first event
@@ -149,15 +156,48 @@ void CorrelationCollection::Fill(const SimpleStandardEvent &simpev) {
         }
         _planes.push_back(simpPlane); // we have to deal with all planes
       }
+    }
+
+    // the clusters of every plane are prepared once, not once per plane pair
+    pointsInPlanes.resize(nPlanes);
+    for (int plane = 0; plane < nPlanes; plane++) {
+      if (skip_this_plane[plane] == false)
+        getClusterPoints(simpev.getPlane(plane), pointsInPlanes[plane]);
+    }
+
+    std::vector<std::pair<int, int>> planePairs;
+    std::vector<CorrelationHistos *> planePairHistos;
+    uint64_t candidates = 0;
+    for (int planeA = 0; planeA < nPlanes; planeA++) {
       for (int planeB = planeA + 1; planeB < nPlanes; planeB++) {
         if ((skip_this_plane[planeA] == false) &&
             (skip_this_plane[planeB]) == false) {
-          const SimpleStandardPlane &p1 = simpev.getPlane(planeA);
-          const SimpleStandardPlane &p2 = simpev.getPlane(planeB);
-          fillHistograms(p1, p2,simpev);
+          std::pair<SimpleStandardPlane, SimpleStandardPlane> plane(
+              simpev.getPlane(planeA), simpev.getPlane(planeB));
+          auto it = _map.find(plane);
+          if (it == _map.end() || !it->second)
+            continue;
+          planePairs.push_back(std::make_pair(planeA, planeB));
+          planePairHistos.push_back(it->second);
         }
       }
     }
+
+    // with a budget, every n-th candidate pair of the event is filled
+    const uint64_t maxPairs = _mon->mon_configdata.getCorrel_maxpairs();
+    pairStride = 1;
+    pairIndex = 0;
+    if (maxPairs > 0) {
+      for (unsigned int i = 0; i < planePairs.size(); i++)
+        candidates += countPairs(pointsInPlanes[planePairs[i].first],
+                                 pointsInPlanes[planePairs[i].second]);
+      if (candidates > maxPairs)
+        pairStride = (candidates + maxPairs - 1) / maxPairs;
+    }
+    for (unsigned int i = 0; i < planePairs.size(); i++)
+      fillHistograms(planePairHistos[i], pointsInPlanes[planePairs[i].first],
+                     pointsInPlanes[planePairs[i].second], simpev);
+    lastSampling = candidates > 0 ? double(lastPairs) / candidates : 1;
   }
 }
 
@@ -172,7 +212,6 @@ CorrelationCollection::FillWithTracks(const SimpleStandardEvent &simpev) {
   bool noClusterFound;
   const int lastPlane = nPlanes - 1;
   SimpleStandardCluster tempCluster;
-  bool correlationDecission;
 
   unsigned int plane_vector_size = 0;
   if (skip_this_plane.size() == 0) // do this only at the very first event
@@ -276,39 +315,38 @@ CorrelationCollection::FillWithTracks(const SimpleStandardEvent &simpev) {
              ++nextPlaneIndex) {
           std::vector<SimpleStandardCluster> &clustersInNextPlane =
               clustersInPlanes.at(nextPlaneIndex);
-          noClusterFound = false;
-
-          //                    for(std::vector<SimpleStandardCluster>::iterator
-          //                    it = --nextPlane.end(); it >= nextPlane.begin();
-          //                    --it)
-          //                    int currentSize = clustersInNextPlane.size();
-          for (int currentclusterIndex = clustersInNextPlane.size() - 1;
-               currentclusterIndex >= 0; --currentclusterIndex) {
-            SimpleStandardCluster &currentCluster =
-                clustersInNextPlane.at(currentclusterIndex);
-            //                        if( currentCluster.getNPixel() >=
-            //                        _mon->mon_configdata.getCorrel_minclustersize()
-            //                                &&
-            //                                checkCorrelations(singleTrack.back().second,
-            //                                currentCluster) )
-
-            if (simpev.getPlane(currPlaneIndex).is_MIMOSA26 &&
-                simpev.getPlane(nextPlaneIndex).is_MIMOSA26)
-              correlationDecission =
-                  checkCorrelations(singleTrack.back().second, currentCluster);
-            else
-              correlationDecission = checkCorrelations(
-                  singleTrack.back().second, currentCluster, false);
-            if (correlationDecission) {
-              std::pair<int, SimpleStandardCluster> trackPair(nextPlaneIndex,
-                                                              currentCluster);
-              singleTrack.push_back(trackPair);
-              clustersInNextPlane.erase(clustersInNextPlane.begin() +
-                                        currentclusterIndex);
-              break;
-            } else if (currentclusterIndex == 0)
-              noClusterFound = true;
+          bool clusterFound = false;
+
+          // only MIMOSA26 planes are correlated, the clusters are sorted in x
+          // and only those inside the window in x are checked, from the back
+          if (simpev.getPlane(currPlaneIndex).is_MIMOSA26 &&
+              simpev.getPlane(nextPlaneIndex).is_MIMOSA26) {
+            const SimpleStandardCluster &seed = singleTrack.back().second;
+            const int window = getWindowWidthForCorrelation();
+            const int seedX = seed.getX();
+            auto first = std::partition_point(
+                clustersInNextPlane.begin(), clustersInNextPlane.end(),
+                [&](const SimpleStandardCluster &c) {
+                  return c.getX() <= seedX - window;
+                });
+            auto last = std::partition_point(
+                first, clustersInNextPlane.end(),
+                [&](const SimpleStandardCluster &c) {
+                  return c.getX() < seedX + window;
+                });
+            while (last != first) {
+              --last;
+              if (checkCorrelations(seed, *last)) {
+                std::pair<int, SimpleStandardCluster> trackPair(nextPlaneIndex,
+                                                                *last);
+                singleTrack.push_back(trackPair);
+                clustersInNextPlane.erase(last);
+                clusterFound = true;
+                break;
+              }
+            }
           }
+          noClusterFound = !clusterFound && !clustersInNextPlane.empty();
 
           if (nextPlaneIndex == lastPlane || noClusterFound) {
             if (singleTrack.size() >= getPlanesNumberForCorrelation())
@@ -326,6 +364,8 @@ void CorrelationCollection::fillHistograms(
     std::vector<vector<pair<int, SimpleStandardCluster>>> tracks,
     const SimpleStandardEvent &simpEv) {
 
+  lastPairs = 0;
+  lastSampling = 1;
   for (unsigned int trackNr = 0; trackNr < tracks.size(); ++trackNr) {
     vector<pair<int, SimpleStandardCluster>> &currentTrack = tracks.at(trackNr);
     for (unsigned int clusterPair1 = 0; clusterPair1 < currentTrack.size() - 1;
@@ -346,48 +386,76 @@ void CorrelationCollection::fillHistograms(
 
         corrmap->Fill(firstCluster, secondCluster);
 	corrmap->FillCorrVsTime(firstCluster, secondCluster, simpEv);
+        lastPairs++;
       }
     }
   }
 }
 
-void CorrelationCollection::fillHistograms(const SimpleStandardPlane &p1,
-                                           const SimpleStandardPlane &p2,
-					   const SimpleStandardEvent &simpEv) {
+void CorrelationCollection::getClusterPoints(
+    const SimpleStandardPlane &p, std::vector<ClusterPoint> &points) const {
+  const std::vector<SimpleStandardCluster> &clusters = p.getClusters();
+  const int minClusterSize = _mon->mon_configdata.getCorrel_minclustersize();
+  points.clear();
+  points.reserve(clusters.size());
+  for (unsigned int i = 0; i < clusters.size(); i++) {
+    // we are only interested in clusters with several pixels
+    if (clusters[i].getNPixel() < minClusterSize)
+      continue;
+    ClusterPoint point = {clusters[i].getX(), clusters[i].getY()};
+    points.push_back(point);
+  }
+  std::sort(points.begin(), points.end());
+}
 
-  std::pair<SimpleStandardPlane, SimpleStandardPlane> plane(p1, p2);
-  CorrelationHistos *corrmap = _map[plane];
-  if (corrmap) {
-    const std::vector<SimpleStandardCluster> aClusters = p1.getClusters();
-    const std::vector<SimpleStandardCluster> bClusters = p2.getClusters();
-
-    for (unsigned int acluster = 0; acluster < aClusters.size(); acluster++) {
-      const SimpleStandardCluster &oneAcluster = aClusters.at(acluster);
-      if (oneAcluster.getNPixel() <
-          _mon->mon_configdata.getCorrel_minclustersize()) // we are only
-                                                           // interested in
-                                                           // clusters with
-                                                           // several pixels
-      {
-        continue;
-      }
-      for (unsigned int bcluster = 0; bcluster < bClusters.size(); bcluster++) {
-        const SimpleStandardCluster &oneBcluster = bClusters.at(bcluster);
-        //
-        if (oneBcluster.getNPixel() <
-            _mon->mon_configdata.getCorrel_minclustersize()) {
-          continue;
-        } else {
-          corrmap->Fill(oneAcluster, oneBcluster);
-	  corrmap->FillCorrVsTime(oneAcluster, oneBcluster, simpEv);
-        }
+uint64_t CorrelationCollection::countPairs(
+    const std::vector<ClusterPoint> &a,
+    const std::vector<ClusterPoint> &b) const {
+  const int window = _mon->mon_configdata.getCorrel_window();
+  if (window <= 0)
+    return uint64_t(a.size()) * b.size();
+  uint64_t n = 0;
+  for (unsigned int i = 0; i < a.size(); i++) {
+    ClusterPoint low = {a[i].x - window + 1, 0};
+    for (auto it = std::lower_bound(b.begin(), b.end(), low);
+         it != b.end() && it->x < a[i].x + window; ++it)
+      if (abs(a[i].y - it->y) < window)
+        n++;
+  }
+  return n;
+}
+
+void CorrelationCollection::fillHistograms(
+    CorrelationHistos *corrmap, const std::vector<ClusterPoint> &a,
+    const std::vector<ClusterPoint> &b, const SimpleStandardEvent &simpEv) {
+  const int window = _mon->mon_configdata.getCorrel_window();
+  const unsigned int event_number = simpEv.getEvent_number();
+  std::lock_guard<std::mutex> lck(*corrmap->getMutex());
+  for (unsigned int i = 0; i < a.size(); i++) {
+    if (window <= 0) {
+      // all pairs are candidates, the sampled ones are stepped to directly
+      uint64_t j = (pairStride - pairIndex % pairStride) % pairStride;
+      for (; j < b.size(); j += pairStride) {
+        corrmap->FillPair(a[i].x, a[i].y, b[j].x, b[j].y, event_number);
+        lastPairs++;
       }
+      pairIndex += b.size();
+      continue;
+    }
+    // only the clusters of b inside the window in x
+    ClusterPoint low = {a[i].x - window + 1, 0};
+    for (auto it = std::lower_bound(b.begin(), b.end(), low);
+         it != b.end() && it->x < a[i].x + window; ++it) {
+      if (abs(a[i].y - it->y) >= window)
+        continue;
+      if (pairIndex++ % pairStride != 0)
+        continue;
+      corrmap->FillPair(a[i].x, a[i].y, it->x, it->y, event_number);
+      lastPairs++;
     }
   }
 }
 
-
-
 void CorrelationCollection::registerPlaneCorrelations(
     const SimpleStandardPlane &p1, const SimpleStandardPlane &p2) {
 
@@ -139,6 +139,17 @@ void CorrelationHistos::FillCorrVsTime(const SimpleStandardCluster &cluster1,
 
 }
 
+void CorrelationHistos::FillPair(int x1, int y1, int x2, int y2,
+                                 unsigned int event_number) {
+  if (_2dcorrX != NULL)
+    _2dcorrX->Fill(x1, x2);
+  if (_2dcorrY != NULL)
+    _2dcorrY->Fill(y1, y2);
+  if (_2dcorrTimeX != NULL)
+    _2dcorrTimeX->Fill(event_number, x1 - x2 * m_pitchX2 / m_pitchX1);
+  if (_2dcorrTimeY != NULL)
+    _2dcorrTimeY->Fill(event_number, y1 - y2 * m_pitchY2 / m_pitchY1);
+}
 
 void CorrelationHistos::Reset() {
   _2dcorrX->Reset();
@@ -83,6 +83,38 @@ void MonitorPerformanceCollection::bookHistograms(
     _mon->getOnlineMon()->registerMutex(
         (performance_folder_name + "/Correlation Time"),
         mymonhistos->getMutex());
+    _mon->getOnlineMon()->registerTreeItem(
+        (performance_folder_name + "/Correlation Pairs"));
+    _mon->getOnlineMon()->registerHisto(
+        (performance_folder_name + "/Correlation Pairs"),
+        mymonhistos->getCorrelationPairsHisto());
+    _mon->getOnlineMon()->registerMutex(
+        (performance_folder_name + "/Correlation Pairs"),
+        mymonhistos->getMutex());
+    _mon->getOnlineMon()->registerTreeItem(
+        (performance_folder_name + "/Correlation Sampled Fraction"));
+    _mon->getOnlineMon()->registerHisto(
+        (performance_folder_name + "/Correlation Sampled Fraction"),
+        mymonhistos->getCorrelationSamplingHisto());
+    _mon->getOnlineMon()->registerMutex(
+        (performance_folder_name + "/Correlation Sampled Fraction"),
+        mymonhistos->getMutex());
+    _mon->getOnlineMon()->registerTreeItem(
+        (performance_folder_name + "/Max Event Rate"));
+    _mon->getOnlineMon()->registerHisto(
+        (performance_folder_name + "/Max Event Rate"),
+        mymonhistos->getEventRateHisto());
+    _mon->getOnlineMon()->registerMutex(
+        (performance_folder_name + "/Max Event Rate"),
+        mymonhistos->getMutex());
+    _mon->getOnlineMon()->registerTreeItem(
+        (performance_folder_name + "/Max Event Rate without Correlation"));
+    _mon->getOnlineMon()->registerHisto(
+        (performance_folder_name + "/Max Event Rate without Correlation"),
+        mymonhistos->getEventRateNoCorrelationHisto());
+    _mon->getOnlineMon()->registerMutex(
+        (performance_folder_name + "/Max Event Rate without Correlation"),
+        mymonhistos->getMutex());
 
     _mon->getOnlineMon()->makeTreeItemSummary(
         performance_folder_name.c_str()); // make summary page
@@ -17,8 +17,22 @@ MonitorPerformanceHistos::MonitorPerformanceHistos() {
       new TH1I("Clustering Time", "Clustering Time", 400, 0, 0.01);
   _CorrelationTimeHisto =
       new TH1I("Correlation Time", "Correlation Time", 400, 0, 0.02);
+  _CorrelationPairsHisto = new TH1I("Correlation Pairs", "Correlation Pairs",
+                                    400, 0, 20000);
+  _CorrelationSamplingHisto =
+      new TH1I("Correlation Sampled Fraction", "Correlation Sampled Fraction",
+               100, 0, 1.0001);
+  // the rate the histogram filling could sustain, with and without the
+  // correlations
+  _EventRateHisto =
+      new TH1I("Max Event Rate", "Max Event Rate [kHz]", 500, 0, 50);
+  _EventRateNoCorrelationHisto =
+      new TH1I("Max Event Rate without Correlation",
+               "Max Event Rate without Correlation [kHz]", 500, 0, 50);
   if ((_FillTimeHisto == NULL) || (_AnalysisTimeHisto == NULL) ||
-      (_ClusteringTimeHisto == NULL) || (_CorrelationTimeHisto == NULL)) {
+      (_ClusteringTimeHisto == NULL) || (_CorrelationTimeHisto == NULL) ||
+      (_CorrelationPairsHisto == NULL) || (_CorrelationSamplingHisto == NULL) ||
+      (_EventRateHisto == NULL) || (_EventRateNoCorrelationHisto == NULL)) {
     std::cerr << "MonitorPerformanceHistos:: Error allocating Histograms"
               << std::endl;
     exit(-1); // we bail out, if can't allocate memory
@@ -34,6 +48,10 @@ void MonitorPerformanceHistos::Write() {
   _FillTimeHisto->Write();
   _ClusteringTimeHisto->Write();
   _CorrelationTimeHisto->Write();
+  _CorrelationPairsHisto->Write();
+  _CorrelationSamplingHisto->Write();
+  _EventRateHisto->Write();
+  _EventRateNoCorrelationHisto->Write();
 }
 
 void MonitorPerformanceHistos::Fill(SimpleStandardEvent ev) {
@@ -42,6 +60,15 @@ void MonitorPerformanceHistos::Fill(SimpleStandardEvent ev) {
   _FillTimeHisto->Fill(ev.getMonitor_eventfilltime());
   _ClusteringTimeHisto->Fill(ev.getMonitor_clusteringtime());
   _CorrelationTimeHisto->Fill(ev.getMonitor_correlationtime());
+  _CorrelationPairsHisto->Fill(ev.getMonitor_correlationpairs());
+  _CorrelationSamplingHisto->Fill(ev.getMonitor_correlationsampling());
+  double filltime = ev.getMonitor_eventfilltime();
+  if (filltime > 0) {
+    _EventRateHisto->Fill(1e-3 / filltime);
+    double filltime_nocorr = filltime - ev.getMonitor_correlationtime();
+    if (filltime_nocorr > 0)
+      _EventRateNoCorrelationHisto->Fill(1e-3 / filltime_nocorr);
+  }
 }
 
 void MonitorPerformanceHistos::Reset() {
@@ -49,4 +76,8 @@ void MonitorPerformanceHistos::Reset() {
   _FillTimeHisto->Reset();
   _ClusteringTimeHisto->Reset();
   _CorrelationTimeHisto->Reset();
+  _CorrelationPairsHisto->Reset();
+  _CorrelationSamplingHisto->Reset();
+  _EventRateHisto->Reset();
+  _EventRateNoCorrelationHisto->Reset();
 }
@@ -40,6 +40,11 @@
 #include <chrono>
 #include <thread>
 #include <memory>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <algorithm>
 
 //ONLINE MONITOR Includes
 #include "OnlineMon.hh"
@@ -48,6 +53,54 @@
 #include "eudaq/FileReader.hh"
 using namespace std;
 
+// state of the analysis threads, see RootMonitor::setAnalysisThreads
+struct RootMonitor::AnalysisPool {
+  // a filling thread and the collections only it fills
+  struct Lane {
+    std::vector<BaseCollection *> colls;
+    // analysed events waiting to be filled in order, nullptr if the event is skipped
+    std::map<uint64_t, std::shared_ptr<SimpleStandardEvent>> out;
+    uint64_t fill_n = 0;
+    std::future<void> fut;
+  };
+  std::mutex mtx;
+  std::condition_variable cv_in;
+  std::condition_variable cv_out;
+  std::condition_variable cv_space;
+  // received events, by submission number
+  std::deque<std::pair<uint64_t, eudaq::EventSP>> in;
+  std::vector<std::unique_ptr<Lane>> lanes;
+  uint64_t submit_n = 0;
+  size_t depth = 0;
+  bool exit = false;
+  std::vector<std::future<void>> fut_ana;
+  // events filled by all the lanes
+  uint64_t FilledN() const {
+    uint64_t n = submit_n;
+    for(auto &lane: lanes)
+      n = std::min(n, lane->fill_n);
+    return n;
+  }
+};
+
+static eudaq::StandardEventSP ToStandardEvent(eudaq::EventSP evsp, eudaq::ConfigurationSPC conf) {
+  auto stdev = std::dynamic_pointer_cast<eudaq::StandardEvent>(evsp);
+  if(!stdev){
+    stdev = eudaq::StandardEvent::MakeShared();
+    eudaq::StdEventConverter::Convert(evsp, stdev, conf);
+  }
+  return stdev;
+}
+
+// the planes which are analysed
+static uint32_t CountPlanes(const eudaq::StandardEvent &stdev) {
+  uint32_t n = 0;
+  for(size_t i = 0; i < stdev.NumPlanes(); i++)
+    if(stdev.GetPlane(i).Sensor() != "FORTIS")
+      n++;
+  return n;
+}
+
 RootMonitor::RootMonitor(const std::string & runcontrol,
 			 int /*x*/, int /*y*/, int /*w*/, int /*h*/,
 			 const std::string & conffile, const std::string & monname)
@@ -104,16 +157,18 @@ RootMonitor::RootMonitor(const std::string & runcontrol,
 
   //set a few defaults
   snapshotdir=mon_configdata.getSnapShotDir();
-  previous_event_analysis_time=0;
   previous_event_fill_time=0;
-  previous_event_clustering_time=0;
   previous_event_correlation_time=0;
+  previous_event_correlation_pairs=0;
+  previous_event_correlation_sampling=1;
+  m_ana_threads = 1;
 
   onlinemon->SetOnlineMon(this);    
 
 }
 
 RootMonitor::~RootMonitor(){
+  StopAnalysis();
   gApplication->Terminate();
 }
 
@@ -165,41 +220,54 @@ void RootMonitor::DoTerminate(){
   gApplication->Terminate();
 }  
 
+void RootMonitor::setAnalysisThreads(const unsigned int n) {
+  m_ana_threads = n;
+}
+
 void RootMonitor::DoReceive(eudaq::EventSP evsp) {
   if(evsp->GetEventN() > 10 && evsp->GetEventN() % onlinemon->getReduce() != 0){
     return;
   }
-  
-  auto stdev = std::dynamic_pointer_cast<eudaq::StandardEvent>(evsp);
-  if(!stdev){
-    stdev = eudaq::StandardEvent::MakeShared();
-    eudaq::StdEventConverter::Convert(evsp, stdev, eu_cfgPtr);
-  }
-  
-  uint32_t ev_plane_c = stdev->NumPlanes();
+
+  // the first events only tell the number of planes to expect, they are not analysed
   if(m_ev_rec_n < 10){
     m_ev_rec_n ++;
-    if(ev_plane_c > m_plane_c){
-      m_plane_c = ev_plane_c;
-    }
+    m_plane_c = std::max(m_plane_c, CountPlanes(*ToStandardEvent(evsp, eu_cfgPtr)));
     return;
   }
 
-  if(ev_plane_c != m_plane_c){
-    std::cout<< "Event #"<< evsp->GetEventN()<< " has "<<ev_plane_c<<" plane(s), while we expect "<< m_plane_c <<" plane(s).  (Event is skipped)" <<std::endl;
+  if(!_planesInitialized){
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+      _planesInitialized = true;
+  }
+
+  auto pool = std::atomic_load(&m_pool);
+  if(pool){
+    std::unique_lock<std::mutex> lk(pool->mtx);
+    pool->cv_space.wait(lk, [&pool]{return pool->submit_n - pool->FilledN() < pool->depth || pool->exit;});
+    // the run is being stopped
+    if(pool->exit)
+      return;
+    pool->in.emplace_back(pool->submit_n++, evsp);
+    pool->cv_in.notify_one();
     return;
   }
-    
-  my_event_processing_time.Start(true);
+
+  SimpleStandardEvent simpEv;
+  AnalyseEvent(evsp, simpEv);
+  if(CheckPlanes(simpEv))
+    FillEvent(simpEv, _colls);
+}
+
+void RootMonitor::AnalyseEvent(eudaq::EventSP evsp, SimpleStandardEvent &simpEv) {
+  TStopwatch analysis_time;
+  TStopwatch clustering_time;
+  analysis_time.Start(true);
+
+  auto stdev = ToStandardEvent(evsp, eu_cfgPtr);
 
   uint32_t num = stdev->NumPlanes();
 
-  SimpleStandardEvent simpEv;
-  // store the processing time of the previous EVENT, as we can't track this during the  processing
-  simpEv.setMonitor_eventanalysistime(previous_event_analysis_time);
-  simpEv.setMonitor_eventfilltime(previous_event_fill_time);
-  simpEv.setMonitor_eventclusteringtime(previous_event_clustering_time);
-  simpEv.setMonitor_eventcorrelationtime(previous_event_correlation_time);
   // add some info into the simple event header
   simpEv.setEvent_number(stdev->GetEventNumber());
   simpEv.setEvent_timestamp(stdev->GetTimestampBegin());
@@ -258,24 +326,39 @@ void RootMonitor::DoReceive(eudaq::EventSP evsp) {
     }
     simpEv.addPlane(simpPlane);
   }
-  my_event_inner_operations_time.Start(true);
+  clustering_time.Start(true);
   simpEv.doClustering();
-  my_event_inner_operations_time.Stop();
-  previous_event_clustering_time = my_event_inner_operations_time.RealTime();
+  clustering_time.Stop();
 
-  if(!_planesInitialized){
-      std::this_thread::sleep_for(std::chrono::seconds(1));
-      _planesInitialized = true;
+  analysis_time.Stop();
+  simpEv.setMonitor_eventanalysistime(analysis_time.RealTime());
+  simpEv.setMonitor_eventclusteringtime(clustering_time.RealTime());
+}
+
+bool RootMonitor::CheckPlanes(const SimpleStandardEvent &simpEv) const {
+  uint32_t ev_plane_c = simpEv.getNPlanes();
+  if(ev_plane_c != m_plane_c){
+    std::cout<< "Event #"<< simpEv.getEvent_number()<< " has "<<ev_plane_c<<" plane(s), while we expect "<< m_plane_c <<" plane(s).  (Event is skipped)" <<std::endl;
+    return false;
+  }
+  return true;
+}
+
+void RootMonitor::FillEvent(SimpleStandardEvent &simpEv, const std::vector<BaseCollection *> &colls) {
+  bool has_corr = std::find(colls.begin(), colls.end(), corrCollection) != colls.end();
+  if(has_corr){
+    // store the processing time of the previous EVENT, as we can't track this during the  processing
+    simpEv.setMonitor_eventfilltime(previous_event_fill_time);
+    simpEv.setMonitor_eventcorrelationtime(previous_event_correlation_time);
+    simpEv.setMonitor_correlationpairs(previous_event_correlation_pairs);
+    simpEv.setMonitor_correlationsampling(previous_event_correlation_sampling);
+    my_event_processing_time.Start(true); //start the stopwatch
   }
 
-  //stop the Stop watch
-  my_event_processing_time.Stop();
-  previous_event_analysis_time=my_event_processing_time.RealTime();
   //Filling
-  my_event_processing_time.Start(true); //start the stopwatch again
-  for (unsigned int i = 0 ; i < _colls.size(); ++i)
+  for (unsigned int i = 0 ; i < colls.size(); ++i)
     {
-      if (_colls.at(i) == corrCollection)
+      if (colls.at(i) == corrCollection)
         {
           my_event_inner_operations_time.Start(true);
           if (getUseTrack_corr() == true)
@@ -285,25 +368,125 @@ void RootMonitor::DoReceive(eudaq::EventSP evsp) {
                 eudaqCollection->getEUDAQMonitorHistos()->Fill(simpEv.getEvent_number(), tracksPerEvent);
             }
           else
-            _colls.at(i)->Fill(simpEv);
+            colls.at(i)->Fill(simpEv);
           my_event_inner_operations_time.Stop();
           previous_event_correlation_time = my_event_inner_operations_time.RealTime();
+          previous_event_correlation_pairs = corrCollection->getLastPairs();
+          previous_event_correlation_sampling = corrCollection->getLastSampling();
         }
       else
-        _colls.at(i)->Fill(simpEv);
+        colls.at(i)->Fill(simpEv);
 
       // CollType is used to check which kind of Collection we are having
-      if (_colls.at(i)->getCollectionType()==HITMAP_COLLECTION_TYPE) // Calculate is only implemented for HitMapCollections
+      if (colls.at(i)->getCollectionType()==HITMAP_COLLECTION_TYPE) // Calculate is only implemented for HitMapCollections
         {
-          _colls.at(i)->Calculate(stdev->GetEventNumber());
+          colls.at(i)->Calculate(simpEv.getEvent_number());
         }
     }
 
-  onlinemon->setEventNumber(stdev->GetEventNumber());
-  onlinemon->increaseAnalysedEventsCounter();
-    
-  my_event_processing_time.Stop();
-  previous_event_fill_time=my_event_processing_time.RealTime();
+  if(has_corr){
+    onlinemon->setEventNumber(simpEv.getEvent_number());
+    onlinemon->increaseAnalysedEventsCounter();
+
+    my_event_processing_time.Stop();
+    previous_event_fill_time=my_event_processing_time.RealTime();
+  }
+}
+
+void RootMonitor::StartAnalysis() {
+  StopAnalysis();
+  if(m_ana_threads < 2)
+    return;
+  // the histograms are booked by several filling threads
+  ROOT::EnableThreadSafety();
+  auto pool = std::make_shared<AnalysisPool>();
+  pool->depth = 16 * m_ana_threads;
+  // each filling thread has its own collections, the per plane ones on one,
+  // the correlation with the EUDAQ monitor it fills and the performance
+  // monitor reading its timing on the other
+  for(int i = 0; i < 2; i++)
+    pool->lanes.emplace_back(new AnalysisPool::Lane);
+  for(auto coll: _colls){
+    bool plane = coll == hmCollection || coll == paraCollection;
+    pool->lanes[plane ? 1 : 0]->colls.push_back(coll);
+  }
+  for(unsigned int i = 0; i < m_ana_threads; i++)
+    pool->fut_ana.push_back(std::async(std::launch::async, &RootMonitor::Analysing, this, pool.get()));
+  for(size_t i = 0; i < pool->lanes.size(); i++)
+    pool->lanes[i]->fut = std::async(std::launch::async, &RootMonitor::Filling, this, pool.get(), i);
+  std::atomic_store(&m_pool, pool);
+}
+
+void RootMonitor::StopAnalysis() {
+  auto pool = std::atomic_exchange(&m_pool, std::shared_ptr<AnalysisPool>());
+  if(!pool)
+    return;
+  std::unique_lock<std::mutex> lk(pool->mtx);
+  pool->exit = true;
+  pool->cv_in.notify_all();
+  pool->cv_out.notify_all();
+  pool->cv_space.notify_all();
+  lk.unlock();
+  // the submitted events are analysed and filled before the threads return
+  for(auto &fut: pool->fut_ana)
+    fut.get();
+  for(auto &lane: pool->lanes)
+    lane->fut.get();
+}
+
+void RootMonitor::Analysing(AnalysisPool *pool) {
+  while(1){
+    std::unique_lock<std::mutex> lk(pool->mtx);
+    pool->cv_in.wait(lk, [pool]{return !pool->in.empty() || pool->exit;});
+    if(pool->in.empty())
+      return;
+    auto item = pool->in.front();
+    pool->in.pop_front();
+    lk.unlock();
+    std::shared_ptr<SimpleStandardEvent> simpEv(new SimpleStandardEvent);
+    try{
+      AnalyseEvent(item.second, *simpEv);
+      if(!CheckPlanes(*simpEv))
+	simpEv.reset();
+    }
+    catch(const std::exception &e){
+      EUDAQ_ERROR("OnlineMon:: analysis of Event #" + std::to_string(item.second->GetEventN())
+		  + " failed: " + e.what());
+      simpEv.reset();
+    }
+    lk.lock();
+    for(auto &lane: pool->lanes)
+      lane->out[item.first] = simpEv;
+    pool->cv_out.notify_all();
+  }
+}
+
+void RootMonitor::Filling(AnalysisPool *pool, size_t lane_i) {
+  AnalysisPool::Lane &lane = *pool->lanes[lane_i];
+  while(1){
+    std::unique_lock<std::mutex> lk(pool->mtx);
+    pool->cv_out.wait(lk, [pool, &lane]{return lane.out.count(lane.fill_n) ||
+	  (pool->exit && lane.fill_n == pool->submit_n);});
+    auto it = lane.out.find(lane.fill_n);
+    if(it == lane.out.end())
+      return;
+    auto simpEv = std::move(it->second);
+    lane.out.erase(it);
+    lk.unlock();
+    if(simpEv){
+      //a failed Event must not stop the filling of the following ones
+      try{
+	FillEvent(*simpEv, lane.colls);
+      }
+      catch(const std::exception &e){
+	EUDAQ_ERROR("OnlineMon:: filling of Event #" + std::to_string(simpEv->getEvent_number())
+		    + " failed: " + e.what());
+      }
+    }
+    lk.lock();
+    lane.fill_n++;
+    pool->cv_space.notify_one();
+  }
 }
 
 void RootMonitor::autoReset(const bool reset) {
@@ -312,6 +495,7 @@ void RootMonitor::autoReset(const bool reset) {
 
 void RootMonitor::DoStopRun()
 {
+  StopAnalysis();
   m_plane_c = 0;
   m_ev_rec_n = 0;
 
@@ -351,6 +535,7 @@ void RootMonitor::DoStartRun() {
 
   // Reset the planes initializer on new run start:
   _planesInitialized = false;
+  StartAnalysis();
 }
 
 void RootMonitor::setUpdate(const unsigned int up) {
@@ -400,6 +585,7 @@ int main(int argc, const char ** argv) {
   eudaq::Option<std::string> level(op, "l", "log-level", "NONE", "level",
       "The minimum level for displaying log messages locally");
   eudaq::Option<int>             reduce(op, "rd", "reduce",  1, "Reduce the number of events");
+  eudaq::Option<unsigned>        ana_threads(op, "j", "threads",  1, "Number of threads converting and clustering events, filled in order by two more threads if above 1");
   eudaq::Option<unsigned>        corr_width(op, "cw", "corr_width",500, "Width of the track correlation window");
   eudaq::Option<unsigned>        corr_planes(op, "cp", "corr_planes",  5, "Minimum amount of planes for track reconstruction in the correlation");
   eudaq::Option<bool>            track_corr(op, "tc", "track_correlation", false, "Using (EXPERIMENTAL) track correlation(true) or cluster correlation(false)");
@@ -436,6 +622,7 @@ int main(int argc, const char ** argv) {
   mon.setWriteRoot(do_rootatend.IsSet());
   mon.autoReset(do_resetatend.IsSet());
   mon.setReduce(reduce.Value());
+  mon.setAnalysisThreads(ana_threads.Value());
   mon.setUpdate(update.Value());
   mon.setCorr_width(corr_width.Value());
   mon.setCorr_planes(corr_planes.Value());
@@ -150,6 +150,16 @@ int OnlineMonConfiguration::ReadConfigurationFile() {
           if (correl_minclustersize <= 0) {
             cerr << " Warning Illegal Clustersize used " << endl;
           }
+        } else if (key.compare("Window") == 0) {
+          correl_window = StringToNumber<int>(value);
+          if (correl_window < 0) {
+            cerr << " Warning Illegal Window used " << endl;
+          }
+        } else if (key.compare("MaxPairs") == 0) {
+          correl_maxpairs = StringToNumber<int>(value);
+          if (correl_maxpairs < 0) {
+            cerr << " Warning Illegal MaxPairs used " << endl;
+          }
         } else if (key.compare("DisablePlanes") == 0) {
           vector<string> v;
           stringsplit(value, ',', v);
@@ -174,6 +184,18 @@ int OnlineMonConfiguration::ReadConfigurationFile() {
         }
 
       } else if (is_section_clusterizer) {
+        if (key.compare("Algorithm") == 0) {
+          value = remove_this_character(value, '"');
+          if (value.compare("Scanline") == 0) {
+            cluster_algorithm = CLUSTER_SCANLINE;
+          } else if (value.compare("Pairwise") == 0) {
+            cluster_algorithm = CLUSTER_PAIRWISE;
+          } else {
+            cerr << " Warning Illegal Algorithm used " << endl;
+          }
+        } else {
+          cerr << "Unknown Key " << key << endl;
+        }
 
       } else if (is_section_mimosa26) {
         if (key.compare("Mimosa26_max_sections") == 0) {
@@ -216,6 +238,11 @@ void OnlineMonConfiguration::SetDefaults() {
 
   // correl cluster settings
   correl_minclustersize = 1;
+  correl_window = 0;
+  correl_maxpairs = 0;
+
+  // clusterizer settings
+  cluster_algorithm = CLUSTER_SCANLINE;
 }
 
 void OnlineMonConfiguration::setSnapShotDir(string SnapShotDir) {
@@ -246,6 +273,30 @@ void OnlineMonConfiguration::setCorrel_minclustersize(
   this->correl_minclustersize = correl_minclustersize;
 }
 
+int OnlineMonConfiguration::getCorrel_window() const {
+  return correl_window;
+}
+
+void OnlineMonConfiguration::setCorrel_window(int correl_window) {
+  this->correl_window = correl_window;
+}
+
+int OnlineMonConfiguration::getCorrel_maxpairs() const {
+  return correl_maxpairs;
+}
+
+void OnlineMonConfiguration::setCorrel_maxpairs(int correl_maxpairs) {
+  this->correl_maxpairs = correl_maxpairs;
+}
+
+int OnlineMonConfiguration::getCluster_algorithm() const {
+  return cluster_algorithm;
+}
+
+void OnlineMonConfiguration::setCluster_algorithm(int cluster_algorithm) {
+  this->cluster_algorithm = cluster_algorithm;
+}
+
 string OnlineMonConfiguration::getSnapShotFormat() const {
   return SnapShotFormat;
 }
@@ -265,12 +316,17 @@ void OnlineMonConfiguration::PrintConfiguration() {
   cout << endl;
   cout << "Correlation Settings" << endl;
   cout << "MinClusterSize      : " << correl_minclustersize << endl;
+  cout << "Window              : " << correl_window << endl;
+  cout << "MaxPairs            : " << correl_maxpairs << endl;
   cout << "Planes to skip      : ";
   for (unsigned int i = 0; i < planes_to_be_skipped.size(); i++) {
     cout << planes_to_be_skipped[i] << " ";
   }
   cout << endl;
   cout << "Clusterizer Settings" << endl;
+  cout << "Algorithm           : "
+       << (cluster_algorithm == CLUSTER_PAIRWISE ? "Pairwise" : "Scanline")
+       << endl;
   cout << "HotPixelFinder Settings" << endl;
   cout << "HotPixelCut         : " << hotpixelcut << endl;
   cout << endl;
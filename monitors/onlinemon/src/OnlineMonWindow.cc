@@ -267,6 +267,7 @@ void OnlineMonWindow::About() {
 }
 
 void OnlineMonWindow::registerTreeItem(std::string item) {
+  std::lock_guard<std::recursive_mutex> lck(_mu_register);
   if (item.find("/") == std::string::npos) { // Yes
     _treeMap[item] = LTr_left->AddItem(NULL, item.c_str());
     _treeBackMap[_treeMap[item]] = item;
@@ -286,6 +287,7 @@ void OnlineMonWindow::registerTreeItem(std::string item) {
 }
 
 void OnlineMonWindow::makeTreeItemSummary(std::string item) {
+  std::lock_guard<std::recursive_mutex> lck(_mu_register);
   std::map<std::string, TNamed *>::iterator it;
   std::vector<std::string> v;
   for (it = _hitmapMap.begin(); it != _hitmapMap.end(); ++it) {
@@ -299,6 +301,7 @@ void OnlineMonWindow::makeTreeItemSummary(std::string item) {
 
 void OnlineMonWindow::addTreeItemSummary(std::string item,
                                          std::string histoitem) {
+  std::lock_guard<std::recursive_mutex> lck(_mu_register);
 
   std::vector<std::string> v;
   std::map<std::string, std::string>::iterator it;
@@ -311,6 +314,7 @@ void OnlineMonWindow::addTreeItemSummary(std::string item,
 
 void OnlineMonWindow::registerHisto(std::string tree, TNamed *h, std::string op,
                                     const unsigned int l) {
+  std::lock_guard<std::recursive_mutex> lck(_mu_register);
   if (h == NULL) // check if valid histogram
   {
     cout << "OnlineMonWindow::registerHisto Null pointer for entry " << op
@@ -333,6 +337,7 @@ void OnlineMonWindow::registerHisto(std::string tree, TNamed *h, std::string op,
 }
 
 void OnlineMonWindow::registerMutex(std::string tree, std::mutex *m){
+  std::lock_guard<std::recursive_mutex> lck(_mu_register);
   _mutexMap[tree] = m;
 }
 
@@ -13,6 +13,8 @@ SimpleStandardEvent::SimpleStandardEvent() {
   monitor_eventanalysistime = 0;
   monitor_clusteringtime = 0;
   monitor_correlationtime = 0;
+  monitor_correlationpairs = 0;
+  monitor_correlationsampling = 1;
   event_number = 0;
   event_timestamp = 0;
 }
@@ -44,6 +46,14 @@ double SimpleStandardEvent::getMonitor_correlationtime() const {
   return monitor_correlationtime;
 }
 
+unsigned int SimpleStandardEvent::getMonitor_correlationpairs() const {
+  return monitor_correlationpairs;
+}
+
+double SimpleStandardEvent::getMonitor_correlationsampling() const {
+  return monitor_correlationsampling;
+}
+
 void SimpleStandardEvent::setMonitor_eventanalysistime(
     double monitor_eventanalysistime) {
   this->monitor_eventanalysistime = monitor_eventanalysistime;
@@ -64,6 +74,16 @@ void SimpleStandardEvent::setMonitor_eventcorrelationtime(
   this->monitor_correlationtime = monitor_correlationtime;
 }
 
+void SimpleStandardEvent::setMonitor_correlationpairs(
+    unsigned int monitor_correlationpairs) {
+  this->monitor_correlationpairs = monitor_correlationpairs;
+}
+
+void SimpleStandardEvent::setMonitor_correlationsampling(
+    double monitor_correlationsampling) {
+  this->monitor_correlationsampling = monitor_correlationsampling;
+}
+
 void SimpleStandardEvent::doClustering() {
   for (int plane = 0; plane < getNPlanes(); plane++) {
     _planes.at(plane).doClustering();
@@ -100,8 +100,38 @@ void SimpleStandardPlane::reducePixels(const int reduceX, const int reduceY) {
 }
 
 void SimpleStandardPlane::doClustering() {
-  int nClusters = 0;
   std::vector<int> clusterNumber;
+
+  // which planes to cluster, reject planes of Type Fortis
+  if (is_FORTIS) {
+    return;
+  }
+
+  if (mon != NULL &&
+      mon->getCluster_algorithm() == OnlineMonConfiguration::CLUSTER_PAIRWISE) {
+    labelHitsPairwise(clusterNumber);
+  } else {
+    labelHitsScanline(clusterNumber);
+  }
+  fillClusters(clusterNumber);
+
+  // if we have a mimosa, we need to fill the section information
+
+  if (is_MIMOSA26) {
+    for (unsigned int mycluster = 0; mycluster < _clusters.size();
+         mycluster++) {
+      unsigned int cluster_section =
+          _clusters[mycluster].getX() / mon->getMimosa26_section_boundary();
+      if (cluster_section < mon->getMimosa26_max_sections()) // fixme
+      {
+        _section_clusters[cluster_section].push_back(_clusters[mycluster]);
+      }
+    }
+  }
+}
+
+void SimpleStandardPlane::labelHitsPairwise(std::vector<int> &clusterNumber) {
+  int nClusters = 0;
   const int NOCLUSTER = -1000;
   const unsigned int minXDistance = 1;
   const unsigned int minYDistance = 1;
@@ -109,11 +139,6 @@ void SimpleStandardPlane::doClustering() {
   bool continue_flag;
   clusterNumber.assign(npixels_hit, NOCLUSTER);
 
-  // which planes to cluster, reject planes of Type Fortis
-  if (is_FORTIS) {
-    return;
-  }
-
   if (npixels_hit > 1) // (npixels_hit < 2000 ))
   {
     std::sort(_hits.begin(), _hits.end(), SortHitsByXY());
@@ -166,36 +191,88 @@ void SimpleStandardPlane::doClustering() {
     if (npixels_hit == 1)
       clusterNumber.at(0) = 1;
   }
+}
 
-  std::set<int> clusterSet(clusterNumber.begin(), clusterNumber.end());
-
-  nClusters = clusterSet.size();
+// Connected components of the 8-neighbourhood: the hits are sorted by column
+// and row, each hit is joined with its neighbours in the previous column and
+// with the previous hit of its own column, using union-find.
+void SimpleStandardPlane::labelHitsScanline(std::vector<int> &clusterNumber) {
+  const int npixels_hit = _hits.size();
+  clusterNumber.resize(npixels_hit);
+  for (int i = 0; i < npixels_hit; i++) {
+    clusterNumber[i] = i;
+  }
+  if (npixels_hit < 2) {
+    return;
+  }
+  std::sort(_hits.begin(), _hits.end(), SortHitsByXY());
 
-  std::set<int>::iterator it;
-  for (it = clusterSet.begin(); it != clusterSet.end(); ++it) {
-    SimpleStandardCluster cluster;
-    for (unsigned int i = 0; i < npixels_hit; i++) {
-      if (clusterNumber.at(i) == *it) { // Put only these pixels in that
-                                        // ClusterCollection that belong to that
-                                        // cluster
-        cluster.addPixel(_hits.at(i));
+  int prev_begin = 0; // hits of the previous column, if adjacent
+  int prev_end = 0;
+  int col_begin = 0; // first hit of the current column
+  int prev = 0;
+  for (int i = 0; i < npixels_hit; i++) {
+    const int x = _hits[i].getX();
+    const int y = _hits[i].getY();
+    if (i == 0 || x != _hits[i - 1].getX()) {
+      if (i > 0 && _hits[i - 1].getX() == x - 1) {
+        prev_begin = col_begin;
+        prev_end = i;
+      } else {
+        prev_begin = i;
+        prev_end = i;
       }
+      col_begin = i;
+      prev = prev_begin;
+    } else if (_hits[i - 1].getY() >= y - 1) {
+      joinClusters(clusterNumber, i, i - 1);
+    }
+    while (prev < prev_end && _hits[prev].getY() < y - 1) {
+      prev++;
+    }
+    for (int j = prev; j < prev_end && _hits[j].getY() <= y + 1; j++) {
+      joinClusters(clusterNumber, i, j);
     }
-    _clusters.push_back(cluster);
   }
-  // if we have a mimosa, we need to fill the section information
+  for (int i = 0; i < npixels_hit; i++) {
+    clusterNumber[i] = findCluster(clusterNumber, i);
+  }
+}
 
-  if (is_MIMOSA26) {
-    for (unsigned int mycluster = 0; mycluster < _clusters.size();
-         mycluster++) {
-      unsigned int cluster_section =
-          _clusters[mycluster].getX() / mon->getMimosa26_section_boundary();
-      if (cluster_section < mon->getMimosa26_max_sections()) // fixme
-      {
-        _section_clusters[cluster_section].push_back(_clusters[mycluster]);
-      }
+int SimpleStandardPlane::findCluster(std::vector<int> &clusterNumber, int i) {
+  while (clusterNumber[i] != i) {
+    clusterNumber[i] = clusterNumber[clusterNumber[i]]; // path halving
+    i = clusterNumber[i];
+  }
+  return i;
+}
+
+void SimpleStandardPlane::joinClusters(std::vector<int> &clusterNumber, int a,
+                                       int b) {
+  a = findCluster(clusterNumber, a);
+  b = findCluster(clusterNumber, b);
+  if (a != b) {
+    clusterNumber[std::max(a, b)] = std::min(a, b);
+  }
+}
+
+void SimpleStandardPlane::fillClusters(const std::vector<int> &clusterNumber) {
+  // cluster numbers are within [0, number of hits], clusters are ordered by
+  // their number
+  std::vector<int> index(clusterNumber.size() + 1, -1);
+  for (size_t i = 0; i < clusterNumber.size(); i++) {
+    index.at(clusterNumber[i]) = 0;
+  }
+  int nClusters = _clusters.size();
+  for (size_t n = 0; n < index.size(); n++) {
+    if (index[n] == 0) {
+      index[n] = nClusters++;
     }
   }
+  _clusters.resize(nClusters);
+  for (size_t i = 0; i < clusterNumber.size(); i++) {
+    _clusters[index[clusterNumber[i]]].addPixel(_hits[i]);
+  }
 }
 
 void SimpleStandardPlane::setPixelType(std::string name) {
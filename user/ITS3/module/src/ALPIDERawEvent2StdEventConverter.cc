@@ -5,14 +5,15 @@
 
 class ALPIDERawEvent2StdEventConverter:public eudaq::StdEventConverter{
 public:
+  ALPIDERawEvent2StdEventConverter();
   bool Converting(eudaq::EventSPC rawev,eudaq::StdEventSP stdev,eudaq::ConfigSPC conf_) const override;
+  void Initialise(eudaq::ConfigSPC conf_) override;
 private:
-  void Dump(const std::vector<uint8_t> &data,size_t i) const;
+  void Dump(const eudaq::BlockView &data,size_t i) const;
   struct Config {
     int device_n;
   };
-  Config& LoadConf(eudaq::ConfigSPC config_) const;
-  static std::map<eudaq::ConfigSPC,Config> confs;
+  Config m_conf;
 };
 
 #define REGISTER_CONVERTER(name) namespace{auto dummy##name=eudaq::Factory<eudaq::StdEventConverter>::Register<ALPIDERawEvent2StdEventConverter>(eudaq::cstr2hash(#name));}
@@ -37,8 +38,11 @@ REGISTER_CONVERTER(ALPIDE_plane_17)
 REGISTER_CONVERTER(ALPIDE_plane_18)
 REGISTER_CONVERTER(ALPIDE_plane_19)
 
-ALPIDERawEvent2StdEventConverter::Config& ALPIDERawEvent2StdEventConverter::LoadConf(eudaq::ConfigSPC conf_) const {
-  if(confs.find(conf_)!=confs.end()) return confs[conf_];
+ALPIDERawEvent2StdEventConverter::ALPIDERawEvent2StdEventConverter() {
+  m_conf.device_n = -1; // decode all fallback (used in online monitor)
+}
+
+void ALPIDERawEvent2StdEventConverter::Initialise(eudaq::ConfigSPC conf_) {
   EUDAQ_DEBUG("Load configuration for ALPIDE");
   Config conf;
   conf.device_n = -1; // decode all fallback (used in online monitor)
@@ -56,17 +60,14 @@ ALPIDERawEvent2StdEventConverter::Config& ALPIDERawEvent2StdEventConverter::Load
       EUDAQ_DEBUG(" set device number `"+id+"` from Corryvreckan");
     }
   }
-  confs[conf_]=std::move(conf);
-  return confs[conf_];
+  m_conf=conf;
 }
 
-std::map<eudaq::ConfigSPC,ALPIDERawEvent2StdEventConverter::Config> ALPIDERawEvent2StdEventConverter::confs;
-
-bool ALPIDERawEvent2StdEventConverter::Converting(eudaq::EventSPC in,eudaq::StdEventSP out,eudaq::ConfigSPC conf_) const{
-  Config &conf=LoadConf(conf_);
+bool ALPIDERawEvent2StdEventConverter::Converting(eudaq::EventSPC in,eudaq::StdEventSP out,eudaq::ConfigSPC /*conf*/) const{
+  const Config &conf=m_conf;
   if(conf.device_n==-2) return false; // Corry event loader is looking for another plane
   auto rawev=std::dynamic_pointer_cast<const eudaq::RawEvent>(in);
-  std::vector<uint8_t> data=rawev->GetBlock(0); // FIXME: copy?
+  eudaq::BlockView data=rawev->GetBlockView(0);
   if(conf.device_n>=0 && conf.device_n!=rawev->GetDeviceN()) return false;
   eudaq::StandardPlane plane(rawev->GetDeviceN(),"ITS3DAQ","ALPIDE");
   plane.SetSizeZS(1024,512,0,1); // 0 hits so far + 1 frame
@@ -152,7 +153,7 @@ bool ALPIDERawEvent2StdEventConverter::Converting(eudaq::EventSPC in,eudaq::StdE
   return true;
 }
 
-void ALPIDERawEvent2StdEventConverter::Dump(const std::vector<uint8_t> &data,size_t i) const {
+void ALPIDERawEvent2StdEventConverter::Dump(const eudaq::BlockView &data,size_t i) const {
   char buf[100];
   EUDAQ_WARN("Raw event dump:");
   for (size_t j=0;j<data.size();++j) {
@@ -142,7 +142,7 @@ bool APTSRawEvent2StdEventConverter::Converting(eudaq::EventSPC in,eudaq::StdEve
   auto rawev=std::dynamic_pointer_cast<const eudaq::RawEvent>(in);
   if(conf.device_n>=0 && conf.device_n!=rawev->GetDeviceN()) return false;
   if(rawev->GetNumBlock()==0) return false; // TODO: how/can this happen?
-  const std::vector<uint8_t> &block=rawev->GetBlock(0);// GET BLOCK OF DATA: one contains timestamp[1], one the data[0]
+  eudaq::BlockView block=rawev->GetBlockView(0);// GET BLOCK OF DATA: one contains timestamp[1], one the data[0]
   size_t n=block.size();
   if(n<frame_size_in_byte||n%frame_size_in_byte!=0) {  //check that block is multiple of frame_size_in_byte
     EUDAQ_ERROR("Error: Incomplete Data Block. Block size is "+std::to_string(n)+", but should be multiple of "+std::to_string(frame_size_in_byte));
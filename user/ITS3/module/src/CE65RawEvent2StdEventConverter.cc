@@ -76,7 +76,7 @@ short CE65RawEvent2StdEventConverter::DecodeFrameData(eudaq::EventSPC rawev, int
     PrintConfiguration();
   }
   for(int i = 0; i < rawev->GetNumBlock(); i++){
-    std::vector<uint8_t> data = rawev->GetBlock(i);
+    eudaq::BlockView data = rawev->GetBlockView(i);
     uint8_t byteB = data[pixelID * sizeof(short) + 1];
     uint8_t byteA = data[pixelID * sizeof(short)];
     frdata[i] = short((byteB<<8)+byteA);
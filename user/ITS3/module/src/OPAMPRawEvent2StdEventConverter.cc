@@ -386,7 +386,7 @@ bool OPAMPRawEvent2StdEventConverter::Converting(eudaq::EventSPC in,
   if(conf.device_n>=0 && conf.device_n!=rawev->GetDeviceN()) return false;
   if (rawev->GetNumBlock() != 4 && rawev->GetNumBlock() != 6 )
     return false; // TODO: how/can this happen?
-  const std::vector<uint8_t> &block = rawev->GetBlock(0);
+  eudaq::BlockView block = rawev->GetBlockView(0);
   size_t n = block.size();
   if (n < frame_size_in_byte || n % frame_size_in_byte != 0){  //check that block is multiple of 40
     EUDAQ_ERROR("Error: Incomplete Data Block. Block size is "+std::to_string(n)+", but should be multiple of 40");
@@ -20,7 +20,7 @@ bool AdeniumRawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::St
   if(nblocks!=1){
       EUDAQ_ERROR("Wrong number of blocks");
   }
-  auto block =  ev->GetBlock(0); // this are always 8 bits
+  auto block =  ev->GetBlockView(0); // this are always 8 bits
   //std::cout << "New event: ********************** "<< d1->GetTriggerN() << std::endl;
   for(uint bit = 0; bit < block.size();bit++){
     auto  word = eudaq::getlittleendian<uint8_t>(&block[0]+bit);
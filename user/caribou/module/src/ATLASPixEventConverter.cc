@@ -38,7 +38,7 @@ bool ATLASPixEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Stan
   }
 
   // Read file and load data
-  auto datablock = ev->GetBlock(0);
+  auto datablock = ev->GetBlockView(0);
   uint32_t datain;
   memcpy(&datain, &datablock[0], sizeof(uint32_t));
 
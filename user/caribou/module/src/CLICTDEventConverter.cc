@@ -42,7 +42,7 @@ bool CLICTDEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standa
     // New data format - timestamps and pixel data are combined in one data block
 
     // Block 0 contains all data, split it into timestamps and pixel data, returned as std::vector<uint8_t>
-    auto datablock = ev->GetBlock(0);
+    auto datablock = ev->GetBlockView(0);
     LOG(DEBUG) << "CLICTD frame with";
 
     // Number of timestamps: first word of data
@@ -81,12 +81,12 @@ bool CLICTDEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standa
     // Old data format - timestamps in block 0, pixel data in block 1
 
     // Block 0 is timestamps:
-    auto time = ev->GetBlock(0);
+    auto time = ev->GetBlockView(0);
     timestamps.resize(time.size() / sizeof(uint64_t));
     memcpy(&timestamps[0], &time[0],time.size());
 
     // Block 1 is pixel data:
-    auto tmp = ev->GetBlock(1);
+    auto tmp = ev->GetBlockView(1);
     rawdata.resize(tmp.size() / sizeof(unsigned int));
     memcpy(&rawdata[0], &tmp[0],tmp.size());
   } else {
@@ -44,7 +44,7 @@ bool H2MEvent2StdEventConverter::Converting(
 
     // contains all data, split it into timestamps and pixel data, returned as
     // std::vector<uint8_t>
-    auto datablock = ev->GetBlock(0);
+    auto datablock = ev->GetBlockView(0);
 
     // get number of words in datablock
     auto data_length = datablock.size();
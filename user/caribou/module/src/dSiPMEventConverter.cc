@@ -87,7 +87,7 @@ bool dSiPMEvent2StdEventConverter::Converting(
 
     // contains all data, split it into timestamps and pixel data, returned as
     // std::vector<uint8_t>
-    auto datablock = ev->GetBlock(0);
+    auto datablock = ev->GetBlockView(0);
 
     // get number of words in datablock
     auto data_length = datablock.size();
@@ -22,7 +22,7 @@ namespace eudaq {
     void GetMultiPlanes(eudaq::StandardEventSP d2, unsigned plane_id, pxar::Event *evt) const;
     static inline uint16_t roc_to_mod_row(uint8_t roc, uint16_t row);
     static inline uint16_t roc_to_mod_col(uint8_t roc, uint16_t col);
-    static std::vector<uint16_t> TransformRawData(const std::vector<unsigned char> &block);
+    static std::vector<uint16_t> TransformRawData(const eudaq::BlockView &block);
 
     static uint8_t m_roctype, m_tbmtype;
     static size_t m_planeid;
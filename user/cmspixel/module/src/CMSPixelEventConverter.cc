@@ -64,7 +64,7 @@ bool CMSPixelBaseConverter::Converting(eudaq::EventSPC d1, eudaq::StandardEventS
   }
 
   // Transform from EUDAQ data, add it to the datasource:
-  src.AddData(TransformRawData(in_raw->GetBlock(0)));
+  src.AddData(TransformRawData(in_raw->GetBlockView(0)));
   // ...and pull it out at the other end:
   pxar::Event *evt = Eventpump.Get();
 
@@ -155,7 +155,7 @@ inline uint16_t CMSPixelBaseConverter::roc_to_mod_col(uint8_t roc, uint16_t col)
     return ((16 - roc) * ROC_NUMCOLS - col - 1);
 };
 
-std::vector<uint16_t> CMSPixelBaseConverter::TransformRawData(const std::vector<unsigned char> &block) {
+std::vector<uint16_t> CMSPixelBaseConverter::TransformRawData(const eudaq::BlockView &block) {
 
   // Transform data of form char* to vector<int16_t>
   std::vector<uint16_t> rawData;
@@ -1,23 +1,33 @@
 #include "eudaq/DataCollector.hh"
-//#include "eudaq/Event.hh"
+#include "eudaq/TriggerEventBuilder.hh"
 
-//#include <deque>
-//#include <map>
-//#include <string>
+#include <mutex>
+#include <map>
 
 namespace eudaq {
   class EventIDSyncDataCollector:public DataCollector{
     public:
-      using DataCollector::DataCollector;
+      EventIDSyncDataCollector(const std::string &name,
+          const std::string &rc);
+      void DoConfigure() override;
       void DoStartRun() override;
+      void DoStopRun() override;
+      void DoStatus() override;
       void DoConnect(ConnectionSPC /*id*/) override;
       void DoDisconnect(ConnectionSPC /*id*/) override;
       void DoReceive(ConnectionSPC id, EventSP ev) override;
       static const uint32_t m_id_factory = eudaq::cstr2hash("EventIDSyncDataCollector");
 
     private:
-      std::map<std::string, std::deque<EventSPC>> m_que_event;
-      std::mutex m_mtx_map;
+      //the building state of each shard of the event numbers, the builder
+      //keys the events by their event numbers
+      struct Builder{
+        std::mutex mtx;
+        TriggerEventBuilder builder;
+        std::map<std::string, uint32_t> pdc_stream;
+      };
+      void BuildEvents(Builder &bd);
+      std::vector<std::unique_ptr<Builder>> m_builders;
   };
 
   namespace{
@@ -26,53 +36,107 @@ namespace eudaq {
       (EventIDSyncDataCollector::m_id_factory);
   }
 
+  EventIDSyncDataCollector::EventIDSyncDataCollector(const std::string &name,
+      const std::string &rc):
+    DataCollector(name, rc){
+      SetShardKey(SHARD_EVENT);
+      m_builders.emplace_back(new Builder);
+    }
+
+  void EventIDSyncDataCollector::DoConfigure(){
+    auto conf = GetConfiguration();
+    if(!conf)
+      return;
+    m_builders.clear();
+    for(uint32_t i = 0; i < GetShardN(); i++){
+      m_builders.emplace_back(new Builder);
+      m_builders.back()->builder.Configure(*conf);
+    }
+  }
+
   void EventIDSyncDataCollector::DoStartRun(){
-    std::unique_lock<std::mutex> lk(m_mtx_map);
-    for(auto &que :m_que_event){
-      que.second.clear();
+    for(auto &bd: m_builders){
+      std::unique_lock<std::mutex> lk(bd->mtx);
+      bd->builder.Reset();
     }
   }
 
+  void EventIDSyncDataCollector::DoStopRun(){
+    for(auto &bd: m_builders){
+      std::unique_lock<std::mutex> lk(bd->mtx);
+      bd->builder.Flush();
+      BuildEvents(*bd);
+    }
+  }
+
+  void EventIDSyncDataCollector::DoStatus(){
+    std::map<std::string, TriggerEventBuilder::StreamStatus> status;
+    uint64_t incomplete_n = 0;
+    uint64_t dropped_n = 0;
+    for(auto &bd: m_builders){
+      std::unique_lock<std::mutex> lk(bd->mtx);
+      TriggerEventBuilder::MergeStatus(status, bd->builder.GetStreamStatus());
+      incomplete_n += bd->builder.GetIncompleteN();
+      dropped_n += bd->builder.GetDroppedN();
+    }
+    for(auto &e: status){
+      SetStatusTag("BuildLag." + e.first, TriggerEventBuilder::FormatLag(e.second.lag));
+      SetStatusTag("BuildLateN." + e.first, std::to_string(e.second.late_n));
+    }
+    SetStatusTag("BuildIncompleteN", std::to_string(incomplete_n));
+    SetStatusTag("BuildDroppedN", std::to_string(dropped_n));
+  }
+
   void EventIDSyncDataCollector::DoConnect(ConnectionSPC id){
-    std::unique_lock<std::mutex> lk(m_mtx_map);
+    Builder &bd = *m_builders.at(GetShard());
+    std::unique_lock<std::mutex> lk(bd.mtx);
     std::string pdc_name = id->GetName();
-    EUDAQ_INFO("Producer."+pdc_name+" is connecting");
-    if(m_que_event.find(pdc_name) != m_que_event.end())
+    if(!GetShard())
+      EUDAQ_INFO("Producer."+pdc_name+" is connecting");
+    if(bd.pdc_stream.find(pdc_name) != bd.pdc_stream.end())
       EUDAQ_THROW("DataCollector::Doconnect, multiple producers are sharing a same name");
-    m_que_event[pdc_name];
+    bd.pdc_stream[pdc_name] = bd.builder.AddStream(pdc_name);
   }
 
   void EventIDSyncDataCollector::DoDisconnect(ConnectionSPC id){
-    std::unique_lock<std::mutex> lk(m_mtx_map);
+    Builder &bd = *m_builders.at(GetShard());
+    std::unique_lock<std::mutex> lk(bd.mtx);
     std::string pdc_name = id->GetName();
-    if(m_que_event.find(pdc_name) == m_que_event.end())
+    auto it = bd.pdc_stream.find(pdc_name);
+    if(it == bd.pdc_stream.end())
       EUDAQ_THROW("DataCollector::DisDoconnect, the disconnecting producer was not existing in list");
-    EUDAQ_WARN("Producer."+pdc_name+" is disconnected, the remaining events are erased. ("+std::to_string(m_que_event[pdc_name].size())+ " Events)");
-    m_que_event.erase(pdc_name);
+    if(!GetShard())
+      EUDAQ_WARN("Producer."+pdc_name+" is disconnected, the pending events are built without it.");
+    bd.builder.CloseStream(it->second);
+    bd.pdc_stream.erase(it);
+    BuildEvents(bd);
   }
 
   void EventIDSyncDataCollector::DoReceive(ConnectionSPC id, EventSP ev){
-    std::unique_lock<std::mutex> lk(m_mtx_map);
-    std::string pdc_name = id->GetName();
-    m_que_event[pdc_name].push_back(std::move(ev));
-    uint32_t n = 0;
-    for(auto &que :m_que_event){
-      if(!que.second.empty())
-        n++;
-    }
-    if(n==m_que_event.size()){
+    Builder &bd = *m_builders.at(GetShard());
+    std::unique_lock<std::mutex> lk(bd.mtx);
+    auto it = bd.pdc_stream.find(id->GetName());
+    if(it == bd.pdc_stream.end())
+      EUDAQ_THROW("EventIDSyncDataCollector: event from an unknown producer");
+    uint32_t ev_n = ev->GetEventN();
+    bd.builder.Push(it->second, ev_n, std::move(ev));
+    BuildEvents(bd);
+  }
+
+  void EventIDSyncDataCollector::BuildEvents(Builder &bd){
+    TriggerEventBuilder::Built built;
+    while(bd.builder.Pop(built)){
       auto ev_wrap = Event::MakeUnique("EventIDSyncOnline");
       ev_wrap->SetFlagPacket();
-      uint32_t ev_c = m_que_event.begin()->second.front()->GetEventN();
-      bool match = true;
-      for(auto &que :m_que_event){
-        if(ev_c != que.second.front()->GetEventN())
-          match = false;
-        ev_wrap->AddSubEvent(que.second.front());
-        que.second.pop_front();
-      }
-      if(!match){
-        EUDAQ_WARN("EventNumbers are Mismatched");
+      for(auto &subev: built.evs)
+        ev_wrap->AddSubEvent(subev);
+      if(!built.complete){
+        std::string missing;
+        for(auto &name: built.missing)
+          missing += (missing.empty() ? "" : ",") + name;
+        EUDAQ_WARN("EventNumbers are Mismatched, event "+std::to_string(built.trigger_n)+" is missing from "+missing);
+        if(bd.builder.GetIncompletePolicy() == TriggerEventBuilder::INCOMPLETE_TAG)
+          ev_wrap->SetTag("EUDAQ_INCOMPLETE", missing);
       }
       WriteEvent(std::move(ev_wrap));
     }
@@ -20,8 +20,8 @@ namespace eudaq{
   static const int PIVOTPIXELOFFSET = 64;
 
   class NiRawEvent2LCEventConverter: public LCEventConverter{
-    typedef std::vector<unsigned char> datavect;
-    typedef std::vector<unsigned char>::const_iterator datait;
+    typedef eudaq::BlockView datavect;
+    typedef const unsigned char *datait;
 
   public:
     bool Converting(EventSPC d1, LCEventSP d2, ConfigurationSPC conf) const override;
@@ -114,21 +114,21 @@ namespace eudaq{
     static const std::vector<uint32_t> m_ids = {0, 1, 2, 3, 4, 5}; //TODO: make it a flexible number
     // If we get here it must be a data event
     const RawEvent &rawev = dynamic_cast<const RawEvent &>(source);
-    if (rawev.NumBlocks() < 2 || rawev.GetBlock(0).size() < 20 ||
-	rawev.GetBlock(1).size() < 20) {
+    if (rawev.NumBlocks() < 2 || rawev.GetBlockView(0).size() < 20 ||
+	rawev.GetBlockView(1).size() < 20) {
       EUDAQ_WARN("Ignoring bad event " + to_string(source.GetEventNumber()));
       return false;
     }
-    const datavect &data0 = rawev.GetBlock(0);
-    const datavect &data1 = rawev.GetBlock(1);
+    datavect data0 = rawev.GetBlockView(0);
+    datavect data1 = rawev.GetBlockView(1);
     unsigned header0 = GET(data0, 0);
     unsigned header1 = GET(data1, 0);
 
     unsigned tluid;;
-    if (rawev.NumBlocks() < 1 || rawev.GetBlock(0).size() < 8)
+    if (rawev.NumBlocks() < 1 || rawev.GetBlockView(0).size() < 8)
       tluid = (unsigned)-1;
     else
-      tluid = GET(rawev.GetBlock(0), 1) >> 16;
+      tluid = GET(rawev.GetBlockView(0), 1) >> 16;
 
     if (dbg)
       std::cout << "TLU id = " << hexdec(tluid, 4) << std::endl;
@@ -6,7 +6,7 @@
 #define PIVOTPIXELOFFSET 64
 
 class NiRawEvent2StdEventConverter: public eudaq::StdEventConverter{
-  typedef std::vector<uint8_t>::const_iterator datait;
+  typedef const uint8_t *datait;
 public:
   bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
   void DecodeFrame(eudaq::StandardPlane& plane, const uint32_t fm_n,
@@ -40,15 +40,15 @@ bool NiRawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standar
   }
 
   auto &rawev = *ev;
-  if (rawev.NumBlocks() < 2 || rawev.GetBlock(0).size() < 20 ||
-      rawev.GetBlock(1).size() < 20) {
+  if (rawev.NumBlocks() < 2 || rawev.GetBlockView(0).size() < 20 ||
+      rawev.GetBlockView(1).size() < 20) {
     EUDAQ_WARN("Ignoring bad event " + std::to_string(rawev.GetEventNumber()));
     return false;
   }
   auto use_all_hits = (conf != nullptr ? bool(conf->Get("use_all_hits",0)) : false);
 
-  const std::vector<uint8_t> &data0 = rawev.GetBlock(0);
-  const std::vector<uint8_t> &data1 = rawev.GetBlock(1);
+  eudaq::BlockView data0 = rawev.GetBlockView(0);
+  eudaq::BlockView data1 = rawev.GetBlockView(1);
   uint32_t header0 = eudaq::getlittleendian<uint32_t>(&data0[0]);
   uint32_t header1 = eudaq::getlittleendian<uint32_t>(&data1[0]);
   uint16_t pivot = eudaq::getlittleendian<uint16_t>(&data0[4]);
@@ -1,9 +1,8 @@
 #include "eudaq/DataCollector.hh"
+#include "eudaq/TriggerEventBuilder.hh"
 
-//#include <mutex>
-//#include <deque>
-//#include <map>
-#include <set>
+#include <mutex>
+#include <map>
 
 namespace eudaq {
   class TriggerIDSyncDataCollector:public DataCollector{
@@ -13,14 +12,22 @@ namespace eudaq {
       void DoConnect(ConnectionSPC id) override;
       void DoDisconnect(ConnectionSPC id) override;
       void DoConfigure() override;
+      void DoStartRun() override;
+      void DoStopRun() override;
       void DoReset() override;
+      void DoStatus() override;
       void DoReceive(ConnectionSPC id, EventSP ev) override;
       static const uint32_t m_id_factory = cstr2hash("TriggerIDSyncDataCollector");
 
     private:
-      std::mutex m_mtx_map;
-      std::map<ConnectionSPC, std::deque<EventSPC>> m_conn_evque;
-      std::set<ConnectionSPC> m_conn_inactive;
+      //the building state of each shard of the triggers
+      struct Builder{
+        std::mutex mtx;
+        TriggerEventBuilder builder;
+        std::map<ConnectionSPC, uint32_t> conn_stream;
+      };
+      void BuildEvents(Builder &bd);
+      std::vector<std::unique_ptr<Builder>> m_builders;
       uint32_t m_noprint;
   };
 
@@ -32,22 +39,26 @@ namespace eudaq {
 
   TriggerIDSyncDataCollector::TriggerIDSyncDataCollector(const std::string &name,
       const std::string &rc):
-    DataCollector(name, rc){
+    DataCollector(name, rc), m_noprint(0){
+      SetShardKey(SHARD_TRIGGER);
+      m_builders.emplace_back(new Builder);
     }
 
   void TriggerIDSyncDataCollector::DoConnect(ConnectionSPC idx){
-    std::unique_lock<std::mutex> lk(m_mtx_map);
-    m_conn_evque[idx].clear();
-    m_conn_inactive.erase(idx);
+    Builder &bd = *m_builders.at(GetShard());
+    std::unique_lock<std::mutex> lk(bd.mtx);
+    bd.conn_stream[idx] = bd.builder.AddStream(idx->GetName());
   }
 
   void TriggerIDSyncDataCollector::DoDisconnect(ConnectionSPC idx){
-    std::unique_lock<std::mutex> lk(m_mtx_map);
-    m_conn_inactive.insert(idx);
-    if(m_conn_inactive.size() == m_conn_evque.size()){
-      m_conn_inactive.clear();
-      m_conn_evque.clear();
-    }
+    Builder &bd = *m_builders.at(GetShard());
+    std::unique_lock<std::mutex> lk(bd.mtx);
+    auto it = bd.conn_stream.find(idx);
+    if(it == bd.conn_stream.end())
+      return;
+    bd.builder.CloseStream(it->second);
+    bd.conn_stream.erase(it);
+    BuildEvents(bd);
   }
 
   void TriggerIDSyncDataCollector::DoConfigure(){
@@ -56,60 +67,85 @@ namespace eudaq {
     if(conf){
       conf->Print();
       m_noprint = conf->Get("DISABLE_PRINT", 0);
+      m_builders.clear();
+      for(uint32_t i = 0; i < GetShardN(); i++){
+        m_builders.emplace_back(new Builder);
+        m_builders.back()->builder.Configure(*conf);
+      }
+    }
+  }
+
+  void TriggerIDSyncDataCollector::DoStartRun(){
+    for(auto &bd: m_builders){
+      std::unique_lock<std::mutex> lk(bd->mtx);
+      bd->builder.Reset();
+    }
+  }
+
+  void TriggerIDSyncDataCollector::DoStopRun(){
+    for(auto &bd: m_builders){
+      std::unique_lock<std::mutex> lk(bd->mtx);
+      bd->builder.Flush();
+      BuildEvents(*bd);
     }
   }
 
   void TriggerIDSyncDataCollector::DoReset(){
-    std::unique_lock<std::mutex> lk(m_mtx_map);
     m_noprint = 0;
-    m_conn_evque.clear();
-    m_conn_inactive.clear();
+    for(auto &bd: m_builders){
+      std::unique_lock<std::mutex> lk(bd->mtx);
+      bd->builder.Reset();
+    }
   }
 
-  void TriggerIDSyncDataCollector::DoReceive(ConnectionSPC idx, EventSP evsp){
-    std::unique_lock<std::mutex> lk(m_mtx_map);
-    if(!evsp->IsFlagTrigger()){
-      EUDAQ_THROW("!evsp->IsFlagTrigger()");
+  void TriggerIDSyncDataCollector::DoStatus(){
+    std::map<std::string, TriggerEventBuilder::StreamStatus> status;
+    uint64_t incomplete_n = 0;
+    uint64_t dropped_n = 0;
+    for(auto &bd: m_builders){
+      std::unique_lock<std::mutex> lk(bd->mtx);
+      TriggerEventBuilder::MergeStatus(status, bd->builder.GetStreamStatus());
+      incomplete_n += bd->builder.GetIncompleteN();
+      dropped_n += bd->builder.GetDroppedN();
     }
-    m_conn_evque[idx].push_back(evsp);
-
-    uint32_t trigger_n = -1;
-    for(auto &conn_evque: m_conn_evque){
-      if(conn_evque.second.empty())
-        return;
-      else{
-        uint32_t trigger_n_ev = conn_evque.second.front()->GetTriggerN();
-        if(trigger_n_ev< trigger_n)
-          trigger_n = trigger_n_ev;
-      }
+    for(auto &e: status){
+      SetStatusTag("BuildLag." + e.first, TriggerEventBuilder::FormatLag(e.second.lag));
+      SetStatusTag("BuildLateN." + e.first, std::to_string(e.second.late_n));
     }
+    SetStatusTag("BuildIncompleteN", std::to_string(incomplete_n));
+    SetStatusTag("BuildDroppedN", std::to_string(dropped_n));
+  }
 
-    auto ev_sync = Event::MakeUnique("TriggerIDSyncOnline");
-    ev_sync->SetFlagPacket();
-    ev_sync->SetTriggerN(trigger_n);
-    for(auto &conn_evque: m_conn_evque){
-      auto &ev_front = conn_evque.second.front(); 
-      if(ev_front->GetTriggerN() == trigger_n){
-        ev_sync->AddSubEvent(ev_front);
-        conn_evque.second.pop_front();
-      }
+  void TriggerIDSyncDataCollector::DoReceive(ConnectionSPC idx, EventSP evsp){
+    if(!evsp->IsFlagTrigger()){
+      EUDAQ_THROW("!evsp->IsFlagTrigger()");
     }
+    Builder &bd = *m_builders.at(GetShard());
+    std::unique_lock<std::mutex> lk(bd.mtx);
+    auto it = bd.conn_stream.find(idx);
+    if(it == bd.conn_stream.end())
+      EUDAQ_THROW("TriggerIDSyncDataCollector: event from an unknown connection");
+    bd.builder.Push(it->second, evsp->GetTriggerN(), evsp);
+    BuildEvents(bd);
+  }
 
-    if(!m_conn_inactive.empty()){
-      std::set<ConnectionSPC> conn_inactive_empty;
-      for(auto &conn: m_conn_inactive){
-        if(m_conn_evque.find(conn) != m_conn_evque.end() && 
-            m_conn_evque[conn].empty()){
-          m_conn_evque.erase(conn);
-          conn_inactive_empty.insert(conn);	
-        }
-      }
-      for(auto &conn: conn_inactive_empty){
-        m_conn_inactive.erase(conn);
+  void TriggerIDSyncDataCollector::BuildEvents(Builder &bd){
+    TriggerEventBuilder::Built built;
+    while(bd.builder.Pop(built)){
+      auto ev_sync = Event::MakeUnique("TriggerIDSyncOnline");
+      ev_sync->SetFlagPacket();
+      ev_sync->SetTriggerN(built.trigger_n);
+      for(auto &subev: built.evs)
+        ev_sync->AddSubEvent(subev);
+      if(!built.complete && bd.builder.GetIncompletePolicy() == TriggerEventBuilder::INCOMPLETE_TAG){
+        std::string missing;
+        for(auto &name: built.missing)
+          missing += (missing.empty() ? "" : ",") + name;
+        ev_sync->SetTag("EUDAQ_INCOMPLETE", missing);
       }
+      if(!m_noprint)
+        ev_sync->Print(std::cout);
+      WriteEvent(std::move(ev_sync));
     }
-    if(!m_noprint)
-      ev_sync->Print(std::cout);
-    WriteEvent(std::move(ev_sync));
   }
 }
@@ -17,12 +17,12 @@ bool Ex0RawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::StdEve
   size_t nblocks= ev->NumBlocks();
   auto block_n_list = ev->GetBlockNumList();
   for(auto &block_n: block_n_list){
-    std::vector<uint8_t> block = ev->GetBlock(block_n);
+    eudaq::BlockView block = ev->GetBlockView(block_n);
     if(block.size() < 2)
       EUDAQ_THROW("Unknown data");
     uint8_t x_pixel = block[0];
     uint8_t y_pixel = block[1];
-    std::vector<uint8_t> hit(block.begin()+2, block.end());
+    eudaq::BlockView hit(block.data()+2, block.size()-2);
     if(hit.size() != x_pixel*y_pixel)
       EUDAQ_THROW("Unknown data");
     eudaq::StandardPlane plane(block_n, "my_ex0_plane", "my_ex0_plane");
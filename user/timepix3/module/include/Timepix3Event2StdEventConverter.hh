@@ -9,16 +9,20 @@
 namespace eudaq {
   class Timepix3RawEvent2StdEventConverter: public eudaq::StdEventConverter{
   public:
+    Timepix3RawEvent2StdEventConverter();
     bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
+    // reads delta_t0 and loads the calibration files once
+    void Initialise(eudaq::ConfigurationSPC conf) override;
     static const uint32_t m_id_factory = eudaq::cstr2hash("Timepix3RawEvent");
   private:
-    static uint64_t m_syncTime;
-    static uint64_t m_syncTime_prev;
-    static uint64_t m_delta_t0;
-    static bool m_clearedHeader;
-    static bool m_first_time;
-    static std::vector<std::vector<float>> vtot;
-    static std::vector<std::vector<float>> vtoa;
+    //the state of the data stream of this converter, the converters are
+    //created once per thread
+    mutable uint64_t m_syncTime;
+    mutable uint64_t m_syncTime_prev;
+    mutable bool m_clearedHeader;
+    uint64_t m_delta_t0;
+    std::vector<std::vector<float>> vtot;
+    std::vector<std::vector<float>> vtoa;
 
     void loadCalibration(std::string path, char delim, std::vector<std::vector<float>>& dat) const;
   };
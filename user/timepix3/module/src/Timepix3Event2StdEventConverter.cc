@@ -22,7 +22,7 @@ bool Timepix3TrigEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::
 
   // Retrieve data from Block 0:
   uint64_t trigdata;
-  auto data = ev->GetBlock(0);
+  auto data = ev->GetBlockView(0);
   if(data.size() / sizeof(uint64_t) > 1) {
     EUDAQ_WARN("Ignoring packet " + std::to_string(ev->GetEventNumber()) + " with unexpected data");
     return false;
@@ -79,59 +79,54 @@ bool Timepix3TrigEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::
   return true;
 }
 
-uint64_t Timepix3RawEvent2StdEventConverter::m_syncTime(0);
-uint64_t Timepix3RawEvent2StdEventConverter::m_syncTime_prev(0);
-uint64_t Timepix3RawEvent2StdEventConverter::m_delta_t0(1e6);
-bool Timepix3RawEvent2StdEventConverter::m_clearedHeader(false);
-bool Timepix3RawEvent2StdEventConverter::m_first_time(true);
-std::vector<std::vector<float>> Timepix3RawEvent2StdEventConverter::vtot;
-std::vector<std::vector<float>> Timepix3RawEvent2StdEventConverter::vtoa;
+Timepix3RawEvent2StdEventConverter::Timepix3RawEvent2StdEventConverter()
+  : m_syncTime(0), m_syncTime_prev(0), m_clearedHeader(false), m_delta_t0(1e6) {}
 
-bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const{
+void Timepix3RawEvent2StdEventConverter::Initialise(eudaq::ConfigurationSPC conf) {
 
   // Read from configuration:
-  if(m_first_time) {
-      m_delta_t0 = (conf ? conf->Get("delta_t0", 1e6) : 1e6); // default: 1sec
+  m_delta_t0 = (conf ? conf->Get("delta_t0", 1e6) : 1e6); // default: 1sec
 
-      EUDAQ_INFO("Will detect 2nd T0 indirectly if timestamp jumps back by more than " + to_string(m_delta_t0) + "us.");
-      m_first_time = false;
+  EUDAQ_INFO("Will detect 2nd T0 indirectly if timestamp jumps back by more than " + to_string(m_delta_t0) + "us.");
 
-      if(conf && conf->Has("calibration_path_tot") && conf->Has("calibration_path_toa")) {
-          std::string calibrationPathToT = conf->Get("calibration_path_tot","");
-          std::string calibrationPathToA = conf->Get("calibration_path_toa","");
+  if(conf && conf->Has("calibration_path_tot") && conf->Has("calibration_path_toa")) {
+      std::string calibrationPathToT = conf->Get("calibration_path_tot","");
+      std::string calibrationPathToA = conf->Get("calibration_path_toa","");
 
-          if(calibrationPathToT.find("toa") != std::string::npos) {
-              throw DataInvalid("Timepix3: Parameter calibration_path_tot contains substring \"toa\", please update your configuration file!");
-          }
-          if(calibrationPathToA.find("tot") != std::string::npos) {
-              throw DataInvalid("Timepix3: Parameter calibration_path_toa contains substring \"tot\", please update your configuration file!");
+      if(calibrationPathToT.find("toa") != std::string::npos) {
+          throw DataInvalid("Timepix3: Parameter calibration_path_tot contains substring \"toa\", please update your configuration file!");
+      }
+      if(calibrationPathToA.find("tot") != std::string::npos) {
+          throw DataInvalid("Timepix3: Parameter calibration_path_toa contains substring \"tot\", please update your configuration file!");
+      }
+
+      EUDAQ_INFO("Applying ToT calibration from " + calibrationPathToT);
+      EUDAQ_INFO("Applying ToA calibration from " + calibrationPathToA);
+
+      std::string tmp;
+      loadCalibration(calibrationPathToT, ' ', vtot);
+      loadCalibration(calibrationPathToA, ' ', vtoa);
+
+      for(size_t row = 0; row < 256; row++) {
+          for(size_t col = 0; col < 256; col++) {
+              float a = vtot.at(256 * row + col).at(2);
+              float b = vtot.at(256 * row + col).at(3);
+              float c = vtot.at(256 * row + col).at(4);
+              float t = vtot.at(256 * row + col).at(5);
+              float toa_c = vtoa.at(256 * row + col).at(2);
+              float toa_t = vtoa.at(256 * row + col).at(3);
+              float toa_d = vtoa.at(256 * row + col).at(4);
+
+              double cold = static_cast<double>(col);
+              double rowd = static_cast<double>(row);
           }
+      }
+  } else {
+      EUDAQ_INFO("No calibration file path for ToT or ToA; data will be uncalibrated.");
+  }
+}
 
-          EUDAQ_INFO("Applying ToT calibration from " + calibrationPathToT);
-          EUDAQ_INFO("Applying ToA calibration from " + calibrationPathToA);
-
-          std::string tmp;
-          loadCalibration(calibrationPathToT, ' ', vtot);
-          loadCalibration(calibrationPathToA, ' ', vtoa);
-
-            for(size_t row = 0; row < 256; row++) {
-                for(size_t col = 0; col < 256; col++) {
-                    float a = vtot.at(256 * row + col).at(2);
-                    float b = vtot.at(256 * row + col).at(3);
-                    float c = vtot.at(256 * row + col).at(4);
-                    float t = vtot.at(256 * row + col).at(5);
-                    float toa_c = vtoa.at(256 * row + col).at(2);
-                    float toa_t = vtoa.at(256 * row + col).at(3);
-                    float toa_d = vtoa.at(256 * row + col).at(4);
-
-                    double cold = static_cast<double>(col);
-                    double rowd = static_cast<double>(row);
-                }
-            }
-        } else {
-            EUDAQ_INFO("No calibration file path for ToT or ToA; data will be uncalibrated.");
-        }
-    }
+bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC /*conf*/) const{
 
   bool data_found = false;
 
@@ -142,7 +137,7 @@ bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::S
 
   // Retrieve data from Block 0:
   std::vector<uint64_t> vpixdata;
-  auto data = ev->GetBlock(0);
+  auto data = ev->GetBlockView(0);
   vpixdata.resize(data.size() / sizeof(uint64_t));
   memcpy(&vpixdata[0], &data[0], data.size());
 
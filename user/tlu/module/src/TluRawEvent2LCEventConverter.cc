@@ -4,6 +4,7 @@
 class TluRawEvent2LCEventConverter: public eudaq::LCEventConverter{
 public:
   bool Converting(eudaq::EventSPC d1, eudaq::LCEventSP d2, eudaq::ConfigurationSPC conf) const override;
+  bool IsThreadSafe(eudaq::EventSPC) const override {return true;};
   static const uint32_t m_id_factory = eudaq::cstr2hash("TluRawDataEvent");
 };
   